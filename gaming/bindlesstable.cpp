@@ -0,0 +1,207 @@
+#include "bindlesstable.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+BindlessTable::BindlessTable(const VkCtx& ctx, size_t framesInFlight, uint32_t maxBuffers, uint32_t maxTextures)
+	: _descriptorLayout(VK_NULL_HANDLE),
+	_layout(VK_NULL_HANDLE),
+	_pool(VK_NULL_HANDLE),
+	_set(VK_NULL_HANDLE),
+	_maxBuffers(maxBuffers),
+	_maxTextures(maxTextures),
+	_nextBuffer(0),
+	_nextTexture(0),
+	_retiredBuffers(framesInFlight),
+	_retiredTextures(framesInFlight),
+	_frame(0)
+{
+	if (!ctx.features12().descriptorIndexing) {
+		throw std::runtime_error("Bindless table requires descriptor indexing");
+	}
+
+	// Every binding is visible to all stages, so the per-stage limits apply as well as the per-set ones. Combined
+	// image samplers count as both a sampled image and a sampler
+	VkPhysicalDeviceDescriptorIndexingProperties indexingProps = {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES,
+	};
+	VkPhysicalDeviceProperties2 props2 = {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+		.pNext = &indexingProps,
+	};
+	vkGetPhysicalDeviceProperties2(ctx.physicalDevice(), &props2);
+	maxBuffers = std::min({ maxBuffers,
+		indexingProps.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+		indexingProps.maxDescriptorSetUpdateAfterBindStorageBuffers,
+		indexingProps.maxPerStageUpdateAfterBindResources });
+	maxTextures = std::min({ maxTextures,
+		indexingProps.maxPerStageDescriptorUpdateAfterBindSampledImages,
+		indexingProps.maxPerStageDescriptorUpdateAfterBindSamplers,
+		indexingProps.maxDescriptorSetUpdateAfterBindSampledImages,
+		indexingProps.maxDescriptorSetUpdateAfterBindSamplers,
+		indexingProps.maxPerStageUpdateAfterBindResources - maxBuffers });
+	if (maxBuffers == 0 || maxTextures == 0) {
+		throw std::runtime_error("Bindless table does not fit the device's update-after-bind limits");
+	}
+	_maxBuffers = maxBuffers;
+	_maxTextures = maxTextures;
+
+	VkDescriptorSetLayoutBinding bindings[] = {
+		{
+			.binding = bufferBinding,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.descriptorCount = maxBuffers,
+			.stageFlags = VK_SHADER_STAGE_ALL,
+		},
+		{
+			.binding = textureBinding,
+			.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+			.descriptorCount = maxTextures,
+			.stageFlags = VK_SHADER_STAGE_ALL,
+		},
+	};
+
+	// Partially bound so unused slots may stay empty, update after bind so slots can be filled while the set is bound
+	VkDescriptorBindingFlags bindingFlags[] = {
+		VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT,
+		VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT,
+	};
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo = {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+		.bindingCount = 2,
+		.pBindingFlags = bindingFlags,
+	};
+
+	VkDescriptorSetLayoutCreateInfo descriptorLayoutInfo = {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+		.pNext = &flagsInfo,
+		.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+		.bindingCount = 2,
+		.pBindings = bindings,
+	};
+	CHK_ERR(vkCreateDescriptorSetLayout(ctx.device(), &descriptorLayoutInfo, nullptr, &_descriptorLayout));
+
+	VkPushConstantRange pushRange = {
+		.stageFlags = VK_SHADER_STAGE_ALL,
+		.offset = 0,
+		.size = sizeof(BindlessIndices),
+	};
+
+	VkPipelineLayoutCreateInfo layoutInfo = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+		.setLayoutCount = 1,
+		.pSetLayouts = &_descriptorLayout,
+		.pushConstantRangeCount = 1,
+		.pPushConstantRanges = &pushRange,
+	};
+	CHK_ERR(vkCreatePipelineLayout(ctx.device(), &layoutInfo, nullptr, &_layout));
+
+	VkDescriptorPoolSize sizes[] = {
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, maxBuffers },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, maxTextures },
+	};
+	VkDescriptorPoolCreateInfo poolInfo = {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+		.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+		.maxSets = 1,
+		.poolSizeCount = 2,
+		.pPoolSizes = sizes,
+	};
+	CHK_ERR(vkCreateDescriptorPool(ctx.device(), &poolInfo, nullptr, &_pool));
+
+	VkDescriptorSetAllocateInfo allocInfo = {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+		.descriptorPool = _pool,
+		.descriptorSetCount = 1,
+		.pSetLayouts = &_descriptorLayout,
+	};
+	CHK_ERR(vkAllocateDescriptorSets(ctx.device(), &allocInfo, &_set));
+}
+
+void BindlessTable::destroy(const VkCtx& ctx)
+{
+	vkDestroyDescriptorPool(ctx.device(), _pool, nullptr);
+	vkDestroyPipelineLayout(ctx.device(), _layout, nullptr);
+	vkDestroyDescriptorSetLayout(ctx.device(), _descriptorLayout, nullptr);
+}
+
+static uint32_t takeSlot(std::vector<uint32_t>& freeSlots, uint32_t& next, uint32_t max)
+{
+	if (!freeSlots.empty()) {
+		uint32_t slot = freeSlots.back();
+		freeSlots.pop_back();
+		return slot;
+	}
+	if (next >= max) {
+		throw std::runtime_error("Bindless table is full");
+	}
+	return next++;
+}
+
+uint32_t BindlessTable::addBuffer(const VkCtx& ctx, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+	uint32_t index = takeSlot(_freeBuffers, _nextBuffer, _maxBuffers);
+	VkDescriptorBufferInfo info = {
+		.buffer = buffer,
+		.offset = offset,
+		.range = range,
+	};
+	VkWriteDescriptorSet write = {
+		.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+		.dstSet = _set,
+		.dstBinding = bufferBinding,
+		.dstArrayElement = index,
+		.descriptorCount = 1,
+		.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		.pBufferInfo = &info,
+	};
+	vkUpdateDescriptorSets(ctx.device(), 1, &write, 0, nullptr);
+	return index;
+}
+
+uint32_t BindlessTable::addTexture(const VkCtx& ctx, VkImageView view, VkSampler sampler, VkImageLayout layout)
+{
+	uint32_t index = takeSlot(_freeTextures, _nextTexture, _maxTextures);
+	VkDescriptorImageInfo info = {
+		.sampler = sampler,
+		.imageView = view,
+		.imageLayout = layout,
+	};
+	VkWriteDescriptorSet write = {
+		.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+		.dstSet = _set,
+		.dstBinding = textureBinding,
+		.dstArrayElement = index,
+		.descriptorCount = 1,
+		.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+		.pImageInfo = &info,
+	};
+	vkUpdateDescriptorSets(ctx.device(), 1, &write, 0, nullptr);
+	return index;
+}
+
+void BindlessTable::removeBuffer(uint32_t index)
+{
+	_retiredBuffers[_frame].push_back(index);
+}
+
+void BindlessTable::removeTexture(uint32_t index)
+{
+	_retiredTextures[_frame].push_back(index);
+}
+
+void BindlessTable::beginFrame(size_t frameIndex)
+{
+	// Anything retired the last time this frame slot was used is no longer referenced by the GPU
+	_frame = frameIndex;
+	_freeBuffers.insert(_freeBuffers.end(), _retiredBuffers[frameIndex].begin(), _retiredBuffers[frameIndex].end());
+	_freeTextures.insert(_freeTextures.end(), _retiredTextures[frameIndex].begin(), _retiredTextures[frameIndex].end());
+	_retiredBuffers[frameIndex].clear();
+	_retiredTextures[frameIndex].clear();
+}
+
+void BindlessTable::bind(VkCommandBuffer buf, VkPipelineBindPoint bindPoint) const
+{
+	vkCmdBindDescriptorSets(buf, bindPoint, _layout, 0, 1, &_set, 0, nullptr);
+}
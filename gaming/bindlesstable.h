@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+
+#include "vkctx.h"
+
+// Indices pushed per draw to pick resources out of the bindless table, mirrored in shaders/bindless.vert
+struct BindlessIndices {
+	uint32_t camera;
+	uint32_t objects;
+	uint32_t object;
+	uint32_t material;
+};
+
+// One global descriptor set holding large update-after-bind arrays of every buffer and texture in use
+// Resources are referred to by their array index, so a frame binds the set once and draws change only push constants
+class BindlessTable {
+private:
+	VkDescriptorSetLayout _descriptorLayout;
+	VkPipelineLayout _layout;
+	VkDescriptorPool _pool;
+	VkDescriptorSet _set;
+	uint32_t _maxBuffers;
+	uint32_t _maxTextures;
+	uint32_t _nextBuffer;
+	uint32_t _nextTexture;
+	std::vector<uint32_t> _freeBuffers;
+	std::vector<uint32_t> _freeTextures;
+	// Released slots are only reused once every frame that could still read them has completed
+	std::vector<std::vector<uint32_t>> _retiredBuffers;
+	std::vector<std::vector<uint32_t>> _retiredTextures;
+	size_t _frame;
+public:
+	static constexpr uint32_t bufferBinding = 0;
+	static constexpr uint32_t textureBinding = 1;
+
+	// maxBuffers and maxTextures are clamped to the device's update-after-bind descriptor limits
+	BindlessTable(const VkCtx& ctx, size_t framesInFlight, uint32_t maxBuffers = 16384, uint32_t maxTextures = 4096);
+	void destroy(const VkCtx& ctx);
+
+	uint32_t addBuffer(const VkCtx& ctx, VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+	uint32_t addTexture(const VkCtx& ctx, VkImageView view, VkSampler sampler, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	void removeBuffer(uint32_t index);
+	void removeTexture(uint32_t index);
+	// Call once the fence for frameIndex has signalled
+	void beginFrame(size_t frameIndex);
+	void bind(VkCommandBuffer buf, VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS) const;
+
+	VkDescriptorSetLayout descriptorLayout() const { return _descriptorLayout; }
+	VkPipelineLayout layout() const { return _layout; }
+	VkDescriptorSet set() const { return _set; }
+};
@@ -0,0 +1,143 @@
+#include "clusteredlighting.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+#include <glm/glm.hpp>
+
+static constexpr uint32_t cullGroupSize = 64;
+
+GpuLight pointLight(const glm::vec3& position, float range, const glm::vec3& color, float intensity)
+{
+	return {
+		.positionRange = glm::vec4(position, range),
+		.colorIntensity = glm::vec4(color, intensity),
+		.direction = glm::vec4(0.0f, 0.0f, -1.0f, 0.0f),
+		.spot = glm::vec4(0.0f, 1.0f, 0.0f, 0.0f),
+	};
+}
+
+GpuLight spotLight(const glm::vec3& position, const glm::vec3& direction, float range, const glm::vec3& color, float intensity, float innerAngle, float outerAngle)
+{
+	float cosInner = std::cos(innerAngle);
+	float cosOuter = std::cos(outerAngle);
+	float scale = 1.0f / std::max(cosInner - cosOuter, 1e-4f);
+	return {
+		.positionRange = glm::vec4(position, range),
+		.colorIntensity = glm::vec4(color, intensity),
+		.direction = glm::vec4(glm::normalize(direction), 0.0f),
+		.spot = glm::vec4(scale, -cosOuter * scale, 0.0f, 0.0f),
+	};
+}
+
+// The same set is written by the cull pass and read by lit fragments
+static VkDescriptorSetLayout createLightingSetLayout(const VkCtx& ctx)
+{
+	VkDescriptorSetLayoutBinding bindings[4];
+	for (uint32_t i = 0; i < 4; i++) {
+		bindings[i] = {
+			.binding = i,
+			.descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC
+				: i == 3 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.descriptorCount = 1,
+			.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+		};
+	}
+	VkDescriptorSetLayoutCreateInfo descriptorLayoutInfo = {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+		.bindingCount = 4,
+		.pBindings = bindings,
+	};
+	VkDescriptorSetLayout descriptorLayout;
+	CHK_ERR(vkCreateDescriptorSetLayout(ctx.device(), &descriptorLayoutInfo, nullptr, &descriptorLayout));
+	return descriptorLayout;
+}
+
+static VkPipelineLayout createSetsLayout(const VkCtx& ctx, std::span<const VkDescriptorSetLayout> sets)
+{
+	VkPipelineLayoutCreateInfo info = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+		.setLayoutCount = (uint32_t)sets.size(),
+		.pSetLayouts = sets.data(),
+	};
+	VkPipelineLayout layout;
+	CHK_ERR(vkCreatePipelineLayout(ctx.device(), &info, nullptr, &layout));
+	return layout;
+}
+
+ClusteredLighting::ClusteredLighting(const VkCtx& ctx, DescriptorAllocator& descriptors, const ShaderModule& cullShader, const DefaultLayout& layout, size_t frames, uint32_t maxLights)
+	: _lightBuffer(ctx, frames, maxLights),
+	_uniform(ctx, frames),
+	_clusterCounts(ctx, clusterCount * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT),
+	_clusterLights(ctx, clusterCount * maxLightsPerCluster * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT),
+	_descriptorLayout(createLightingSetLayout(ctx)),
+	_cullLayout(createSetsLayout(ctx, std::array{ _descriptorLayout })),
+	_layout(createSetsLayout(ctx, std::array{ layout.descriptorLayout(), _descriptorLayout })),
+	_set(descriptors.allocate(ctx, _descriptorLayout)),
+	_cull(ctx, _cullLayout, cullShader),
+	_maxLights(maxLights),
+	_lightCount(0)
+{
+	DescriptorBindings()
+		.buffer(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, _lightBuffer.buffer(), 0, _lightBuffer.range())
+		.buffer(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _clusterCounts.buffer())
+		.buffer(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _clusterLights.buffer())
+		.buffer(3, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, _uniform.buffer(), 0, sizeof(ClusterUniform))
+		.write(ctx, _set);
+}
+
+void ClusteredLighting::destroy(const VkCtx& ctx)
+{
+	_cull.destroy(ctx);
+	vkDestroyPipelineLayout(ctx.device(), _layout, nullptr);
+	vkDestroyPipelineLayout(ctx.device(), _cullLayout, nullptr);
+	vkDestroyDescriptorSetLayout(ctx.device(), _descriptorLayout, nullptr);
+}
+
+void ClusteredLighting::cull(VkCommandBuffer buf, size_t frame, std::span<const GpuLight> lights, const glm::mat4& view, const glm::mat4& proj,
+	VkExtent2D extent, float near, float far)
+{
+	_lightCount = (uint32_t)std::min<size_t>(lights.size(), _maxLights);
+	memcpy(_lightBuffer.data(frame), lights.data(), _lightCount * sizeof(GpuLight));
+
+	// slice = log(z) * scale + bias maps [near, far] onto [0, gridZ]
+	float logRatio = std::log(far / near);
+	ClusterUniform uniform = {
+		.view = view,
+		.invProj = glm::inverse(proj),
+		.screenSize = glm::vec2((float)extent.width, (float)extent.height),
+		.tileSize = glm::vec2(std::ceil((float)extent.width / gridX), std::ceil((float)extent.height / gridY)),
+		.sliceScale = gridZ / logRatio,
+		.sliceBias = -(float)gridZ * std::log(near) / logRatio,
+		.lightCount = _lightCount,
+	};
+	_uniform.write(frame, uniform);
+
+	// The previous frame's fragments may still be reading the grid
+	VkMemoryBarrier readDone = {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.srcAccessMask = 0,
+		.dstAccessMask = 0,
+	};
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &readDone, 0, nullptr, 0, nullptr);
+
+	uint32_t offsets[] = { _lightBuffer.offset(frame), _uniform.offset(frame) };
+	vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_COMPUTE, _cull.pipeline());
+	vkCmdBindDescriptorSets(buf, VK_PIPELINE_BIND_POINT_COMPUTE, _cullLayout, 0, 1, &_set, 2, offsets);
+	vkCmdDispatch(buf, (clusterCount + cullGroupSize - 1) / cullGroupSize, 1, 1);
+
+	VkMemoryBarrier written = {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+	};
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &written, 0, nullptr, 0, nullptr);
+}
+
+void ClusteredLighting::bind(VkCommandBuffer buf, size_t frame) const
+{
+	uint32_t offsets[] = { _lightBuffer.offset(frame), _uniform.offset(frame) };
+	vkCmdBindDescriptorSets(buf, VK_PIPELINE_BIND_POINT_GRAPHICS, _layout, 1, 1, &_set, 2, offsets);
+}
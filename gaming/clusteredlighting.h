@@ -0,0 +1,82 @@
+#pragma once
+
+#include <span>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+#include "vkctx.h"
+#include "vkbuffer.h"
+#include "computeshader.h"
+#include "defaultlayout.h"
+#include "descriptorallocator.h"
+
+// Matches Light in shaders/cluster_lights.comp and shaders/clustered.glsl (std430)
+// Spot falloff is saturate(dot(-L, direction) * spot.x + spot.y)^2, a point light has scale 0 and offset 1
+struct GpuLight {
+	// xyz world position, w range where the light reaches zero
+	glm::vec4 positionRange;
+	// rgb color, w intensity
+	glm::vec4 colorIntensity;
+	glm::vec4 direction;
+	glm::vec4 spot;
+};
+
+GpuLight pointLight(const glm::vec3& position, float range, const glm::vec3& color, float intensity);
+// Angles are half angles in radians, full intensity inside innerAngle and none outside outerAngle
+GpuLight spotLight(const glm::vec3& position, const glm::vec3& direction, float range, const glm::vec3& color, float intensity, float innerAngle, float outerAngle);
+
+// Clustered forward lighting: every frame a compute pass bins the lights into a froxel grid of screen tiles
+// and exponential depth slices, and the lit fragment shader only loops over its cluster's lights
+// so shading cost follows the lights touching a pixel instead of the lights in the scene
+// Lit pipelines use layout() with shaders/lit.vert and shaders/lit.frag, set 0 is the TransformPath::Instanced
+// DefaultLayout set and set 1 is bound by bind()
+class ClusteredLighting {
+public:
+	static constexpr uint32_t gridX = 16;
+	static constexpr uint32_t gridY = 9;
+	static constexpr uint32_t gridZ = 24;
+	static constexpr uint32_t clusterCount = gridX * gridY * gridZ;
+	// Lights past this in one cluster are dropped
+	static constexpr uint32_t maxLightsPerCluster = 128;
+private:
+	// Matches ClusterUniform in the shaders (std140)
+	struct ClusterUniform {
+		glm::mat4 view;
+		glm::mat4 invProj;
+		glm::vec2 screenSize;
+		glm::vec2 tileSize;
+		float sliceScale;
+		float sliceBias;
+		uint32_t lightCount;
+	};
+
+	FrameStorageBuffer<GpuLight> _lightBuffer;
+	FrameUniformBuffer<ClusterUniform> _uniform;
+	DeviceBuffer _clusterCounts;
+	DeviceBuffer _clusterLights;
+	VkDescriptorSetLayout _descriptorLayout;
+	VkPipelineLayout _cullLayout;
+	VkPipelineLayout _layout;
+	VkDescriptorSet _set;
+	ComputeShader _cull;
+	uint32_t _maxLights;
+	uint32_t _lightCount;
+public:
+	ClusteredLighting(const VkCtx& ctx, DescriptorAllocator& descriptors, const ShaderModule& cullShader, const DefaultLayout& layout, size_t frames, uint32_t maxLights = 1024);
+	void destroy(const VkCtx& ctx);
+
+	// Uploads the frame's lights and bins them, must be outside a render pass
+	// near and far are the projection's planes, depth slices are spaced exponentially between them
+	void cull(VkCommandBuffer buf, size_t frame, std::span<const GpuLight> lights, const glm::mat4& view, const glm::mat4& proj,
+		VkExtent2D extent, float near, float far);
+	// Binds the lighting set at set 1 for lit draws
+	void bind(VkCommandBuffer buf, size_t frame) const;
+
+	VkPipelineLayout layout() const { return _layout; }
+	// The set 1 layout, pipeline layouts that share layout()'s first two sets can be bound with bind()
+	VkDescriptorSetLayout descriptorLayout() const { return _descriptorLayout; }
+	uint32_t lightCount() const { return _lightCount; }
+};
@@ -0,0 +1,180 @@
+#include "clusterscene.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "frustum.h"
+
+static constexpr uint32_t cullGroupSize = 64;
+
+static VkPipelineLayout createClusterCullLayout(const VkCtx& ctx, VkDescriptorSetLayout& descriptorLayout)
+{
+	VkDescriptorSetLayoutBinding bindings[6];
+	for (uint32_t i = 0; i < 4; i++) {
+		bindings[i] = {
+			.binding = i,
+			// Inputs are per frame regions of one buffer, outputs are shared and protected by barriers
+			.descriptorType = i < 2 ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.descriptorCount = 1,
+			.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+		};
+	}
+	bindings[4] = {
+		.binding = 4,
+		.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+		.descriptorCount = 1,
+		.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+	};
+	bindings[5] = {
+		.binding = 5,
+		.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+		.descriptorCount = 1,
+		.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+	};
+	VkDescriptorSetLayoutCreateInfo descriptorLayoutInfo = {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+		.bindingCount = 6,
+		.pBindings = bindings,
+	};
+	CHK_ERR(vkCreateDescriptorSetLayout(ctx.device(), &descriptorLayoutInfo, nullptr, &descriptorLayout));
+
+	VkPipelineLayoutCreateInfo info = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+		.setLayoutCount = 1,
+		.pSetLayouts = &descriptorLayout,
+	};
+	VkPipelineLayout layout;
+	CHK_ERR(vkCreatePipelineLayout(ctx.device(), &info, nullptr, &layout));
+	return layout;
+}
+
+ClusterScene::ClusterScene(const VkCtx& ctx, DescriptorAllocator& descriptors, const ShaderModule& cullShader, HiZPyramid& hiz, size_t frames, size_t maxClusters, size_t maxInstances)
+	: _frameDirty(frames, true),
+	_clusterBuffer(ctx, frames, maxClusters),
+	_instanceBuffer(ctx, frames, maxInstances),
+	_uniform(ctx, frames),
+	_commandBuffer(ctx, maxClusters * sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT),
+	_countBuffer(ctx, sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT),
+	_hiz(hiz),
+	_descriptorLayout(VK_NULL_HANDLE),
+	_layout(createClusterCullLayout(ctx, _descriptorLayout)),
+	_set(descriptors.allocate(ctx, _descriptorLayout)),
+	_cull(ctx, _layout, cullShader),
+	_maxClusters(maxClusters),
+	_maxInstances(maxInstances)
+{
+	if (!ctx.supportsIndirectCount()) {
+		throw std::runtime_error("Cluster scene needs indirect count draws, which the device does not support");
+	}
+	if (!ctx.supportsSubgroupOps(VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_BALLOT_BIT)) {
+		throw std::runtime_error("Cluster scene culling needs subgroup ballot in compute shaders");
+	}
+	DescriptorBindings()
+		.buffer(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, _clusterBuffer.buffer(), 0, _clusterBuffer.range())
+		.buffer(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, _instanceBuffer.buffer(), 0, _instanceBuffer.range())
+		.buffer(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _commandBuffer.buffer())
+		.buffer(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _countBuffer.buffer())
+		.image(4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, hiz.view(), hiz.sampler(), VK_IMAGE_LAYOUT_GENERAL)
+		.buffer(5, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, _uniform.buffer(), 0, sizeof(CullUniform))
+		.write(ctx, _set);
+}
+
+void ClusterScene::destroy(const VkCtx& ctx)
+{
+	_cull.destroy(ctx);
+	vkDestroyPipelineLayout(ctx.device(), _layout, nullptr);
+	vkDestroyDescriptorSetLayout(ctx.device(), _descriptorLayout, nullptr);
+}
+
+uint32_t ClusterScene::addInstance(const InstanceData& instance)
+{
+	if (_instances.size() >= _maxInstances) {
+		throw std::runtime_error("Cluster scene instances are full");
+	}
+	_instances.push_back(instance);
+	std::fill(_frameDirty.begin(), _frameDirty.end(), true);
+	return (uint32_t)_instances.size() - 1;
+}
+
+void ClusterScene::updateInstance(uint32_t index, const InstanceData& instance)
+{
+	_instances[index] = instance;
+	std::fill(_frameDirty.begin(), _frameDirty.end(), true);
+}
+
+void ClusterScene::addMeshlets(std::span<const Meshlet> meshlets, uint32_t instance, int32_t vertexOffset, uint32_t firstIndex)
+{
+	if (_clusters.size() + meshlets.size() > _maxClusters) {
+		throw std::runtime_error("Cluster scene is full");
+	}
+	for (const Meshlet& meshlet : meshlets) {
+		_clusters.push_back({
+			.sphere = meshlet.sphere,
+			.cone = meshlet.cone,
+			.firstIndex = firstIndex + meshlet.firstIndex,
+			.indexCount = meshlet.indexCount,
+			.vertexOffset = vertexOffset,
+			.instance = instance,
+		});
+	}
+	std::fill(_frameDirty.begin(), _frameDirty.end(), true);
+}
+
+void ClusterScene::cull(VkCommandBuffer buf, size_t frame, const glm::mat4& viewProj, const glm::vec3& camera)
+{
+	if (_frameDirty[frame]) {
+		memcpy(_clusterBuffer.data(frame), _clusters.data(), _clusters.size() * sizeof(GpuCluster));
+		memcpy(_instanceBuffer.data(frame), _instances.data(), _instances.size() * sizeof(InstanceData));
+		_frameDirty[frame] = false;
+	}
+
+	CullUniform uniform;
+	Frustum frustum = extractFrustum(viewProj);
+	for (int i = 0; i < 6; i++) {
+		uniform.planes[i] = frustum.planes[i];
+	}
+	uniform.viewProj = viewProj;
+	uniform.camera = glm::vec4(camera, 1.0f);
+	VkExtent2D depth = _hiz.depthExtent();
+	uniform.depthSize = glm::vec2((float)depth.width, (float)depth.height);
+	uniform.clusterCount = (uint32_t)_clusters.size();
+	uniform.pad = 0;
+	_uniform.write(frame, uniform);
+	_hiz.prepare(buf);
+
+	// The previous frame's indirect draw may still be reading the outputs
+	VkMemoryBarrier readDone = {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.srcAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+		.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+	};
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &readDone, 0, nullptr, 0, nullptr);
+
+	vkCmdFillBuffer(buf, _countBuffer.buffer(), 0, sizeof(uint32_t), 0);
+	VkMemoryBarrier cleared = {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+	};
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &cleared, 0, nullptr, 0, nullptr);
+
+	uint32_t offsets[] = { _clusterBuffer.offset(frame), _instanceBuffer.offset(frame), _uniform.offset(frame) };
+	vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_COMPUTE, _cull.pipeline());
+	vkCmdBindDescriptorSets(buf, VK_PIPELINE_BIND_POINT_COMPUTE, _layout, 0, 1, &_set, 3, offsets);
+	vkCmdDispatch(buf, (uniform.clusterCount + cullGroupSize - 1) / cullGroupSize, 1, 1);
+
+	VkMemoryBarrier written = {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+	};
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &written, 0, nullptr, 0, nullptr);
+}
+
+void ClusterScene::draw(VkCommandBuffer buf, const DefaultLayout& layout, VkDescriptorSet set, size_t frame, uint32_t cameraOffset) const
+{
+	uint32_t offsets[] = { cameraOffset, _instanceBuffer.offset(frame) };
+	vkCmdBindDescriptorSets(buf, VK_PIPELINE_BIND_POINT_GRAPHICS, layout.layout(), 0, 1, &set, 2, offsets);
+	vkCmdDrawIndexedIndirectCount(buf, _commandBuffer.buffer(), 0, _countBuffer.buffer(), 0, (uint32_t)_maxClusters, sizeof(VkDrawIndexedIndirectCommand));
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+#include "vkctx.h"
+#include "vkbuffer.h"
+#include "computeshader.h"
+#include "defaultlayout.h"
+#include "descriptorallocator.h"
+#include "hizpyramid.h"
+#include "meshformat.h"
+
+// Matches Cluster in shaders/cluster_cull.comp, one meshlet of one instance
+struct GpuCluster {
+	glm::vec4 sphere;
+	glm::vec4 cone;
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	int32_t vertexOffset;
+	uint32_t instance;
+};
+
+// Meshlet granularity GPU culling for large meshes: every cluster is tested against the frustum, its normal cone
+// and the depth pyramid, and survivors are compacted into indirect draws of their index ranges
+// Drawn through the regular vertex pipeline (TransformPath::Instanced), no mesh shaders needed
+// The pyramid test uses this frame's camera, so cull belongs after HiZPyramid::build and the draw in
+// WindowSwapchain::secondPhasePass, with the occluders drawn in the first phase
+class ClusterScene {
+private:
+	// Matches CullUniform in shaders/cluster_cull.comp (std140)
+	struct CullUniform {
+		glm::vec4 planes[6];
+		glm::mat4 viewProj;
+		glm::vec4 camera;
+		glm::vec2 depthSize;
+		uint32_t clusterCount;
+		uint32_t pad;
+	};
+
+	std::vector<GpuCluster> _clusters;
+	std::vector<InstanceData> _instances;
+	std::vector<bool> _frameDirty;
+	FrameStorageBuffer<GpuCluster> _clusterBuffer;
+	FrameStorageBuffer<InstanceData> _instanceBuffer;
+	FrameUniformBuffer<CullUniform> _uniform;
+	DeviceBuffer _commandBuffer;
+	DeviceBuffer _countBuffer;
+	HiZPyramid& _hiz;
+	VkDescriptorSetLayout _descriptorLayout;
+	VkPipelineLayout _layout;
+	VkDescriptorSet _set;
+	ComputeShader _cull;
+	size_t _maxClusters;
+	size_t _maxInstances;
+public:
+	// Throws when the device lacks indirect count draws, see VkCtx::supportsIndirectCount
+	ClusterScene(const VkCtx& ctx, DescriptorAllocator& descriptors, const ShaderModule& cullShader, HiZPyramid& hiz, size_t frames, size_t maxClusters, size_t maxInstances);
+	void destroy(const VkCtx& ctx);
+
+	// The instance's model matrix may scale, but only uniformly for the cone test to hold
+	uint32_t addInstance(const InstanceData& instance);
+	void updateInstance(uint32_t index, const InstanceData& instance);
+	// Adds every meshlet of a mesh drawn by instance, firstIndex and vertexOffset locate the mesh in the shared buffers
+	void addMeshlets(std::span<const Meshlet> meshlets, uint32_t instance, int32_t vertexOffset, uint32_t firstIndex = 0);
+
+	// Records the cluster culling dispatch, must be outside a render pass
+	void cull(VkCommandBuffer buf, size_t frame, const glm::mat4& viewProj, const glm::vec3& camera);
+	// Draws every surviving cluster, the shared vertex/index buffers and a TransformPath::Instanced pipeline must be bound
+	// set must have instanceBuffer() bound at binding 1
+	void draw(VkCommandBuffer buf, const DefaultLayout& layout, VkDescriptorSet set, size_t frame, uint32_t cameraOffset) const;
+
+	VkBuffer instanceBuffer() const { return _instanceBuffer.buffer(); }
+	VkDeviceSize instanceRange() const { return _instanceBuffer.range(); }
+	size_t clusterCount() const { return _clusters.size(); }
+};
\ No newline at end of file
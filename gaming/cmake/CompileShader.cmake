@@ -0,0 +1,34 @@
+# Compiles a single GLSL kernel to SPIR-V.
+# Invoked as a script from the shader custom commands so the build type can decide the flags:
+#   Debug builds keep debug info (-g) for RenderDoc and the validation layers
+#   Everything else is compiled with -O and, when spirv-opt is available, run through its optimizer
+#
+# Expected definitions: GLSLC, INPUT, OUTPUT, OPTIMIZE, and optionally SPIRV_OPT and SPIRV_OPT_FLAGS
+
+if(NOT OPTIMIZE)
+	execute_process(COMMAND ${GLSLC} ${INPUT} -g -o ${OUTPUT} RESULT_VARIABLE result)
+	if(result)
+		message(FATAL_ERROR "glslc failed on ${INPUT}")
+	endif()
+	return()
+endif()
+
+if(NOT SPIRV_OPT)
+	execute_process(COMMAND ${GLSLC} ${INPUT} -O -o ${OUTPUT} RESULT_VARIABLE result)
+	if(result)
+		message(FATAL_ERROR "glslc failed on ${INPUT}")
+	endif()
+	return()
+endif()
+
+execute_process(COMMAND ${GLSLC} ${INPUT} -O -o ${OUTPUT}.unopt RESULT_VARIABLE result)
+if(result)
+	message(FATAL_ERROR "glslc failed on ${INPUT}")
+endif()
+
+string(REPLACE "|" ";" SPIRV_OPT_FLAGS "${SPIRV_OPT_FLAGS}")
+execute_process(COMMAND ${SPIRV_OPT} ${SPIRV_OPT_FLAGS} --strip-debug ${OUTPUT}.unopt -o ${OUTPUT} RESULT_VARIABLE result)
+if(result)
+	message(FATAL_ERROR "spirv-opt failed on ${INPUT}")
+endif()
+file(REMOVE ${OUTPUT}.unopt)
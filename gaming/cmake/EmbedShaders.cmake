@@ -0,0 +1,44 @@
+# Packs every compiled SPIR-V module into a single C++ translation unit so the executable
+# carries its shaders with it and ShaderModule never touches the filesystem.
+# All modules share one word-aligned archive array, the table records where each one starts.
+#
+# Expected definitions: OUTPUT, BINARY_DIR and SHADERS ('|' separated, relative to BINARY_DIR)
+
+string(REPLACE "|" ";" SHADERS "${SHADERS}")
+
+set(archive "")
+set(table "")
+set(offset 0)
+foreach(SHADER ${SHADERS})
+	file(READ "${BINARY_DIR}/${SHADER}" hex HEX)
+	string(LENGTH "${hex}" hexLength)
+	math(EXPR words "${hexLength} / 8")
+	math(EXPR bytes "${hexLength} / 2")
+	# SPIR-V is a stream of little endian 32 bit words
+	string(REGEX REPLACE "([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])" "0x\\4\\3\\2\\1u," hex "${hex}")
+	set(word "0x[0-9a-f]+u,")
+	string(REGEX REPLACE "(${word}${word}${word}${word}${word}${word}${word}${word})" "\\1\n\t" hex "${hex}")
+	string(APPEND archive "\t// ${SHADER}\n\t${hex}\n")
+	string(APPEND table "\t{ \"${SHADER}\", archive + ${offset}, ${bytes} },\n")
+	math(EXPR offset "${offset} + ${words}")
+endforeach()
+
+file(WRITE "${OUTPUT}.tmp"
+"// Generated by cmake/EmbedShaders.cmake, do not edit
+#include \"shaderarchive.h\"
+
+namespace {
+alignas(4) const uint32_t archive[] = {
+${archive}};
+
+const EmbeddedShader shaders[] = {
+${table}};
+}
+
+std::span<const EmbeddedShader> embeddedShaders() {
+	return shaders;
+}
+")
+# Only touch the real output when something changed to avoid needless recompiles
+execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different "${OUTPUT}.tmp" "${OUTPUT}")
+file(REMOVE "${OUTPUT}.tmp")
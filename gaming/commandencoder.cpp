@@ -0,0 +1,89 @@
+#include "commandencoder.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+CommandEncoder::CommandEncoder(VkCommandBuffer buf)
+	: _buf(buf),
+	_stats{}
+{
+	invalidate();
+}
+
+void CommandEncoder::invalidate()
+{
+	_pipeline = VK_NULL_HANDLE;
+	_layout = VK_NULL_HANDLE;
+	_set = VK_NULL_HANDLE;
+	_dynamicOffsetCount = 0;
+	_vertexBuffer = VK_NULL_HANDLE;
+	_vertexOffset = 0;
+	_indexBuffer = VK_NULL_HANDLE;
+	_indexType = VK_INDEX_TYPE_UINT32;
+}
+
+void CommandEncoder::bindPipeline(VkPipeline pipeline)
+{
+	if (pipeline == _pipeline) {
+		_stats.redundant++;
+		return;
+	}
+	vkCmdBindPipeline(_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+	_pipeline = pipeline;
+	_stats.pipelines++;
+}
+
+void CommandEncoder::bindDescriptorSet(VkPipelineLayout layout, VkDescriptorSet set, std::span<const uint32_t> dynamicOffsets)
+{
+	if (dynamicOffsets.size() > maxDynamicOffsets) {
+		throw std::runtime_error("Too many dynamic offsets");
+	}
+	if (layout == _layout && set == _set && dynamicOffsets.size() == _dynamicOffsetCount
+		&& std::equal(dynamicOffsets.begin(), dynamicOffsets.end(), _dynamicOffsets)) {
+		_stats.redundant++;
+		return;
+	}
+	vkCmdBindDescriptorSets(_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1, &set, (uint32_t)dynamicOffsets.size(), dynamicOffsets.data());
+	_layout = layout;
+	_set = set;
+	_dynamicOffsetCount = (uint32_t)dynamicOffsets.size();
+	std::copy(dynamicOffsets.begin(), dynamicOffsets.end(), _dynamicOffsets);
+	_stats.descriptorSets++;
+}
+
+void CommandEncoder::bindVertexBuffer(VkBuffer buffer, VkDeviceSize offset)
+{
+	if (buffer == _vertexBuffer && offset == _vertexOffset) {
+		_stats.redundant++;
+		return;
+	}
+	vkCmdBindVertexBuffers(_buf, 0, 1, &buffer, &offset);
+	_vertexBuffer = buffer;
+	_vertexOffset = offset;
+	_stats.vertexBuffers++;
+}
+
+void CommandEncoder::bindIndexBuffer(VkBuffer buffer, VkIndexType type)
+{
+	if (buffer == _indexBuffer && type == _indexType) {
+		_stats.redundant++;
+		return;
+	}
+	vkCmdBindIndexBuffer(_buf, buffer, 0, type);
+	_indexBuffer = buffer;
+	_indexType = type;
+	_stats.indexBuffers++;
+}
+
+void CommandEncoder::drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance)
+{
+	vkCmdDrawIndexed(_buf, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+	_stats.draws++;
+}
+
+void CommandEncoder::drawMesh(const Mesh& mesh, uint32_t instanceCount, uint32_t firstInstance)
+{
+	bindVertexBuffer(mesh.vertexBuffer);
+	bindIndexBuffer(mesh.indexBuffer, mesh.indexType);
+	drawIndexed(mesh.indexCount, instanceCount, mesh.firstIndex, mesh.vertexOffset, firstInstance);
+}
\ No newline at end of file
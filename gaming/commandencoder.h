@@ -0,0 +1,53 @@
+#pragma once
+
+#include <span>
+
+#include "vkctx.h"
+#include "mesh.h"
+
+// Binds issued and skipped by a CommandEncoder
+struct BindStats {
+	uint32_t pipelines;
+	uint32_t descriptorSets;
+	uint32_t vertexBuffers;
+	uint32_t indexBuffers;
+	uint32_t draws;
+	// Binds dropped because the same state was already bound
+	uint32_t redundant;
+};
+
+// Records graphics commands into a command buffer, remembering what is bound so repeated binds are dropped
+// Anything recorded around the encoder that changes bound state must be followed by invalidate()
+class CommandEncoder {
+public:
+	static constexpr uint32_t maxDynamicOffsets = 4;
+private:
+	VkCommandBuffer _buf;
+	VkPipeline _pipeline;
+	VkPipelineLayout _layout;
+	VkDescriptorSet _set;
+	uint32_t _dynamicOffsets[maxDynamicOffsets];
+	uint32_t _dynamicOffsetCount;
+	VkBuffer _vertexBuffer;
+	VkDeviceSize _vertexOffset;
+	VkBuffer _indexBuffer;
+	VkIndexType _indexType;
+	BindStats _stats;
+public:
+	explicit CommandEncoder(VkCommandBuffer buf);
+
+	void bindPipeline(VkPipeline pipeline);
+	// Set 0 of layout, dynamicOffsets holds at most maxDynamicOffsets entries
+	void bindDescriptorSet(VkPipelineLayout layout, VkDescriptorSet set, std::span<const uint32_t> dynamicOffsets = {});
+	void bindVertexBuffer(VkBuffer buffer, VkDeviceSize offset = 0);
+	void bindIndexBuffer(VkBuffer buffer, VkIndexType type);
+	void drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance);
+	// Binds the mesh's buffers and draws its index range
+	void drawMesh(const Mesh& mesh, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
+
+	// Forgets all bound state, the next bind of each kind is always recorded
+	void invalidate();
+
+	VkCommandBuffer commandBuffer() const { return _buf; }
+	const BindStats& stats() const { return _stats; }
+};
\ No newline at end of file
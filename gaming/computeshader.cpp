@@ -0,0 +1,24 @@
+#include "computeshader.h"
+
+ComputeShader::ComputeShader(const VkCtx& ctx, VkPipelineLayout layout, const ShaderModule& shader, const VkSpecializationInfo* specialization)
+	: _pipeline(VK_NULL_HANDLE)
+{
+	VkComputePipelineCreateInfo info = {
+		.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+		.stage = {
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+			.stage = VK_SHADER_STAGE_COMPUTE_BIT,
+			.module = shader.shaderModule(),
+			.pName = "main",
+			.pSpecializationInfo = specialization,
+		},
+		.layout = layout,
+	};
+
+	CHK_ERR(vkCreateComputePipelines(ctx.device(), nullptr, 1, &info, nullptr, &_pipeline));
+}
+
+void ComputeShader::destroy(const VkCtx& ctx)
+{
+	vkDestroyPipeline(ctx.device(), _pipeline, nullptr);
+}
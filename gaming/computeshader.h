@@ -0,0 +1,15 @@
+#pragma once
+
+#include "vkctx.h"
+#include "shadermodule.h"
+
+// A compute pipeline, the layout is owned by whichever pass uses it
+class ComputeShader {
+private:
+	VkPipeline _pipeline;
+public:
+	ComputeShader(const VkCtx& ctx, VkPipelineLayout layout, const ShaderModule& shader, const VkSpecializationInfo* specialization = nullptr);
+	void destroy(const VkCtx& ctx);
+
+	VkPipeline pipeline() const { return _pipeline; }
+};
\ No newline at end of file
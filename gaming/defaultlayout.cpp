@@ -1,28 +1,48 @@
 #include "defaultlayout.h"
 
+#include <cassert>
+
 #include "defaultvertex.h"
 
-DefaultLayout::DefaultLayout(const VkCtx& ctx) 
-	: _layout(VK_NULL_HANDLE)
+DefaultLayout::DefaultLayout(const VkCtx& ctx, TransformPath path) 
+	: _layout(VK_NULL_HANDLE),
+	_path(path)
 {
-	VkDescriptorSetLayoutBinding uniformBinding = {
-		.binding = 0,
-		.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
-		.descriptorCount = 1,
-		.stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+	// Every path uses a dynamic uniform, per draw for DynamicUniform and per frame slot for the others
+	VkDescriptorSetLayoutBinding bindings[] = {
+		{
+			.binding = 0,
+			.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+			.descriptorCount = 1,
+			.stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+		},
+		{
+			.binding = 1,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
+			.descriptorCount = 1,
+			.stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+		},
 	};
 
 	VkDescriptorSetLayoutCreateInfo descriptorLayoutInfo = {
 		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-		.bindingCount = 1,
-		.pBindings = &uniformBinding,
+		.bindingCount = path == TransformPath::Instanced ? 2u : 1u,
+		.pBindings = bindings,
 	};
 	CHK_ERR(vkCreateDescriptorSetLayout(ctx.device(), &descriptorLayoutInfo, nullptr, &_descriptorLayout));
 
+	VkPushConstantRange pushRange = {
+		.stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+		.offset = 0,
+		.size = sizeof(ObjectPushConstants),
+	};
+
 	VkPipelineLayoutCreateInfo info = {
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
 		.setLayoutCount = 1,
 		.pSetLayouts = &_descriptorLayout,
+		.pushConstantRangeCount = path == TransformPath::PushConstant ? 1u : 0u,
+		.pPushConstantRanges = &pushRange,
 	};
 	CHK_ERR(vkCreatePipelineLayout(ctx.device(), &info, nullptr, &_layout));
 }
@@ -32,3 +52,10 @@ void DefaultLayout::destroy(const VkCtx& ctx)
 	vkDestroyPipelineLayout(ctx.device(), _layout, nullptr);
 	vkDestroyDescriptorSetLayout(ctx.device(), _descriptorLayout, nullptr);
 }
+
+void DefaultLayout::pushTransform(VkCommandBuffer buf, const glm::mat4& model) const
+{
+	assert(_path == TransformPath::PushConstant);
+	ObjectPushConstants constants = { model };
+	vkCmdPushConstants(buf, _layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(constants), &constants);
+}
@@ -2,13 +2,31 @@
 
 #include "vkctx.h"
 
+#include <glm/mat4x4.hpp>
+
+// How per object transforms reach the vertex shader
+enum class TransformPath {
+	// Full UniformBufferObject per object, selected with a dynamic offset on every draw (shaders/default.vert)
+	DynamicUniform,
+	// Model matrix in push constants, view/projection in a CameraUniform bound once per frame (shaders/default_push.vert)
+	PushConstant,
+	// Many instances per draw, each reads its InstanceData from a storage buffer with gl_InstanceIndex (shaders/instanced.vert)
+	Instanced,
+};
+
 class DefaultLayout {
 private:
 	VkDescriptorSetLayout _descriptorLayout;
 	VkPipelineLayout _layout;
+	TransformPath _path;
 public:
-	DefaultLayout(const VkCtx& ctx);
+	DefaultLayout(const VkCtx& ctx, TransformPath path = TransformPath::DynamicUniform);
 	void destroy(const VkCtx& ctx);
 
+	// Only valid for TransformPath::PushConstant
+	void pushTransform(VkCommandBuffer buf, const glm::mat4& model) const;
+
 	VkPipelineLayout layout() const { return _layout; }
+	VkDescriptorSetLayout descriptorLayout() const { return _descriptorLayout; }
+	TransformPath transformPath() const { return _path; }
 };
\ No newline at end of file
@@ -1,8 +1,37 @@
 #include "defaultshader.h"
-#include "defaultvertex.h"
 
-DefaultShader::DefaultShader(const VkCtx& ctx, const DefaultLayout& layout, const ShaderModule& vertexShader, const ShaderModule& fragmentShader, VkRenderPass renderPass)
+#include <vector>
+
+DefaultShader::DefaultShader(const VkCtx& ctx, const DefaultLayout& layout, const ShaderModule& vertexShader, const ShaderModule& fragmentShader, VkRenderPass renderPass, const VertexInput& input, DepthMode depth, BlendMode blend)
+	: DefaultShader(ctx, layout.layout(), vertexShader, fragmentShader, renderPass, input, depth, blend)
+{
+}
+
+DefaultShader::DefaultShader(const VkCtx& ctx, VkPipelineLayout layout, const ShaderModule& vertexShader, const ShaderModule& fragmentShader, VkRenderPass renderPass, const VertexInput& input, DepthMode depth, BlendMode blend)
+	: _pipeline(VK_NULL_HANDLE)
+{
+	create(ctx, layout, vertexShader, &fragmentShader, renderPass, 0, 1, input, depth, blend);
+}
+
+DefaultShader::DefaultShader(const VkCtx& ctx, VkPipelineLayout layout, const ShaderModule& vertexShader, const ShaderModule& fragmentShader, VkRenderPass renderPass,
+	uint32_t subpass, uint32_t colorAttachments, const VertexInput& input, DepthMode depth)
 	: _pipeline(VK_NULL_HANDLE)
+{
+	create(ctx, layout, vertexShader, &fragmentShader, renderPass, subpass, colorAttachments, input, depth, BlendMode::Opaque);
+}
+
+DefaultShader::DefaultShader(const VkCtx& ctx, const DefaultLayout& layout, const ShaderModule& vertexShader, VkRenderPass renderPass, const VertexInput& input)
+	: DefaultShader(ctx, layout.layout(), vertexShader, renderPass, input)
+{
+}
+
+DefaultShader::DefaultShader(const VkCtx& ctx, VkPipelineLayout layout, const ShaderModule& vertexShader, VkRenderPass renderPass, const VertexInput& input)
+	: _pipeline(VK_NULL_HANDLE)
+{
+	create(ctx, layout, vertexShader, nullptr, renderPass, 0, 1, input, DepthMode::DepthOnly, BlendMode::Opaque);
+}
+
+void DefaultShader::create(const VkCtx& ctx, VkPipelineLayout layout, const ShaderModule& vertexShader, const ShaderModule* fragmentShader, VkRenderPass renderPass, uint32_t subpass, uint32_t colorAttachments, const VertexInput& input, DepthMode depth, BlendMode blend)
 {
 	VkPipelineShaderStageCreateInfo vertexShaderInfo = {
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
@@ -11,48 +40,22 @@ DefaultShader::DefaultShader(const VkCtx& ctx, const DefaultLayout& layout, cons
 		.pName = "main",
 	};
 
-	VkPipelineShaderStageCreateInfo fragmentShaderInfo = {
-		.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-		.stage = VK_SHADER_STAGE_FRAGMENT_BIT,
-		.module = fragmentShader.shaderModule(),
-		.pName = "main",
-	};
-
-	VkPipelineShaderStageCreateInfo shaderStages[] = { vertexShaderInfo, fragmentShaderInfo };
-
-	VkVertexInputBindingDescription vertexBindingDesc = {
-		.binding = 0,
-		.stride = sizeof(DefaultVertex),
-		.inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
-	};
-
-	VkVertexInputAttributeDescription vertexAttributes[] = {
-		{
-			.location = 0,
-			.binding = 0,
-			.format = VK_FORMAT_R32G32B32_SFLOAT,
-			.offset = offsetof(DefaultVertex, pos),
-		},
-		{
-			.location = 1,
-			.binding = 0,
-			.format = VK_FORMAT_R32G32B32_SFLOAT,
-			.offset = offsetof(DefaultVertex, normal),
-		},
-		{
-			.location = 2,
-			.binding = 0,
-			.format = VK_FORMAT_R32G32B32_SFLOAT,
-			.offset = offsetof(DefaultVertex, color),
-		},
-	};
+	VkPipelineShaderStageCreateInfo shaderStages[] = { vertexShaderInfo, {} };
+	if (fragmentShader) {
+		shaderStages[1] = {
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+			.stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+			.module = fragmentShader->shaderModule(),
+			.pName = "main",
+		};
+	}
 
 	VkPipelineVertexInputStateCreateInfo vertexInput = {
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-		.vertexBindingDescriptionCount = 1,
-		.pVertexBindingDescriptions = &vertexBindingDesc,
-		.vertexAttributeDescriptionCount = 3,
-		.pVertexAttributeDescriptions = vertexAttributes,
+		.vertexBindingDescriptionCount = input.attributes.empty() ? 0u : 1u,
+		.pVertexBindingDescriptions = &input.binding,
+		.vertexAttributeDescriptionCount = (uint32_t)input.attributes.size(),
+		.pVertexAttributeDescriptions = input.attributes.data(),
 	};
 
 	VkPipelineInputAssemblyStateCreateInfo assemblyInfo = {
@@ -80,7 +83,7 @@ DefaultShader::DefaultShader(const VkCtx& ctx, const DefaultLayout& layout, cons
 		.depthClampEnable = false,
 		.rasterizerDiscardEnable = false,
 		.polygonMode = VK_POLYGON_MODE_FILL,
-		.cullMode = VK_CULL_MODE_BACK_BIT,
+		.cullMode = blend == BlendMode::Opaque ? (VkCullModeFlags)VK_CULL_MODE_BACK_BIT : (VkCullModeFlags)VK_CULL_MODE_NONE,
 		.frontFace = VK_FRONT_FACE_CLOCKWISE,
 		.lineWidth = 1.0f,
 	};
@@ -93,22 +96,32 @@ DefaultShader::DefaultShader(const VkCtx& ctx, const DefaultLayout& layout, cons
 	VkPipelineDepthStencilStateCreateInfo depthStencilInfo = {
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
 		.depthTestEnable = true,
-		.depthWriteEnable = true,
+		.depthWriteEnable = depth != DepthMode::Equal && depth != DepthMode::ReadOnly,
+		.depthCompareOp = depth == DepthMode::Equal ? VK_COMPARE_OP_EQUAL : VK_COMPARE_OP_LESS,
 		.minDepthBounds = 0.0f,
 		.maxDepthBounds = 1.0f,
 	};
 
 	VkPipelineColorBlendAttachmentState colorBlendAttachment = {
-		.blendEnable = false,
-		.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
+		.blendEnable = blend != BlendMode::Opaque,
+		.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
+		.dstColorBlendFactor = blend == BlendMode::Alpha ? VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA : VK_BLEND_FACTOR_ONE,
+		.colorBlendOp = VK_BLEND_OP_ADD,
+		.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+		.dstAlphaBlendFactor = blend == BlendMode::Alpha ? VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA : VK_BLEND_FACTOR_ONE,
+		.alphaBlendOp = VK_BLEND_OP_ADD,
+		// The prepass leaves color to the shaded pass
+		.colorWriteMask = depth == DepthMode::DepthOnly ? 0u : VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
 	};
 
+	std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachments(colorAttachments, colorBlendAttachment);
+
 	VkPipelineColorBlendStateCreateInfo colorBlendState = {
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
 		.logicOpEnable = false,
 		.logicOp = VK_LOGIC_OP_COPY,
-		.attachmentCount = 1,
-		.pAttachments = &colorBlendAttachment,
+		.attachmentCount = colorAttachments,
+		.pAttachments = colorBlendAttachments.data(),
 	};
 
 	VkDynamicState dynamicStates[] = {
@@ -124,7 +137,7 @@ DefaultShader::DefaultShader(const VkCtx& ctx, const DefaultLayout& layout, cons
 
 	VkGraphicsPipelineCreateInfo graphicsPipelineInfo = {
 		.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-		.stageCount = 2,
+		.stageCount = fragmentShader ? 2u : 1u,
 		.pStages = shaderStages,
 		.pVertexInputState = &vertexInput,
 		.pInputAssemblyState = &assemblyInfo,
@@ -134,9 +147,9 @@ DefaultShader::DefaultShader(const VkCtx& ctx, const DefaultLayout& layout, cons
 		.pDepthStencilState = &depthStencilInfo,
 		.pColorBlendState = &colorBlendState,
 		.pDynamicState = &dynamicStateInfo,
-		.layout = layout.layout(),
+		.layout = layout,
 		.renderPass = renderPass,
-		.subpass = 0,
+		.subpass = subpass,
 	};
 
 	CHK_ERR(vkCreateGraphicsPipelines(ctx.device(), nullptr, 1, &graphicsPipelineInfo, nullptr, &_pipeline));
@@ -3,12 +3,45 @@
 #include "vkctx.h"
 #include "shadermodule.h"
 #include "defaultlayout.h"
+#include "vertexformat.h"
+
+// Depth state of a pipeline, depth is 0 at the near plane
+enum class DepthMode {
+	// Test LESS and write, the single pass default
+	ReadWrite,
+	// Test LESS and write with no fragment stage and no color writes, for a depth prepass
+	DepthOnly,
+	// Test EQUAL without writing, for shading on top of a depth prepass so every pixel is shaded once
+	Equal,
+	// Test LESS without writing, for blended geometry
+	ReadOnly,
+};
+
+// Color blending of a pipeline, blended pipelines draw both faces
+enum class BlendMode {
+	Opaque,
+	// Source over, draws must be sorted back to front
+	Alpha,
+	// Color scaled by alpha added on top, order independent, for emissive effects
+	Additive,
+};
 
 class DefaultShader {
 private:
 	VkPipeline _pipeline;
+
+	void create(const VkCtx& ctx, VkPipelineLayout layout, const ShaderModule& vertexShader, const ShaderModule* fragmentShader, VkRenderPass renderPass, uint32_t subpass, uint32_t colorAttachments, const VertexInput& input, DepthMode depth, BlendMode blend);
 public:
-	DefaultShader(const VkCtx& ctx, const DefaultLayout& layout, const ShaderModule& vertexShader, const ShaderModule& fragmentShader, VkRenderPass renderPass);
+	DefaultShader(const VkCtx& ctx, const DefaultLayout& layout, const ShaderModule& vertexShader, const ShaderModule& fragmentShader, VkRenderPass renderPass, const VertexInput& input = vertexInput<DefaultVertex>(), DepthMode depth = DepthMode::ReadWrite, BlendMode blend = BlendMode::Opaque);
+	DefaultShader(const VkCtx& ctx, VkPipelineLayout layout, const ShaderModule& vertexShader, const ShaderModule& fragmentShader, VkRenderPass renderPass, const VertexInput& input = vertexInput<DefaultVertex>(), DepthMode depth = DepthMode::ReadWrite, BlendMode blend = BlendMode::Opaque);
+	// Depth only pipeline (DepthMode::DepthOnly), the vertex shader must compute gl_Position exactly like the shaded
+	// pass's and both must declare it invariant for the EQUAL test to pass
+	DefaultShader(const VkCtx& ctx, const DefaultLayout& layout, const ShaderModule& vertexShader, VkRenderPass renderPass, const VertexInput& input = vertexInput<PositionVertex>());
+	DefaultShader(const VkCtx& ctx, VkPipelineLayout layout, const ShaderModule& vertexShader, VkRenderPass renderPass, const VertexInput& input = vertexInput<PositionVertex>());
+	// Pipeline for a later subpass or one writing several color attachments (WindowSwapchain::deferredPass)
+	// Input with no attributes draws without vertex buffers, the vertex shader generates positions from gl_VertexIndex
+	DefaultShader(const VkCtx& ctx, VkPipelineLayout layout, const ShaderModule& vertexShader, const ShaderModule& fragmentShader, VkRenderPass renderPass,
+		uint32_t subpass, uint32_t colorAttachments, const VertexInput& input = vertexInput<DefaultVertex>(), DepthMode depth = DepthMode::ReadWrite);
 	void destroy(const VkCtx& ctx);
 
 	VkPipeline pipeline() const { return _pipeline; }
@@ -13,4 +13,30 @@ struct UniformBufferObject {
 	glm::mat4 model;
 	glm::mat4 view;
 	glm::mat4 projection;
+};
+
+// Per frame data for layouts that push transforms, bound once per frame
+struct CameraUniform {
+	glm::mat4 view;
+	glm::mat4 projection;
+};
+
+// Views rendered by one multiview pass, four view-projections fill one 256 byte FrameUniformBuffer slot
+constexpr uint32_t maxMultiviewViews = 4;
+
+// Per frame data for shaders/instanced_multiview.vert, indexed by gl_ViewIndex
+struct MultiviewCameraUniform {
+	glm::mat4 viewProj[maxMultiviewViews];
+};
+
+// Per instance data for TransformPath::Instanced, tightly packed in a storage buffer (std430)
+// color.a is the LOD crossfade coverage read by shaders/lod.frag, 1 when not fading
+struct InstanceData {
+	glm::mat4 model;
+	glm::vec4 color;
+};
+
+// Per draw data for TransformPath::PushConstant, 64 bytes fits the guaranteed 128 byte push constant budget
+struct ObjectPushConstants {
+	glm::mat4 model;
 };
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include "deferredrenderer.h"
+
+#include <array>
+
+#include <glm/glm.hpp>
+
+static VkDescriptorSetLayout createGBufferSetLayout(const VkCtx& ctx)
+{
+	VkDescriptorSetLayoutBinding bindings[4];
+	for (uint32_t i = 0; i < 4; i++) {
+		bindings[i] = {
+			.binding = i,
+			.descriptorType = i == 3 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT,
+			.descriptorCount = 1,
+			.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+		};
+	}
+	VkDescriptorSetLayoutCreateInfo descriptorLayoutInfo = {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+		.bindingCount = 4,
+		.pBindings = bindings,
+	};
+	VkDescriptorSetLayout descriptorLayout;
+	CHK_ERR(vkCreateDescriptorSetLayout(ctx.device(), &descriptorLayoutInfo, nullptr, &descriptorLayout));
+	return descriptorLayout;
+}
+
+static VkPipelineLayout createLightLayout(const VkCtx& ctx, const DefaultLayout& layout, const ClusteredLighting& lighting, VkDescriptorSetLayout gbuffer)
+{
+	VkDescriptorSetLayout sets[] = { layout.descriptorLayout(), lighting.descriptorLayout(), gbuffer };
+	VkPipelineLayoutCreateInfo info = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+		.setLayoutCount = 3,
+		.pSetLayouts = sets,
+	};
+	VkPipelineLayout pipelineLayout;
+	CHK_ERR(vkCreatePipelineLayout(ctx.device(), &info, nullptr, &pipelineLayout));
+	return pipelineLayout;
+}
+
+DeferredRenderer::DeferredRenderer(const VkCtx& ctx, DescriptorAllocator& descriptors, const DefaultLayout& layout, const ClusteredLighting& lighting,
+	const WindowSwapchain& swap, const ShaderModule& litVertex, const ShaderModule& gbufferFragment,
+	const ShaderModule& fullscreenVertex, const ShaderModule& deferredFragment, size_t frames)
+	: _uniform(ctx, frames),
+	_descriptorLayout(createGBufferSetLayout(ctx)),
+	_lightLayout(createLightLayout(ctx, layout, lighting, _descriptorLayout)),
+	_set(descriptors.allocate(ctx, _descriptorLayout)),
+	_geometry(ctx, layout.layout(), litVertex, gbufferFragment, swap.deferredPass(), 0, 2),
+	// Subpass 1 has no depth attachment so the depth state is ignored
+	_light(ctx, _lightLayout, fullscreenVertex, deferredFragment, swap.deferredPass(), 1, 1, noVertexInput)
+{
+	DescriptorBindings()
+		.image(0, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, swap.gbufferView(0), VK_NULL_HANDLE, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+		.image(1, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, swap.gbufferView(1), VK_NULL_HANDLE, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+		.image(2, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, swap.gbufferView(2), VK_NULL_HANDLE, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL)
+		.buffer(3, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, _uniform.buffer(), 0, sizeof(GBufferUniform))
+		.write(ctx, _set);
+}
+
+void DeferredRenderer::destroy(const VkCtx& ctx)
+{
+	_light.destroy(ctx);
+	_geometry.destroy(ctx);
+	vkDestroyPipelineLayout(ctx.device(), _lightLayout, nullptr);
+	vkDestroyDescriptorSetLayout(ctx.device(), _descriptorLayout, nullptr);
+}
+
+void DeferredRenderer::begin(VkCommandBuffer buf, const WindowSwapchain& swap, uint32_t imageIndex, size_t frame, const glm::mat4& view, const glm::mat4& proj)
+{
+	_uniform.write(frame, { .invViewProj = glm::inverse(proj * view) });
+
+	// Swapchain color, depth, albedo and normal
+	VkClearValue clearValues[4] = {};
+	clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+	clearValues[1].depthStencil = { 1.0f, 0 };
+
+	VkExtent2D extent = swap.extent();
+	VkRenderPassBeginInfo beginInfo = {
+		.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+		.renderPass = swap.deferredPass(),
+		.framebuffer = swap.deferredFramebuffer(imageIndex),
+		.renderArea = { { 0, 0 }, extent },
+		.clearValueCount = 4,
+		.pClearValues = clearValues,
+	};
+	vkCmdBeginRenderPass(buf, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	VkViewport viewport = { 0.0f, 0.0f, (float)extent.width, (float)extent.height, 0.0f, 1.0f };
+	VkRect2D scissor = { { 0, 0 }, extent };
+	vkCmdSetViewport(buf, 0, 1, &viewport);
+	vkCmdSetScissor(buf, 0, 1, &scissor);
+	vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_GRAPHICS, _geometry.pipeline());
+}
+
+void DeferredRenderer::light(VkCommandBuffer buf, size_t frame, const ClusteredLighting& lighting) const
+{
+	vkCmdNextSubpass(buf, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_GRAPHICS, _light.pipeline());
+	// Bound through ClusteredLighting::layout(), which agrees with the light layout on sets 0 and 1
+	lighting.bind(buf, frame);
+	uint32_t offset = _uniform.offset(frame);
+	vkCmdBindDescriptorSets(buf, VK_PIPELINE_BIND_POINT_GRAPHICS, _lightLayout, 2, 1, &_set, 1, &offset);
+	vkCmdDraw(buf, 3, 1, 0, 0);
+}
+
+void DeferredRenderer::end(VkCommandBuffer buf) const
+{
+	vkCmdEndRenderPass(buf);
+}
\ No newline at end of file
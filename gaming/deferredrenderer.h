@@ -0,0 +1,54 @@
+#pragma once
+
+#include <glm/mat4x4.hpp>
+
+#include "vkctx.h"
+#include "vkbuffer.h"
+#include "defaultshader.h"
+#include "defaultlayout.h"
+#include "descriptorallocator.h"
+#include "clusteredlighting.h"
+#include "windowswapchain.h"
+
+// How lit geometry is shaded, chosen per frame
+enum class RenderPath {
+	// Lit pipelines on ClusteredLighting::layout() inside WindowSwapchain::renderPass()
+	Forward,
+	// DeferredRenderer inside WindowSwapchain::deferredPass()
+	Deferred,
+};
+
+// Deferred shading in a single render pass: subpass 0 rasterizes albedo, normal and depth into the swapchain's
+// transient G-buffer and subpass 1 reads them back as input attachments and shades a fullscreen triangle with
+// the same clustered light lists as the forward path, so the G-buffer never has to leave tile memory
+// The geometry subpass draws the TransformPath::Instanced scene with shaders/lit.vert and shaders/gbuffer.frag,
+// set 0 is bound through the DefaultLayout as on the forward path
+class DeferredRenderer {
+private:
+	// Matches GBufferUniform in shaders/deferred.frag (std140)
+	struct GBufferUniform {
+		glm::mat4 invViewProj;
+	};
+
+	FrameUniformBuffer<GBufferUniform> _uniform;
+	VkDescriptorSetLayout _descriptorLayout;
+	// Set 0 and 1 match ClusteredLighting::layout(), set 2 is the G-buffer
+	VkPipelineLayout _lightLayout;
+	VkDescriptorSet _set;
+	DefaultShader _geometry;
+	DefaultShader _light;
+public:
+	// Both lighting and swap must outlive the renderer, the set reads swap's G-buffer views
+	DeferredRenderer(const VkCtx& ctx, DescriptorAllocator& descriptors, const DefaultLayout& layout, const ClusteredLighting& lighting,
+		const WindowSwapchain& swap, const ShaderModule& litVertex, const ShaderModule& gbufferFragment,
+		const ShaderModule& fullscreenVertex, const ShaderModule& deferredFragment, size_t frames);
+	void destroy(const VkCtx& ctx);
+
+	// Begins the deferred pass on the swapchain image and binds the geometry pipeline, draw the scene after this
+	void begin(VkCommandBuffer buf, const WindowSwapchain& swap, uint32_t imageIndex, size_t frame, const glm::mat4& view, const glm::mat4& proj);
+	// Moves to the lighting subpass and shades every covered pixel, lighting must have been culled this frame
+	void light(VkCommandBuffer buf, size_t frame, const ClusteredLighting& lighting) const;
+	void end(VkCommandBuffer buf) const;
+
+	VkPipeline geometryPipeline() const { return _geometry.pipeline(); }
+};
\ No newline at end of file
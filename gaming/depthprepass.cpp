@@ -0,0 +1,62 @@
+#include "depthprepass.h"
+
+DepthPrepassSelector::DepthPrepassSelector(const Settings& settings)
+	: _settings(settings),
+	_enabled(false),
+	_probing(false),
+	_frames(0),
+	_total(),
+	_samples()
+{
+	reset(false);
+}
+
+void DepthPrepassSelector::clearSamples()
+{
+	_total[0] = _total[1] = 0.0;
+	_samples[0] = _samples[1] = 0;
+}
+
+void DepthPrepassSelector::reset(bool enabled)
+{
+	_enabled = enabled;
+	_probing = false;
+	clearSamples();
+	// Measure the current mode for probeFrames and then try the other one right away
+	_frames = _settings.probeInterval > _settings.probeFrames ? _settings.probeInterval - _settings.probeFrames : 0;
+}
+
+bool DepthPrepassSelector::beginFrame()
+{
+	_frames++;
+	if (!_probing && _frames >= _settings.probeInterval) {
+		_probing = true;
+		_frames = 0;
+	} else if (_probing && (_samples[!_enabled] >= _settings.probeFrames || _frames >= 4 * _settings.probeFrames)) {
+		// Compare the fresh probe with the current mode's samples, then start a new interval
+		// Gives up after a while without measurements (no timestamp support) and keeps the current mode
+		double current = average(_enabled);
+		double other = average(!_enabled);
+		if (current >= 0.0 && other >= 0.0 && other < current * (1.0 - _settings.hysteresis)) {
+			_enabled = !_enabled;
+		}
+		_probing = false;
+		_frames = 0;
+		clearSamples();
+	}
+	return _probing ? !_enabled : _enabled;
+}
+
+void DepthPrepassSelector::record(bool prepass, double milliseconds)
+{
+	if (milliseconds < 0.0) {
+		return;
+	}
+	_total[prepass] += milliseconds;
+	_samples[prepass]++;
+}
+
+double DepthPrepassSelector::average(bool prepass) const
+{
+	return _samples[prepass] ? _total[prepass] / _samples[prepass] : -1.0;
+}
\ No newline at end of file
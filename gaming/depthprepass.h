@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+// Decides per scene whether to render a depth prepass, from measured GPU time of the scene's passes
+// With the prepass every visible pixel is shaded once (DepthMode::Equal) at the cost of transforming the geometry
+// twice, which only pays off with enough overdraw and expensive fragments, so both modes are measured
+// The prepass and shaded draws go in the same subpass, rasterization order makes the prepass depth visible to the
+// EQUAL test without a barrier:
+//   bind DefaultShader(DepthOnly) and the positionStream buffers, draw everything
+//   bind DefaultShader(..., DepthMode::Equal) and the full vertex buffers, draw everything again
+// Without the prepass the ReadWrite pipelines are drawn once
+class DepthPrepassSelector {
+public:
+	struct Settings {
+		// Frames spent in the current mode before trying the other one again
+		uint32_t probeInterval;
+		// Frames measured in each mode before comparing
+		uint32_t probeFrames;
+		// Relative improvement needed to switch, keeps noise from flipping the mode every probe
+		float hysteresis;
+	};
+private:
+	Settings _settings;
+	bool _enabled;
+	bool _probing;
+	uint32_t _frames;
+	// Indexed by whether the measurement had the prepass
+	double _total[2];
+	uint32_t _samples[2];
+
+	void clearSamples();
+public:
+	DepthPrepassSelector(const Settings& settings = { 600, 30, 0.05f });
+
+	// Starts over for a new scene, the last choice is usually the best first guess
+	void reset(bool enabled);
+	// Whether the frame being recorded should use the prepass, call once per frame before record
+	bool beginFrame();
+	// GPU milliseconds of a measured frame's scene passes (GpuTimer), prepass is whether that frame used it
+	// Timings arrive frames late, so they are filed under the mode they were measured with
+	void record(bool prepass, double milliseconds);
+
+	bool enabled() const { return _enabled; }
+	bool probing() const { return _probing; }
+	// Average of the current measurements for a mode, negative without samples
+	double average(bool prepass) const;
+};
\ No newline at end of file
@@ -0,0 +1,297 @@
+#include "descriptorallocator.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+
+// Number of descriptors of each type reserved per set in a pool
+static constexpr struct {
+	VkDescriptorType type;
+	float ratio;
+} poolRatios[] = {
+	{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f },
+	{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f },
+	{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4.0f },
+	{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.0f },
+	{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f },
+	{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1.0f },
+	{ VK_DESCRIPTOR_TYPE_SAMPLER, 0.5f },
+	{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f },
+	{ VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 0.5f },
+};
+
+DescriptorAllocator::DescriptorAllocator(uint32_t setsPerPool, VkDescriptorPoolCreateFlags flags)
+	: _currentPool(VK_NULL_HANDLE),
+	_setsPerPool(setsPerPool),
+	_flags(flags)
+{
+}
+
+VkDescriptorPool DescriptorAllocator::nextPool(const VkCtx& ctx)
+{
+	VkDescriptorPool pool = VK_NULL_HANDLE;
+	if (!_freePools.empty()) {
+		pool = _freePools.back();
+		_freePools.pop_back();
+	}
+	else {
+		VkDescriptorPoolSize sizes[std::size(poolRatios)];
+		for (size_t i = 0; i < std::size(poolRatios); i++) {
+			sizes[i] = {
+				.type = poolRatios[i].type,
+				.descriptorCount = (uint32_t)(poolRatios[i].ratio * _setsPerPool) + 1,
+			};
+		}
+		VkDescriptorPoolCreateInfo info = {
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+			.flags = _flags,
+			.maxSets = _setsPerPool,
+			.poolSizeCount = (uint32_t)std::size(sizes),
+			.pPoolSizes = sizes,
+		};
+		CHK_ERR(vkCreateDescriptorPool(ctx.device(), &info, nullptr, &pool));
+	}
+	_usedPools.push_back(pool);
+	return pool;
+}
+
+VkDescriptorSet DescriptorAllocator::allocate(const VkCtx& ctx, VkDescriptorSetLayout layout)
+{
+	VkDescriptorSet set = VK_NULL_HANDLE;
+	allocate(ctx, layout, std::span<VkDescriptorSet>(&set, 1));
+	return set;
+}
+
+void DescriptorAllocator::allocate(const VkCtx& ctx, VkDescriptorSetLayout layout, std::span<VkDescriptorSet> sets)
+{
+	size_t done = 0;
+	// A batch never asks for more sets than a fresh pool can hold, it shrinks further when the layout needs more
+	// descriptors of some type per set than the pool ratios reserve
+	uint32_t batch = _setsPerPool;
+	bool fresh = false;
+	while (done < sets.size()) {
+		if (_currentPool == VK_NULL_HANDLE) {
+			_currentPool = nextPool(ctx);
+			fresh = true;
+		}
+		uint32_t count = (uint32_t)std::min<size_t>(sets.size() - done, batch);
+		std::vector<VkDescriptorSetLayout> layouts(count, layout);
+		VkDescriptorSetAllocateInfo info = {
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+			.descriptorPool = _currentPool,
+			.descriptorSetCount = count,
+			.pSetLayouts = layouts.data(),
+		};
+		VkResult err = vkAllocateDescriptorSets(ctx.device(), &info, sets.data() + done);
+		if (err == VK_ERROR_OUT_OF_POOL_MEMORY || err == VK_ERROR_FRAGMENTED_POOL) {
+			if (!fresh) {
+				// Current pool is exhausted, retry the batch from a new one
+				_currentPool = VK_NULL_HANDLE;
+				continue;
+			}
+			if (count == 1) {
+				throw std::runtime_error("Descriptor set layout needs more descriptors than a whole pool holds");
+			}
+			// Even an empty pool can't fit the batch, retry half of it from the same pool
+			batch = count / 2;
+			continue;
+		}
+		CHK_ERR(err);
+		done += count;
+		fresh = false;
+	}
+}
+
+void DescriptorAllocator::reset(const VkCtx& ctx)
+{
+	for (VkDescriptorPool pool : _usedPools) {
+		CHK_ERR(vkResetDescriptorPool(ctx.device(), pool, 0));
+		_freePools.push_back(pool);
+	}
+	_usedPools.clear();
+	_currentPool = VK_NULL_HANDLE;
+}
+
+void DescriptorAllocator::destroy(const VkCtx& ctx)
+{
+	for (VkDescriptorPool pool : _usedPools) {
+		vkDestroyDescriptorPool(ctx.device(), pool, nullptr);
+	}
+	for (VkDescriptorPool pool : _freePools) {
+		vkDestroyDescriptorPool(ctx.device(), pool, nullptr);
+	}
+	_usedPools.clear();
+	_freePools.clear();
+	_currentPool = VK_NULL_HANDLE;
+}
+
+TransientDescriptors::TransientDescriptors(size_t frameCount)
+	: _currentFrame(0)
+{
+	for (size_t i = 0; i < frameCount; i++) {
+		_frames.push_back(std::make_unique<Frame>());
+	}
+}
+
+uint32_t TransientDescriptors::registerLayout(VkDescriptorSetLayout layout, uint32_t initialCapacity)
+{
+	for (auto& frame : _frames) {
+		auto slab = std::make_unique<Slab>();
+		slab->layout = layout;
+		slab->next = 0;
+		slab->highWater = initialCapacity;
+		frame->slabs.push_back(std::move(slab));
+	}
+	return (uint32_t)_frames[0]->slabs.size() - 1;
+}
+
+void TransientDescriptors::beginFrame(const VkCtx& ctx, size_t frameIndex)
+{
+	_currentFrame = frameIndex;
+	Frame& frame = *_frames[frameIndex];
+	frame.allocator.reset(ctx);
+	for (auto& slab : frame.slabs) {
+		// Grow to whatever the last use of this frame needed so the overflow path is only hit once
+		slab->highWater = std::max(slab->highWater, slab->next.load(std::memory_order_relaxed));
+		slab->sets.resize(slab->highWater);
+		frame.allocator.allocate(ctx, slab->layout, slab->sets);
+		slab->next.store(0, std::memory_order_relaxed);
+	}
+}
+
+VkDescriptorSet TransientDescriptors::allocate(const VkCtx& ctx, uint32_t layoutHandle)
+{
+	Frame& frame = *_frames[_currentFrame];
+	Slab& slab = *frame.slabs[layoutHandle];
+	uint32_t i = slab.next.fetch_add(1, std::memory_order_relaxed);
+	if (i < slab.sets.size()) {
+		return slab.sets[i];
+	}
+	// Slab exhausted, fall back to allocating individually, next use of this frame reserves enough
+	std::lock_guard<std::mutex> lock(_overflowMutex);
+	return frame.allocator.allocate(ctx, slab.layout);
+}
+
+void TransientDescriptors::destroy(const VkCtx& ctx)
+{
+	for (auto& frame : _frames) {
+		frame->allocator.destroy(ctx);
+	}
+}
+
+DescriptorBindings& DescriptorBindings::buffer(uint32_t binding, VkDescriptorType type, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+	_bindings.push_back({
+		.binding = binding,
+		.type = type,
+		.buffer = { .buffer = buffer, .offset = offset, .range = range },
+		.image = {},
+	});
+	return *this;
+}
+
+DescriptorBindings& DescriptorBindings::image(uint32_t binding, VkDescriptorType type, VkImageView view, VkSampler sampler, VkImageLayout layout)
+{
+	_bindings.push_back({
+		.binding = binding,
+		.type = type,
+		.buffer = {},
+		.image = { .sampler = sampler, .imageView = view, .imageLayout = layout },
+	});
+	return *this;
+}
+
+static void hashCombine(size_t& seed, uint64_t v)
+{
+	seed ^= std::hash<uint64_t>{}(v) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+}
+
+size_t DescriptorBindings::hash() const
+{
+	size_t h = 0;
+	for (const Binding& b : _bindings) {
+		hashCombine(h, b.binding);
+		hashCombine(h, b.type);
+		hashCombine(h, (uint64_t)b.buffer.buffer);
+		hashCombine(h, b.buffer.offset);
+		hashCombine(h, b.buffer.range);
+		hashCombine(h, (uint64_t)b.image.sampler);
+		hashCombine(h, (uint64_t)b.image.imageView);
+		hashCombine(h, b.image.imageLayout);
+	}
+	return h;
+}
+
+bool DescriptorBindings::operator==(const DescriptorBindings& o) const
+{
+	if (_bindings.size() != o._bindings.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < _bindings.size(); i++) {
+		const Binding& a = _bindings[i];
+		const Binding& b = o._bindings[i];
+		if (a.binding != b.binding || a.type != b.type
+			|| a.buffer.buffer != b.buffer.buffer || a.buffer.offset != b.buffer.offset || a.buffer.range != b.buffer.range
+			|| a.image.sampler != b.image.sampler || a.image.imageView != b.image.imageView || a.image.imageLayout != b.image.imageLayout) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void DescriptorBindings::write(const VkCtx& ctx, VkDescriptorSet set) const
+{
+	std::vector<VkWriteDescriptorSet> writes;
+	writes.reserve(_bindings.size());
+	for (const Binding& b : _bindings) {
+		bool isImage = b.image.imageView != VK_NULL_HANDLE || b.image.sampler != VK_NULL_HANDLE;
+		writes.push_back({
+			.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+			.dstSet = set,
+			.dstBinding = b.binding,
+			.dstArrayElement = 0,
+			.descriptorCount = 1,
+			.descriptorType = b.type,
+			.pImageInfo = isImage ? &b.image : nullptr,
+			.pBufferInfo = isImage ? nullptr : &b.buffer,
+		});
+	}
+	vkUpdateDescriptorSets(ctx.device(), (uint32_t)writes.size(), writes.data(), 0, nullptr);
+}
+
+size_t DescriptorCache::KeyHash::operator()(const Key& key) const
+{
+	size_t h = key.bindings.hash();
+	hashCombine(h, (uint64_t)key.layout);
+	return h;
+}
+
+DescriptorCache::DescriptorCache()
+{
+}
+
+VkDescriptorSet DescriptorCache::get(const VkCtx& ctx, VkDescriptorSetLayout layout, const DescriptorBindings& bindings)
+{
+	Key key = { layout, bindings };
+	auto it = _sets.find(key);
+	if (it != _sets.end()) {
+		return it->second;
+	}
+	VkDescriptorSet set = _allocator.allocate(ctx, layout);
+	bindings.write(ctx, set);
+	_sets.emplace(std::move(key), set);
+	return set;
+}
+
+void DescriptorCache::clear(const VkCtx& ctx)
+{
+	_sets.clear();
+	_allocator.reset(ctx);
+}
+
+void DescriptorCache::destroy(const VkCtx& ctx)
+{
+	_sets.clear();
+	_allocator.destroy(ctx);
+}
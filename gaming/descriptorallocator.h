@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "vkctx.h"
+
+// Hands out descriptor sets from a list of pools, creating a new pool whenever the current one runs out
+// Every pool is sized from the same per type ratios so mixed layouts can share them
+class DescriptorAllocator {
+private:
+	std::vector<VkDescriptorPool> _usedPools;
+	std::vector<VkDescriptorPool> _freePools;
+	VkDescriptorPool _currentPool;
+	uint32_t _setsPerPool;
+	VkDescriptorPoolCreateFlags _flags;
+
+	VkDescriptorPool nextPool(const VkCtx& ctx);
+public:
+	DescriptorAllocator(uint32_t setsPerPool = 256, VkDescriptorPoolCreateFlags flags = 0);
+	VkDescriptorSet allocate(const VkCtx& ctx, VkDescriptorSetLayout layout);
+	void allocate(const VkCtx& ctx, VkDescriptorSetLayout layout, std::span<VkDescriptorSet> sets);
+	// Frees every set at once, pools are kept around for reuse
+	void reset(const VkCtx& ctx);
+	void destroy(const VkCtx& ctx);
+};
+
+// Descriptor sets that only live until the frame that used them has finished on the GPU
+// Each frame owns its own pools which are reset wholesale with vkResetDescriptorPool once its fence signals
+// Sets are pre-allocated in one batch per registered layout, handing one out is a single atomic increment
+class TransientDescriptors {
+private:
+	struct Slab {
+		VkDescriptorSetLayout layout;
+		std::vector<VkDescriptorSet> sets;
+		std::atomic<uint32_t> next;
+		uint32_t highWater;
+	};
+	struct Frame {
+		DescriptorAllocator allocator;
+		std::vector<std::unique_ptr<Slab>> slabs;
+	};
+	std::vector<std::unique_ptr<Frame>> _frames;
+	size_t _currentFrame;
+	std::mutex _overflowMutex;
+public:
+	TransientDescriptors(size_t frameCount);
+	// Must be called before the first frame, returns the handle used by allocate
+	uint32_t registerLayout(VkDescriptorSetLayout layout, uint32_t initialCapacity);
+	// Call after the frame's fence has been waited on, every set handed out during its last use becomes invalid
+	void beginFrame(const VkCtx& ctx, size_t frameIndex);
+	VkDescriptorSet allocate(const VkCtx& ctx, uint32_t layoutHandle);
+	void destroy(const VkCtx& ctx);
+};
+
+// Describes the resources bound to a descriptor set, used both to write the set and to key the cache
+class DescriptorBindings {
+private:
+	struct Binding {
+		uint32_t binding;
+		VkDescriptorType type;
+		VkDescriptorBufferInfo buffer;
+		VkDescriptorImageInfo image;
+	};
+	std::vector<Binding> _bindings;
+public:
+	DescriptorBindings& buffer(uint32_t binding, VkDescriptorType type, VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+	DescriptorBindings& image(uint32_t binding, VkDescriptorType type, VkImageView view, VkSampler sampler, VkImageLayout layout);
+	size_t hash() const;
+	bool operator==(const DescriptorBindings& o) const;
+	void write(const VkCtx& ctx, VkDescriptorSet set) const;
+};
+
+// Long lived descriptor sets, shared between everything that binds the same resources to the same layout
+class DescriptorCache {
+private:
+	struct Key {
+		VkDescriptorSetLayout layout;
+		DescriptorBindings bindings;
+		bool operator==(const Key& o) const { return layout == o.layout && bindings == o.bindings; }
+	};
+	struct KeyHash {
+		size_t operator()(const Key& key) const;
+	};
+	DescriptorAllocator _allocator;
+	std::unordered_map<Key, VkDescriptorSet, KeyHash> _sets;
+public:
+	DescriptorCache();
+	VkDescriptorSet get(const VkCtx& ctx, VkDescriptorSetLayout layout, const DescriptorBindings& bindings);
+	// Drops every cached set, needed when a bound resource is destroyed and its handle could be reused
+	void clear(const VkCtx& ctx);
+	void destroy(const VkCtx& ctx);
+};
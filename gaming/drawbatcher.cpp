@@ -0,0 +1,90 @@
+#include "drawbatcher.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+
+size_t DrawBatcher::KeyHash::operator()(const Key& key) const
+{
+	return std::hash<uint64_t>{}((uint64_t)key.pipeline) ^ (std::hash<const void*>{}(key.mesh) * 31);
+}
+
+DrawBatcher::DrawBatcher(const VkCtx& ctx, size_t frames, size_t maxInstances)
+	: _instances(ctx, frames, maxInstances),
+	_drawCount(0)
+{
+}
+
+void DrawBatcher::add(VkPipeline pipeline, const Mesh& mesh, const InstanceData& instance)
+{
+	Key key = { pipeline, &mesh };
+	auto it = _lookup.find(key);
+	if (it == _lookup.end()) {
+		it = _lookup.emplace(key, _batches.size()).first;
+		_batches.push_back({ pipeline, &mesh, {} });
+	}
+	_batches[it->second].instances.push_back(instance);
+}
+
+void DrawBatcher::record(VkCommandBuffer buf, const DefaultLayout& layout, VkDescriptorSet set, size_t frame, uint32_t cameraOffset)
+{
+	// Sort groups so pipeline and buffer binds change as rarely as possible
+	_order.clear();
+	for (size_t i = 0; i < _batches.size(); i++) {
+		if (!_batches[i].instances.empty()) {
+			_order.push_back(i);
+		}
+	}
+	std::sort(_order.begin(), _order.end(), [this](size_t a, size_t b) {
+		const Batch& l = _batches[a];
+		const Batch& r = _batches[b];
+		if (l.pipeline != r.pipeline) {
+			return l.pipeline < r.pipeline;
+		}
+		return l.mesh->vertexBuffer < r.mesh->vertexBuffer;
+	});
+
+	uint32_t offsets[] = { cameraOffset, _instances.offset(frame) };
+	vkCmdBindDescriptorSets(buf, VK_PIPELINE_BIND_POINT_GRAPHICS, layout.layout(), 0, 1, &set, 2, offsets);
+
+	InstanceData* dst = _instances.data(frame);
+	uint32_t firstInstance = 0;
+	VkPipeline boundPipeline = VK_NULL_HANDLE;
+	VkBuffer boundVertices = VK_NULL_HANDLE;
+	VkBuffer boundIndices = VK_NULL_HANDLE;
+	_drawCount = 0;
+	for (size_t i : _order) {
+		const Batch& batch = _batches[i];
+		uint32_t count = (uint32_t)batch.instances.size();
+		if (firstInstance + count > _instances.capacity()) {
+			throw std::runtime_error("Instance buffer overflow");
+		}
+		memcpy(dst + firstInstance, batch.instances.data(), count * sizeof(InstanceData));
+
+		if (batch.pipeline != boundPipeline) {
+			vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_GRAPHICS, batch.pipeline);
+			boundPipeline = batch.pipeline;
+		}
+		if (batch.mesh->vertexBuffer != boundVertices) {
+			VkDeviceSize offset = 0;
+			vkCmdBindVertexBuffers(buf, 0, 1, &batch.mesh->vertexBuffer, &offset);
+			boundVertices = batch.mesh->vertexBuffer;
+		}
+		if (batch.mesh->indexBuffer != boundIndices) {
+			vkCmdBindIndexBuffer(buf, batch.mesh->indexBuffer, 0, batch.mesh->indexType);
+			boundIndices = batch.mesh->indexBuffer;
+		}
+		// gl_InstanceIndex starts at firstInstance, so each group reads its own slice of the instance buffer
+		vkCmdDrawIndexed(buf, batch.mesh->indexCount, count, batch.mesh->firstIndex, batch.mesh->vertexOffset, firstInstance);
+		firstInstance += count;
+		_drawCount++;
+	}
+}
+
+void DrawBatcher::clear()
+{
+	for (Batch& batch : _batches) {
+		batch.instances.clear();
+	}
+}
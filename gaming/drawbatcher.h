@@ -0,0 +1,47 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "vkctx.h"
+#include "vkbuffer.h"
+#include "mesh.h"
+#include "defaultlayout.h"
+
+// Groups objects that share a pipeline and mesh so each group is drawn with a single instanced vkCmdDrawIndexed
+// Instance data for all groups is packed densely into one storage buffer per frame (TransformPath::Instanced)
+class DrawBatcher {
+private:
+	struct Key {
+		VkPipeline pipeline;
+		const Mesh* mesh;
+		bool operator==(const Key& o) const { return pipeline == o.pipeline && mesh == o.mesh; }
+	};
+	struct KeyHash {
+		size_t operator()(const Key& key) const;
+	};
+	struct Batch {
+		VkPipeline pipeline;
+		const Mesh* mesh;
+		std::vector<InstanceData> instances;
+	};
+	// Batches are kept between frames and only emptied, so steady state frames do not allocate
+	std::unordered_map<Key, size_t, KeyHash> _lookup;
+	std::vector<Batch> _batches;
+	std::vector<size_t> _order;
+	FrameStorageBuffer<InstanceData> _instances;
+	uint32_t _drawCount;
+public:
+	DrawBatcher(const VkCtx& ctx, size_t frames, size_t maxInstances);
+
+	// mesh must stay alive until record is called
+	void add(VkPipeline pipeline, const Mesh& mesh, const InstanceData& instance);
+	// set must be allocated from a TransformPath::Instanced layout with instanceBuffer() bound at binding 1
+	void record(VkCommandBuffer buf, const DefaultLayout& layout, VkDescriptorSet set, size_t frame, uint32_t cameraOffset);
+	void clear();
+
+	VkBuffer instanceBuffer() const { return _instances.buffer(); }
+	VkDeviceSize instanceRange() const { return _instances.range(); }
+	// Number of vkCmdDrawIndexed issued by the last record
+	uint32_t drawCount() const { return _drawCount; }
+};
\ No newline at end of file
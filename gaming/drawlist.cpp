@@ -0,0 +1,65 @@
+#include "drawlist.h"
+
+#include <algorithm>
+#include <span>
+
+static constexpr int depthBits = 20;
+static constexpr int pipelineBits = 12;
+static constexpr int materialBits = 16;
+static constexpr int meshBits = 12;
+
+static uint32_t idFor(std::unordered_map<uint64_t, uint32_t>& ids, uint64_t handle, int bits)
+{
+	auto [it, added] = ids.try_emplace(handle, (uint32_t)ids.size());
+	return it->second & ((1u << bits) - 1);
+}
+
+uint64_t DrawList::makeKey(DrawLayer layer, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth)
+{
+	uint64_t quantized = (uint64_t)(std::clamp(depth, 0.0f, 1.0f) * (float)((1 << depthBits) - 1));
+	uint64_t state = ((uint64_t)pipeline << (materialBits + meshBits)) | ((uint64_t)material << meshBits) | mesh;
+	uint64_t key = (uint64_t)layer << 60;
+	if (layer == DrawLayer::Transparent) {
+		// Farthest first so blending composites correctly, state only breaks ties
+		uint64_t farness = ((1 << depthBits) - 1) - quantized;
+		key |= (farness << (pipelineBits + materialBits + meshBits)) | state;
+	} else {
+		key |= (state << depthBits) | quantized;
+	}
+	return key;
+}
+
+void DrawList::add(DrawLayer layer, const DrawItem& item, float depth)
+{
+	uint32_t pipeline = idFor(_pipelineIds, (uint64_t)item.pipeline, pipelineBits);
+	uint32_t material = idFor(_materialIds, (uint64_t)item.set, materialBits);
+	uint32_t mesh = idFor(_meshIds, (uint64_t)item.mesh, meshBits);
+	_entries.push_back({ makeKey(layer, pipeline, material, mesh, depth), (uint32_t)_items.size() });
+	_items.push_back(item);
+}
+
+void DrawList::sort()
+{
+	radixSort(_entries, _scratch);
+}
+
+void DrawList::sort(JobSystem& jobs)
+{
+	radixSort(_entries, _scratch, jobs);
+}
+
+void DrawList::record(CommandEncoder& encoder) const
+{
+	for (const SortEntry& entry : _entries) {
+		const DrawItem& item = _items[entry.index];
+		encoder.bindPipeline(item.pipeline);
+		encoder.bindDescriptorSet(item.layout, item.set, std::span<const uint32_t>(item.dynamicOffsets, item.dynamicOffsetCount));
+		encoder.drawMesh(*item.mesh, item.instanceCount, item.firstInstance);
+	}
+}
+
+void DrawList::clear()
+{
+	_items.clear();
+	_entries.clear();
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "vkctx.h"
+#include "mesh.h"
+#include "radixsort.h"
+#include "commandencoder.h"
+
+// Layers are drawn in this order, Transparent sorts back to front and the rest by state then front to back
+enum class DrawLayer : uint8_t {
+	Opaque,
+	AlphaTest,
+	Transparent,
+	Overlay,
+};
+
+// Everything needed to record one draw, mesh must stay alive until the list is recorded
+struct DrawItem {
+	VkPipeline pipeline;
+	VkPipelineLayout layout;
+	VkDescriptorSet set;
+	uint32_t dynamicOffsetCount;
+	uint32_t dynamicOffsets[CommandEncoder::maxDynamicOffsets];
+	const Mesh* mesh;
+	uint32_t instanceCount;
+	uint32_t firstInstance;
+};
+
+// Per frame list of draws, each encoded as a 64 bit key so one radix sort groups them by state:
+//   opaque      layer:4 pipeline:12 material:16 mesh:12 depth:20
+//   transparent layer:4 farness:20 pipeline:12 material:16 mesh:12
+// Pipelines, descriptor sets (materials) and meshes get small ids in the order they are first seen
+// Ids wrap once a field overflows, which only weakens grouping, never correctness
+class DrawList {
+private:
+	std::vector<DrawItem> _items;
+	std::vector<SortEntry> _entries;
+	std::vector<SortEntry> _scratch;
+	std::unordered_map<uint64_t, uint32_t> _pipelineIds;
+	std::unordered_map<uint64_t, uint32_t> _materialIds;
+	std::unordered_map<uint64_t, uint32_t> _meshIds;
+public:
+	// depth is the normalized view distance in [0, 1], values outside are clamped
+	static uint64_t makeKey(DrawLayer layer, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth);
+
+	void add(DrawLayer layer, const DrawItem& item, float depth);
+	void sort();
+	void sort(JobSystem& jobs);
+	// Records every draw in sorted order through encoder, which drops the binds the order made redundant
+	void record(CommandEncoder& encoder) const;
+	// Empties the list, ids are kept so keys stay stable between frames
+	void clear();
+
+	size_t size() const { return _items.size(); }
+};
\ No newline at end of file
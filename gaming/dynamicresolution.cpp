@@ -0,0 +1,34 @@
+#include "dynamicresolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+DynamicResolution::DynamicResolution(const Settings& settings)
+	: _settings(settings),
+	_scale(settings.maxScale),
+	_smoothed(-1.0)
+{
+}
+
+void DynamicResolution::reset(float scale)
+{
+	_scale = std::clamp(scale, _settings.minScale, _settings.maxScale);
+	_smoothed = -1.0;
+}
+
+float DynamicResolution::update(double milliseconds)
+{
+	if (milliseconds < 0.0) {
+		return _scale;
+	}
+	_smoothed = _smoothed < 0.0 ? milliseconds : _smoothed + (milliseconds - _smoothed) * _settings.smoothing;
+
+	double ratio = _smoothed / _settings.targetMilliseconds;
+	if (std::abs(ratio - 1.0) <= _settings.hysteresis) {
+		return _scale;
+	}
+	float desired = (float)(_scale / std::sqrt(std::max(ratio, 1e-3)));
+	float step = std::clamp(desired - _scale, -_settings.maxStep, _settings.maxStep);
+	_scale = std::clamp(_scale + step, _settings.minScale, _settings.maxScale);
+	return _scale;
+}
\ No newline at end of file
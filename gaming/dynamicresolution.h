@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+// Picks the scene's render scale each frame from measured GPU time, trading resolution for a steady frame time
+// The scale is per axis and shading cost follows the pixel count, so a frame taking t at scale s is expected to
+// take target at s * sqrt(target / t). Measurements are smoothed, small deviations inside the hysteresis band are
+// ignored and each frame moves the scale by at most maxStep so the image doesn't visibly pump
+// Render into a ScaledTarget at ScaledTarget::renderExtent(scale()) and upscale into the swapchain image
+class DynamicResolution {
+public:
+	struct Settings {
+		// GPU milliseconds the scene should take
+		float targetMilliseconds;
+		float minScale;
+		float maxScale;
+		// Relative deviation from the target tolerated before the scale moves
+		float hysteresis;
+		// Largest scale change per frame
+		float maxStep;
+		// Weight of a new measurement in the smoothed time
+		float smoothing;
+	};
+private:
+	Settings _settings;
+	float _scale;
+	// Negative until the first measurement
+	double _smoothed;
+public:
+	DynamicResolution(const Settings& settings = { 16.0f, 0.5f, 1.0f, 0.05f, 0.025f, 0.2f });
+
+	// Starts over at scale, for example after a scene change
+	void reset(float scale);
+	// GPU milliseconds of a measured frame's scene passes (GpuTimer), returns the scale for the next frame
+	// Negative measurements (no timestamps yet) keep the current scale
+	float update(double milliseconds);
+
+	float scale() const { return _scale; }
+	double smoothed() const { return _smoothed; }
+	const Settings& settings() const { return _settings; }
+};
\ No newline at end of file
@@ -0,0 +1,24 @@
+#include "frustum.h"
+
+#include <cmath>
+
+Frustum extractFrustum(const glm::mat4& m)
+{
+	// glm is column major, row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i])
+	auto row = [&m](int i) { return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+	glm::vec4 r0 = row(0), r1 = row(1), r2 = row(2), r3 = row(3);
+
+	Frustum f = { {
+		r3 + r0, // Left
+		r3 - r0, // Right
+		r3 + r1, // Bottom
+		r3 - r1, // Top
+		r2,      // Near, z >= 0
+		r3 - r2, // Far
+	} };
+	for (glm::vec4& p : f.planes) {
+		float len = std::sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
+		p = p / len;
+	}
+	return f;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+// View frustum as six planes (xyz normal pointing inwards, w distance), a point p is inside a plane when dot(n, p) + w >= 0
+struct Frustum {
+	glm::vec4 planes[6];
+};
+
+// Gribb/Hartmann plane extraction for a Vulkan style clip space (depth 0..1), projections must come from glm with
+// GLM_FORCE_DEPTH_ZERO_TO_ONE, which the build defines
+Frustum extractFrustum(const glm::mat4& viewProj);
\ No newline at end of file
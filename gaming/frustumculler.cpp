@@ -0,0 +1,138 @@
+#include "frustumculler.h"
+
+#include <bit>
+#include <cfloat>
+
+#include <immintrin.h>
+
+#ifdef __AVX2__
+static constexpr size_t lanes = 8;
+#else
+static constexpr size_t lanes = 4;
+#endif
+
+// Tests spheres [begin, end) against the frustum, begin and end must be multiples of lanes
+// Writes surviving indices to out and returns how many were written
+static size_t cullRange(const Frustum& frustum, const float* x, const float* y, const float* z, const float* r, size_t begin, size_t end, uint32_t* out)
+{
+	size_t n = 0;
+#ifdef __AVX2__
+	__m256 px[6], py[6], pz[6], pw[6];
+	for (int p = 0; p < 6; p++) {
+		px[p] = _mm256_set1_ps(frustum.planes[p].x);
+		py[p] = _mm256_set1_ps(frustum.planes[p].y);
+		pz[p] = _mm256_set1_ps(frustum.planes[p].z);
+		pw[p] = _mm256_set1_ps(frustum.planes[p].w);
+	}
+	for (size_t i = begin; i < end; i += lanes) {
+		__m256 cx = _mm256_loadu_ps(x + i);
+		__m256 cy = _mm256_loadu_ps(y + i);
+		__m256 cz = _mm256_loadu_ps(z + i);
+		__m256 negR = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(r + i));
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (int p = 0; p < 6; p++) {
+			__m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px[p], cx), _mm256_mul_ps(py[p], cy)), _mm256_add_ps(_mm256_mul_ps(pz[p], cz), pw[p]));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, negR, _CMP_GE_OQ));
+		}
+		uint32_t mask = (uint32_t)_mm256_movemask_ps(inside);
+		while (mask) {
+			out[n++] = (uint32_t)(i + std::countr_zero(mask));
+			mask &= mask - 1;
+		}
+	}
+#else
+	__m128 px[6], py[6], pz[6], pw[6];
+	for (int p = 0; p < 6; p++) {
+		px[p] = _mm_set1_ps(frustum.planes[p].x);
+		py[p] = _mm_set1_ps(frustum.planes[p].y);
+		pz[p] = _mm_set1_ps(frustum.planes[p].z);
+		pw[p] = _mm_set1_ps(frustum.planes[p].w);
+	}
+	for (size_t i = begin; i < end; i += lanes) {
+		__m128 cx = _mm_loadu_ps(x + i);
+		__m128 cy = _mm_loadu_ps(y + i);
+		__m128 cz = _mm_loadu_ps(z + i);
+		__m128 negR = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(r + i));
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (int p = 0; p < 6; p++) {
+			__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px[p], cx), _mm_mul_ps(py[p], cy)), _mm_add_ps(_mm_mul_ps(pz[p], cz), pw[p]));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(d, negR));
+		}
+		uint32_t mask = (uint32_t)_mm_movemask_ps(inside);
+		while (mask) {
+			out[n++] = (uint32_t)(i + std::countr_zero(mask));
+			mask &= mask - 1;
+		}
+	}
+#endif
+	return n;
+}
+
+FrustumCuller::FrustumCuller()
+	: _count(0)
+{
+}
+
+void FrustumCuller::pad()
+{
+	size_t padded = (_count + lanes - 1) / lanes * lanes;
+	// Radius of -FLT_MAX fails every plane so padding never shows up as visible
+	_x.resize(padded, 0.0f);
+	_y.resize(padded, 0.0f);
+	_z.resize(padded, 0.0f);
+	_r.resize(padded, -FLT_MAX);
+}
+
+uint32_t FrustumCuller::add(const glm::vec4& sphere)
+{
+	uint32_t index = (uint32_t)_count++;
+	pad();
+	set(index, sphere);
+	return index;
+}
+
+void FrustumCuller::set(uint32_t index, const glm::vec4& sphere)
+{
+	_x[index] = sphere.x;
+	_y[index] = sphere.y;
+	_z[index] = sphere.z;
+	_r[index] = sphere.w;
+}
+
+void FrustumCuller::clear()
+{
+	_count = 0;
+	_x.clear();
+	_y.clear();
+	_z.clear();
+	_r.clear();
+}
+
+void FrustumCuller::cull(const Frustum& frustum, std::vector<uint32_t>& visible) const
+{
+	visible.resize(_x.size());
+	size_t n = cullRange(frustum, _x.data(), _y.data(), _z.data(), _r.data(), 0, _x.size(), visible.data());
+	visible.resize(n);
+}
+
+void FrustumCuller::cull(const Frustum& frustum, std::vector<uint32_t>& visible, JobSystem& jobs)
+{
+	if (_count < parallelThreshold) {
+		cull(frustum, visible);
+		return;
+	}
+
+	// Chunks write to their own lists so the output stays in index order without any synchronisation
+	size_t chunks = (_x.size() + chunkSize - 1) / chunkSize;
+	_chunkVisible.resize(chunks);
+	jobs.parallelFor(_x.size(), chunkSize, [&](size_t begin, size_t end) {
+		std::vector<uint32_t>& out = _chunkVisible[begin / chunkSize];
+		out.resize(end - begin);
+		out.resize(cullRange(frustum, _x.data(), _y.data(), _z.data(), _r.data(), begin, end, out.data()));
+	});
+
+	visible.clear();
+	for (size_t i = 0; i < chunks; i++) {
+		visible.insert(visible.end(), _chunkVisible[i].begin(), _chunkVisible[i].end());
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/vec4.hpp>
+
+#include "frustum.h"
+#include "jobsystem.h"
+
+// CPU frustum culling over bounding spheres stored as structure of arrays
+// Spheres are tested 8 at a time with AVX2 (4 with SSE unless built with GAMING_AVX2) and survivors
+// are written out as a compact list of indices for the recording stage
+class FrustumCuller {
+private:
+	// Padded to a whole number of SIMD lanes with spheres that can never be visible
+	std::vector<float> _x;
+	std::vector<float> _y;
+	std::vector<float> _z;
+	std::vector<float> _r;
+	size_t _count;
+	std::vector<std::vector<uint32_t>> _chunkVisible;
+
+	void pad();
+public:
+	static constexpr size_t parallelThreshold = 16384;
+	static constexpr size_t chunkSize = 4096;
+
+	FrustumCuller();
+
+	// sphere is xyz world space center and w radius, returns its index
+	uint32_t add(const glm::vec4& sphere);
+	void set(uint32_t index, const glm::vec4& sphere);
+	void clear();
+	size_t size() const { return _count; }
+
+	// Replaces visible with the ascending indices of every sphere intersecting the frustum
+	void cull(const Frustum& frustum, std::vector<uint32_t>& visible) const;
+	// Same as cull, large sets are split across the job system's threads
+	void cull(const Frustum& frustum, std::vector<uint32_t>& visible, JobSystem& jobs);
+};
\ No newline at end of file
@@ -6,6 +6,8 @@
 #include "vkctx.h"
 #include "windowswapchain.h"
 #include "defaultshader.h"
+#include "descriptorallocator.h"
+#include "bindlesstable.h"
 
 
 #include "SDL2/SDL.h"
@@ -22,6 +24,8 @@ int main()
 	ShaderModule frag(ctx, "shaders/default.frag.spv");
 	DefaultLayout layout(ctx);
 	DefaultShader shader(ctx, layout, vert, frag, swap.renderPass());
+	TransientDescriptors frameDescriptors(swap.imageCount());
+	BindlessTable bindless(ctx, swap.imageCount());
 
 	// set up resources
 	bool running = true;
@@ -62,6 +66,8 @@ int main()
 		CHK_ERR(vkWaitForFences(ctx.device(), 1, &fence, true, UINT64_MAX));
 		CHK_ERR(vkResetFences(ctx.device(), 1, &fence));
 		CHK_ERR(vkResetCommandPool(ctx.device(), swap.commandPool(fi), 0));
+		frameDescriptors.beginFrame(ctx, fi);
+		bindless.beginFrame(fi);
 		VkCommandBufferBeginInfo commandBeginInfo = {
 			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
 			.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
@@ -128,6 +134,8 @@ int main()
 	}
 	vkDeviceWaitIdle(ctx.device());
 
+	bindless.destroy(ctx);
+	frameDescriptors.destroy(ctx);
 	shader.destroy(ctx);
 	layout.destroy(ctx);
 	vert.destroy(ctx);
@@ -0,0 +1,273 @@
+#include "gpuscene.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "frustum.h"
+
+static constexpr uint32_t cullGroupSize = 64;
+
+// Bindings 0-3 are shared by both cull shaders, the occlusion shader adds the
+// visibility flags (4), the pyramid (5) and its per frame uniform (6)
+static VkPipelineLayout createCullLayout(const VkCtx& ctx, VkDescriptorSetLayout& descriptorLayout, uint32_t pushSize, bool occlusion)
+{
+	VkDescriptorSetLayoutBinding bindings[7];
+	for (uint32_t i = 0; i < 5; i++) {
+		bindings[i] = {
+			.binding = i,
+			// Inputs are per frame regions of one buffer, outputs are shared and protected by barriers
+			.descriptorType = i < 2 ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.descriptorCount = 1,
+			.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+		};
+	}
+	bindings[5] = {
+		.binding = 5,
+		.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+		.descriptorCount = 1,
+		.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+	};
+	bindings[6] = {
+		.binding = 6,
+		.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+		.descriptorCount = 1,
+		.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+	};
+	VkDescriptorSetLayoutCreateInfo descriptorLayoutInfo = {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+		.bindingCount = occlusion ? 7u : 4u,
+		.pBindings = bindings,
+	};
+	CHK_ERR(vkCreateDescriptorSetLayout(ctx.device(), &descriptorLayoutInfo, nullptr, &descriptorLayout));
+
+	VkPushConstantRange pushRange = {
+		.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+		.offset = 0,
+		.size = pushSize,
+	};
+	VkPipelineLayoutCreateInfo info = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+		.setLayoutCount = 1,
+		.pSetLayouts = &descriptorLayout,
+		.pushConstantRangeCount = 1,
+		.pPushConstantRanges = &pushRange,
+	};
+	VkPipelineLayout layout;
+	CHK_ERR(vkCreatePipelineLayout(ctx.device(), &info, nullptr, &layout));
+	return layout;
+}
+
+GpuScene::GpuScene(const VkCtx& ctx, DescriptorAllocator& descriptors, const ShaderModule& cullShader, size_t frames, size_t maxObjects)
+	: _dirtyObjects(frames),
+	_boundsBuffer(ctx, frames, maxObjects),
+	_drawBuffer(ctx, frames, maxObjects),
+	_instanceBuffer(ctx, frames, maxObjects),
+	_commandBuffer(ctx, 2 * maxObjects * sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT),
+	_countBuffer(ctx, 2 * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT),
+	_descriptorLayout(VK_NULL_HANDLE),
+	_layout(createCullLayout(ctx, _descriptorLayout, sizeof(CullConstants), false)),
+	_set(descriptors.allocate(ctx, _descriptorLayout)),
+	_cull(ctx, _layout, cullShader),
+	_maxObjects(maxObjects)
+{
+	if (!ctx.supportsIndirectCount()) {
+		throw std::runtime_error("GPU scene needs indirect count draws, which the device does not support");
+	}
+	if (!ctx.supportsSubgroupOps(VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_BALLOT_BIT)) {
+		throw std::runtime_error("GPU scene culling needs subgroup ballot in compute shaders");
+	}
+	if (frames > 32) {
+		throw std::runtime_error("GPU scene tracks at most 32 frames in flight");
+	}
+	DescriptorBindings()
+		.buffer(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, _boundsBuffer.buffer(), 0, _boundsBuffer.range())
+		.buffer(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, _drawBuffer.buffer(), 0, _drawBuffer.range())
+		.buffer(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _commandBuffer.buffer())
+		.buffer(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _countBuffer.buffer())
+		.write(ctx, _set);
+}
+
+void GpuScene::destroy(const VkCtx& ctx)
+{
+	if (_occlusion) {
+		_occlusion->cull.destroy(ctx);
+		vkDestroyPipelineLayout(ctx.device(), _occlusion->layout, nullptr);
+		vkDestroyDescriptorSetLayout(ctx.device(), _occlusion->descriptorLayout, nullptr);
+		_occlusion.reset();
+	}
+	_cull.destroy(ctx);
+	vkDestroyPipelineLayout(ctx.device(), _layout, nullptr);
+	vkDestroyDescriptorSetLayout(ctx.device(), _descriptorLayout, nullptr);
+}
+
+uint32_t GpuScene::addObject(const GpuDrawRecord& draw, const InstanceData& instance, const glm::vec4& sphere)
+{
+	if (_draws.size() >= _maxObjects) {
+		throw std::runtime_error("GPU scene is full");
+	}
+	_draws.push_back(draw);
+	_instances.push_back(instance);
+	_bounds.push_back(sphere);
+	_dirtyFrames.push_back(0);
+	uint32_t index = (uint32_t)_draws.size() - 1;
+	markDirty(index);
+	return index;
+}
+
+void GpuScene::updateObject(uint32_t index, const InstanceData& instance, const glm::vec4& sphere)
+{
+	_instances[index] = instance;
+	_bounds[index] = sphere;
+	markDirty(index);
+}
+
+void GpuScene::markDirty(uint32_t index)
+{
+	for (size_t frame = 0; frame < _dirtyObjects.size(); frame++) {
+		uint32_t bit = 1u << frame;
+		if (!(_dirtyFrames[index] & bit)) {
+			_dirtyFrames[index] |= bit;
+			_dirtyObjects[frame].push_back(index);
+		}
+	}
+}
+
+void GpuScene::enableOcclusion(const VkCtx& ctx, DescriptorAllocator& descriptors, const ShaderModule& occlusionShader, HiZPyramid& hiz)
+{
+	VkDescriptorSetLayout descriptorLayout;
+	VkPipelineLayout layout = createCullLayout(ctx, descriptorLayout, sizeof(uint32_t), true);
+	VkDescriptorSet set = descriptors.allocate(ctx, descriptorLayout);
+	_occlusion.emplace(
+		hiz,
+		FrameUniformBuffer<OcclusionUniform>(ctx, _dirtyObjects.size()),
+		DeviceBuffer(ctx, _maxObjects * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT),
+		descriptorLayout,
+		layout,
+		set,
+		ComputeShader(ctx, layout, occlusionShader),
+		glm::mat4(1.0f));
+
+	DescriptorBindings()
+		.buffer(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, _boundsBuffer.buffer(), 0, _boundsBuffer.range())
+		.buffer(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, _drawBuffer.buffer(), 0, _drawBuffer.range())
+		.buffer(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _commandBuffer.buffer())
+		.buffer(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _countBuffer.buffer())
+		.buffer(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _occlusion->visibility.buffer())
+		.image(5, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, hiz.view(), hiz.sampler(), VK_IMAGE_LAYOUT_GENERAL)
+		.buffer(6, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, _occlusion->uniform.buffer(), 0, sizeof(OcclusionUniform))
+		.write(ctx, set);
+}
+
+void GpuScene::upload(size_t frame)
+{
+	glm::vec4* bounds = _boundsBuffer.data(frame);
+	GpuDrawRecord* draws = _drawBuffer.data(frame);
+	InstanceData* instances = _instanceBuffer.data(frame);
+	uint32_t bit = 1u << frame;
+	for (uint32_t index : _dirtyObjects[frame]) {
+		bounds[index] = _bounds[index];
+		draws[index] = _draws[index];
+		instances[index] = _instances[index];
+		_dirtyFrames[index] &= ~bit;
+	}
+	_dirtyObjects[frame].clear();
+}
+
+void GpuScene::dispatch(VkCommandBuffer buf, VkPipeline pipeline, VkPipelineLayout layout, VkDescriptorSet set, std::span<const uint32_t> offsets, const void* constants, uint32_t constantsSize)
+{
+	vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+	vkCmdBindDescriptorSets(buf, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0, 1, &set, (uint32_t)offsets.size(), offsets.data());
+	vkCmdPushConstants(buf, layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, constantsSize, constants);
+	vkCmdDispatch(buf, ((uint32_t)_draws.size() + cullGroupSize - 1) / cullGroupSize, 1, 1);
+
+	VkMemoryBarrier written = {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+	};
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &written, 0, nullptr, 0, nullptr);
+}
+
+// The previous frame's indirect draws may still be reading the outputs, both phases' counts are reset
+static void resetCounts(VkCommandBuffer buf, VkBuffer counts)
+{
+	VkMemoryBarrier readDone = {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.srcAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+		.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+	};
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &readDone, 0, nullptr, 0, nullptr);
+
+	vkCmdFillBuffer(buf, counts, 0, 2 * sizeof(uint32_t), 0);
+	VkMemoryBarrier cleared = {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+	};
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &cleared, 0, nullptr, 0, nullptr);
+}
+
+void GpuScene::cull(VkCommandBuffer buf, size_t frame, const glm::mat4& viewProj)
+{
+	upload(frame);
+	resetCounts(buf, _countBuffer.buffer());
+
+	CullConstants constants;
+	Frustum frustum = extractFrustum(viewProj);
+	for (int i = 0; i < 6; i++) {
+		constants.planes[i] = frustum.planes[i];
+	}
+	constants.objectCount = (uint32_t)_draws.size();
+
+	uint32_t offsets[] = { _boundsBuffer.offset(frame), _drawBuffer.offset(frame) };
+	dispatch(buf, _cull.pipeline(), _layout, _set, offsets, &constants, sizeof(constants));
+}
+
+void GpuScene::cullEarly(VkCommandBuffer buf, size_t frame, const glm::mat4& viewProj)
+{
+	if (!_occlusion) {
+		throw std::runtime_error("Occlusion culling is not enabled");
+	}
+	upload(frame);
+	resetCounts(buf, _countBuffer.buffer());
+	_occlusion->hiz.prepare(buf);
+
+	OcclusionUniform uniform;
+	Frustum frustum = extractFrustum(viewProj);
+	for (int i = 0; i < 6; i++) {
+		uniform.planes[i] = frustum.planes[i];
+	}
+	uniform.viewProj = viewProj;
+	// The pyramid still holds last frame's depth, rendered with last frame's camera
+	uniform.prevViewProj = _occlusion->prevViewProj;
+	VkExtent2D depth = _occlusion->hiz.depthExtent();
+	uniform.depthSize = glm::vec2((float)depth.width, (float)depth.height);
+	uniform.objectCount = (uint32_t)_draws.size();
+	uniform.maxObjects = (uint32_t)_maxObjects;
+	_occlusion->uniform.write(frame, uniform);
+	_occlusion->prevViewProj = viewProj;
+
+	uint32_t phase = (uint32_t)CullPhase::Early;
+	uint32_t offsets[] = { _boundsBuffer.offset(frame), _drawBuffer.offset(frame), _occlusion->uniform.offset(frame) };
+	dispatch(buf, _occlusion->cull.pipeline(), _occlusion->layout, _occlusion->set, offsets, &phase, sizeof(phase));
+}
+
+void GpuScene::cullLate(VkCommandBuffer buf, size_t frame)
+{
+	if (!_occlusion) {
+		throw std::runtime_error("Occlusion culling is not enabled");
+	}
+	// Visibility flags from cullEarly and the pyramid from HiZPyramid::build are already visible to compute
+	uint32_t phase = (uint32_t)CullPhase::Late;
+	uint32_t offsets[] = { _boundsBuffer.offset(frame), _drawBuffer.offset(frame), _occlusion->uniform.offset(frame) };
+	dispatch(buf, _occlusion->cull.pipeline(), _occlusion->layout, _occlusion->set, offsets, &phase, sizeof(phase));
+}
+
+void GpuScene::draw(VkCommandBuffer buf, const DefaultLayout& layout, VkDescriptorSet set, size_t frame, uint32_t cameraOffset, CullPhase phase) const
+{
+	VkDeviceSize region = (VkDeviceSize)phase;
+	uint32_t offsets[] = { cameraOffset, _instanceBuffer.offset(frame) };
+	vkCmdBindDescriptorSets(buf, VK_PIPELINE_BIND_POINT_GRAPHICS, layout.layout(), 0, 1, &set, 2, offsets);
+	vkCmdDrawIndexedIndirectCount(buf, _commandBuffer.buffer(), region * _maxObjects * sizeof(VkDrawIndexedIndirectCommand),
+		_countBuffer.buffer(), region * sizeof(uint32_t), (uint32_t)_maxObjects, sizeof(VkDrawIndexedIndirectCommand));
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <vector>
+#include <optional>
+#include <span>
+
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+#include "vkctx.h"
+#include "vkbuffer.h"
+#include "computeshader.h"
+#include "defaultlayout.h"
+#include "descriptorallocator.h"
+#include "hizpyramid.h"
+
+// Matches DrawRecord in shaders/cull.comp, an index range in the scene's shared vertex/index buffers
+struct GpuDrawRecord {
+	uint32_t indexCount;
+	uint32_t firstIndex;
+	int32_t vertexOffset;
+	uint32_t pad;
+};
+
+// GPU driven rendering: object bounds and draw records live in storage buffers,
+// a compute pass culls them and writes VkDrawIndexedIndirectCommands plus a count,
+// and the whole scene is drawn with one vkCmdDrawIndexedIndirectCount
+// The CPU only touches objects that changed, per frame cost does not depend on object count
+//
+// With occlusion enabled a frame is drawn in two phases:
+//   cullEarly, draw(Early) in WindowSwapchain::firstPhasePass, HiZPyramid::build,
+//   cullLate, draw(Late) in WindowSwapchain::secondPhasePass
+// The early phase reprojects last frame's pyramid, the late phase re-tests only what the early phase rejected
+// against the pyramid built from this frame's early depth, so nothing visible is culled for more than a phase
+enum class CullPhase {
+	Early,
+	Late,
+};
+
+class GpuScene {
+private:
+	struct CullConstants {
+		glm::vec4 planes[6];
+		uint32_t objectCount;
+	};
+
+	// Matches OcclusionUniform in shaders/cull_occlusion.comp (std140)
+	struct OcclusionUniform {
+		glm::vec4 planes[6];
+		glm::mat4 viewProj;
+		glm::mat4 prevViewProj;
+		glm::vec2 depthSize;
+		uint32_t objectCount;
+		uint32_t maxObjects;
+	};
+
+	struct Occlusion {
+		HiZPyramid& hiz;
+		FrameUniformBuffer<OcclusionUniform> uniform;
+		// Per object, 1 if drawn by the early phase this frame
+		DeviceBuffer visibility;
+		VkDescriptorSetLayout descriptorLayout;
+		VkPipelineLayout layout;
+		VkDescriptorSet set;
+		ComputeShader cull;
+		glm::mat4 prevViewProj;
+	};
+
+	// CPU copies, each frame's region only gets the objects that changed since that region was last used
+	std::vector<glm::vec4> _bounds;
+	std::vector<GpuDrawRecord> _draws;
+	std::vector<InstanceData> _instances;
+	// Per frame list of objects to copy, and per object a bit for each frame whose list already holds it
+	std::vector<std::vector<uint32_t>> _dirtyObjects;
+	std::vector<uint32_t> _dirtyFrames;
+	FrameStorageBuffer<glm::vec4> _boundsBuffer;
+	FrameStorageBuffer<GpuDrawRecord> _drawBuffer;
+	FrameStorageBuffer<InstanceData> _instanceBuffer;
+	// Two regions of maxObjects commands and two counts, one per CullPhase
+	DeviceBuffer _commandBuffer;
+	DeviceBuffer _countBuffer;
+	VkDescriptorSetLayout _descriptorLayout;
+	VkPipelineLayout _layout;
+	VkDescriptorSet _set;
+	ComputeShader _cull;
+	size_t _maxObjects;
+	std::optional<Occlusion> _occlusion;
+
+	void markDirty(uint32_t index);
+	void upload(size_t frame);
+	void dispatch(VkCommandBuffer buf, VkPipeline pipeline, VkPipelineLayout layout, VkDescriptorSet set, std::span<const uint32_t> offsets, const void* constants, uint32_t constantsSize);
+public:
+	// Throws when the device lacks indirect count draws, see VkCtx::supportsIndirectCount
+	GpuScene(const VkCtx& ctx, DescriptorAllocator& descriptors, const ShaderModule& cullShader, size_t frames, size_t maxObjects);
+	void destroy(const VkCtx& ctx);
+
+	// sphere is the world space bounding sphere (xyz center, w radius), returns the object index
+	uint32_t addObject(const GpuDrawRecord& draw, const InstanceData& instance, const glm::vec4& sphere);
+	void updateObject(uint32_t index, const InstanceData& instance, const glm::vec4& sphere);
+
+	// Records the frustum culling dispatch, must be outside a render pass, results are drawn with CullPhase::Early
+	void cull(VkCommandBuffer buf, size_t frame, const glm::mat4& viewProj);
+
+	// hiz must be built from the depth of the early phase every frame and outlive the scene
+	void enableOcclusion(const VkCtx& ctx, DescriptorAllocator& descriptors, const ShaderModule& occlusionShader, HiZPyramid& hiz);
+	// Frustum and occlusion culling against last frame's pyramid, must be outside a render pass
+	void cullEarly(VkCommandBuffer buf, size_t frame, const glm::mat4& viewProj);
+	// Re-tests objects rejected by cullEarly against the freshly built pyramid, must be outside a render pass
+	void cullLate(VkCommandBuffer buf, size_t frame);
+
+	// Draws every object visible in phase, the scene's vertex/index buffers and a TransformPath::Instanced pipeline must be bound
+	// set must have instanceBuffer() bound at binding 1
+	void draw(VkCommandBuffer buf, const DefaultLayout& layout, VkDescriptorSet set, size_t frame, uint32_t cameraOffset, CullPhase phase = CullPhase::Early) const;
+
+	VkBuffer instanceBuffer() const { return _instanceBuffer.buffer(); }
+	VkDeviceSize instanceRange() const { return _instanceBuffer.range(); }
+	size_t objectCount() const { return _draws.size(); }
+};
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include "gputimer.h"
+
+#include <stdexcept>
+
+GpuTimer::GpuTimer(const VkCtx& ctx, size_t frames, uint32_t maxScopes)
+	: _pool(VK_NULL_HANDLE),
+	_frames(frames),
+	_maxScopes(maxScopes),
+	_period(0.0),
+	_validMask(0),
+	_scopes(frames),
+	_readback(2 * maxScopes)
+{
+	VkPhysicalDeviceProperties props;
+	vkGetPhysicalDeviceProperties(ctx.physicalDevice(), &props);
+	uint32_t queueCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(ctx.physicalDevice(), &queueCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queues(queueCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(ctx.physicalDevice(), &queueCount, queues.data());
+	uint32_t validBits = queues[ctx.graphicsQueueIndex()].timestampValidBits;
+	if (validBits == 0) {
+		return;
+	}
+	_period = props.limits.timestampPeriod;
+	_validMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+	VkQueryPoolCreateInfo info = {
+		.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+		.queryType = VK_QUERY_TYPE_TIMESTAMP,
+		.queryCount = (uint32_t)(frames * maxScopes * 2),
+	};
+	CHK_ERR(vkCreateQueryPool(ctx.device(), &info, nullptr, &_pool));
+}
+
+void GpuTimer::destroy(const VkCtx& ctx)
+{
+	vkDestroyQueryPool(ctx.device(), _pool, nullptr);
+}
+
+void GpuTimer::beginFrame(const VkCtx& ctx, VkCommandBuffer buf, size_t frame)
+{
+	if (!supported()) {
+		return;
+	}
+	std::vector<Scope>& scopes = _scopes[frame];
+	uint32_t count = (uint32_t)scopes.size() * 2;
+	// The fence was waited on so the results are complete, NOT_READY would only mean the frame was never submitted
+	if (count > 0 && vkGetQueryPoolResults(ctx.device(), _pool, query(frame, 0), count, count * sizeof(uint64_t),
+		_readback.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+		for (uint32_t i = 0; i < (uint32_t)scopes.size(); i++) {
+			if (!scopes[i].ended) {
+				continue;
+			}
+			uint64_t ticks = (_readback[2 * i + 1] - _readback[2 * i]) & _validMask;
+			_results[scopes[i].name] = ticks * _period * 1e-6;
+		}
+	}
+	scopes.clear();
+	vkCmdResetQueryPool(buf, _pool, query(frame, 0), _maxScopes * 2);
+}
+
+uint32_t GpuTimer::begin(VkCommandBuffer buf, size_t frame, const std::string& name)
+{
+	std::vector<Scope>& scopes = _scopes[frame];
+	if (scopes.size() >= _maxScopes) {
+		throw std::runtime_error("Too many GPU timer scopes");
+	}
+	scopes.push_back({ name, false });
+	uint32_t scope = (uint32_t)scopes.size() - 1;
+	if (supported()) {
+		vkCmdWriteTimestamp(buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, _pool, query(frame, scope));
+	}
+	return scope;
+}
+
+void GpuTimer::end(VkCommandBuffer buf, size_t frame, uint32_t scope)
+{
+	_scopes[frame][scope].ended = true;
+	if (supported()) {
+		vkCmdWriteTimestamp(buf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _pool, query(frame, scope) + 1);
+	}
+}
+
+double GpuTimer::milliseconds(const std::string& name) const
+{
+	auto it = _results.find(name);
+	return it == _results.end() ? -1.0 : it->second;
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "vkctx.h"
+
+// Named GPU time measurements with timestamp queries, one query range per frame in flight
+// Results are read back without stalling when the frame's slot comes around again, so they lag by framesInFlight
+class GpuTimer {
+private:
+	struct Scope {
+		std::string name;
+		bool ended;
+	};
+
+	VkQueryPool _pool;
+	size_t _frames;
+	uint32_t _maxScopes;
+	// Nanoseconds per timestamp tick, 0 if the graphics queue has no timestamps
+	double _period;
+	uint64_t _validMask;
+	std::vector<std::vector<Scope>> _scopes;
+	std::vector<uint64_t> _readback;
+	std::unordered_map<std::string, double> _results;
+
+	uint32_t query(size_t frame, uint32_t scope) const { return (uint32_t)(frame * _maxScopes + scope) * 2; }
+public:
+	GpuTimer(const VkCtx& ctx, size_t frames, uint32_t maxScopes);
+	void destroy(const VkCtx& ctx);
+
+	// Call after waiting on the frame's fence and outside a render pass, reads the frame's previous timings
+	// and resets its queries
+	void beginFrame(const VkCtx& ctx, VkCommandBuffer buf, size_t frame);
+	// Timestamps at the top and bottom of the pipe, the scope covers every command recorded between them
+	uint32_t begin(VkCommandBuffer buf, size_t frame, const std::string& name);
+	void end(VkCommandBuffer buf, size_t frame, uint32_t scope);
+
+	// Milliseconds of the named scope's last completed measurement, negative if there is none yet
+	double milliseconds(const std::string& name) const;
+	bool supported() const { return _period > 0.0; }
+};
\ No newline at end of file
@@ -0,0 +1,212 @@
+#include "hizpyramid.h"
+
+static constexpr uint32_t buildGroupSize = 8;
+
+static VkPipelineLayout createBuildLayout(const VkCtx& ctx, VkDescriptorSetLayout& descriptorLayout, uint32_t pushSize)
+{
+	VkDescriptorSetLayoutBinding bindings[] = {
+		{
+			.binding = 0,
+			.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+			.descriptorCount = 1,
+			.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+		},
+		{
+			.binding = 1,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+			.descriptorCount = 1,
+			.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+		},
+	};
+	VkDescriptorSetLayoutCreateInfo descriptorLayoutInfo = {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+		.bindingCount = 2,
+		.pBindings = bindings,
+	};
+	CHK_ERR(vkCreateDescriptorSetLayout(ctx.device(), &descriptorLayoutInfo, nullptr, &descriptorLayout));
+
+	VkPushConstantRange pushRange = {
+		.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+		.offset = 0,
+		.size = pushSize,
+	};
+	VkPipelineLayoutCreateInfo info = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+		.setLayoutCount = 1,
+		.pSetLayouts = &descriptorLayout,
+		.pushConstantRangeCount = 1,
+		.pPushConstantRanges = &pushRange,
+	};
+	VkPipelineLayout layout;
+	CHK_ERR(vkCreatePipelineLayout(ctx.device(), &info, nullptr, &layout));
+	return layout;
+}
+
+HiZPyramid::HiZPyramid(const VkCtx& ctx, DescriptorAllocator& descriptors, const ShaderModule& buildShader, VkImageView depthView, VkExtent2D depthExtent)
+	: _image(VK_NULL_HANDLE),
+	_alloc(nullptr),
+	_view(VK_NULL_HANDLE),
+	_sampler(VK_NULL_HANDLE),
+	_descriptorLayout(VK_NULL_HANDLE),
+	_layout(createBuildLayout(ctx, _descriptorLayout, sizeof(BuildConstants))),
+	_build(ctx, _layout, buildShader),
+	_depthExtent(depthExtent),
+	_initialized(false)
+{
+	// Halve rounding up all the way to 1x1 so every source texel is covered by exactly one parent
+	VkExtent2D extent = { (depthExtent.width + 1) / 2, (depthExtent.height + 1) / 2 };
+	_mipExtents.push_back(extent);
+	while (extent.width > 1 || extent.height > 1) {
+		extent = { (extent.width + 1) / 2, (extent.height + 1) / 2 };
+		_mipExtents.push_back(extent);
+	}
+	uint32_t mips = (uint32_t)_mipExtents.size();
+
+	VkImageCreateInfo imageInfo = {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+		.imageType = VK_IMAGE_TYPE_2D,
+		.format = VK_FORMAT_R32_SFLOAT,
+		.extent = { .width = _mipExtents[0].width, .height = _mipExtents[0].height, .depth = 1, },
+		.mipLevels = mips,
+		.arrayLayers = 1,
+		.samples = VK_SAMPLE_COUNT_1_BIT,
+		.tiling = VK_IMAGE_TILING_OPTIMAL,
+		.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+		.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+	};
+	VmaAllocationCreateInfo allocInfo{};
+	allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+	CHK_ERR(vmaCreateImage(ctx.allocator(), &imageInfo, &allocInfo, &_image, &_alloc, nullptr));
+
+	VkImageViewCreateInfo viewInfo = {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+		.image = _image,
+		.viewType = VK_IMAGE_VIEW_TYPE_2D,
+		.format = VK_FORMAT_R32_SFLOAT,
+		.components = { }, // VK_COMPONENT_SWIZZLE_IDENTITY == 0 therefore zero struct
+		.subresourceRange = {
+			.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+			.baseMipLevel = 0,
+			.levelCount = mips,
+			.baseArrayLayer = 0,
+			.layerCount = 1,
+		}
+	};
+	CHK_ERR(vkCreateImageView(ctx.device(), &viewInfo, nullptr, &_view));
+
+	_mipViews.resize(mips);
+	for (uint32_t i = 0; i < mips; i++) {
+		viewInfo.subresourceRange.baseMipLevel = i;
+		viewInfo.subresourceRange.levelCount = 1;
+		CHK_ERR(vkCreateImageView(ctx.device(), &viewInfo, nullptr, &_mipViews[i]));
+	}
+
+	// Reads use texelFetch, the sampler only exists to satisfy the combined image sampler bindings
+	VkSamplerCreateInfo samplerInfo = {
+		.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+		.magFilter = VK_FILTER_NEAREST,
+		.minFilter = VK_FILTER_NEAREST,
+		.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+		.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		.maxLod = VK_LOD_CLAMP_NONE,
+	};
+	CHK_ERR(vkCreateSampler(ctx.device(), &samplerInfo, nullptr, &_sampler));
+
+	// Mip i reads depth (i == 0) or mip i - 1 and writes mip i
+	_sets.resize(mips);
+	for (uint32_t i = 0; i < mips; i++) {
+		_sets[i] = descriptors.allocate(ctx, _descriptorLayout);
+		DescriptorBindings()
+			.image(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, i == 0 ? depthView : _mipViews[i - 1], _sampler,
+				i == 0 ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL)
+			.image(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, _mipViews[i], VK_NULL_HANDLE, VK_IMAGE_LAYOUT_GENERAL)
+			.write(ctx, _sets[i]);
+	}
+}
+
+void HiZPyramid::destroy(const VkCtx& ctx)
+{
+	_build.destroy(ctx);
+	vkDestroyPipelineLayout(ctx.device(), _layout, nullptr);
+	vkDestroyDescriptorSetLayout(ctx.device(), _descriptorLayout, nullptr);
+	vkDestroySampler(ctx.device(), _sampler, nullptr);
+	for (VkImageView view : _mipViews) {
+		vkDestroyImageView(ctx.device(), view, nullptr);
+	}
+	vkDestroyImageView(ctx.device(), _view, nullptr);
+	vmaDestroyImage(ctx.allocator(), _image, _alloc);
+}
+
+void HiZPyramid::prepare(VkCommandBuffer buf)
+{
+	if (_initialized) {
+		return;
+	}
+	_initialized = true;
+
+	VkImageSubresourceRange range = {
+		.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+		.baseMipLevel = 0,
+		.levelCount = (uint32_t)_mipViews.size(),
+		.baseArrayLayer = 0,
+		.layerCount = 1,
+	};
+	VkImageMemoryBarrier toGeneral = {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+		.srcAccessMask = 0,
+		.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+		.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+		.newLayout = VK_IMAGE_LAYOUT_GENERAL,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.image = _image,
+		.subresourceRange = range,
+	};
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toGeneral);
+
+	VkClearColorValue far = { .float32 = { 1.0f, 1.0f, 1.0f, 1.0f } };
+	vkCmdClearColorImage(buf, _image, VK_IMAGE_LAYOUT_GENERAL, &far, 1, &range);
+
+	VkMemoryBarrier cleared = {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+	};
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &cleared, 0, nullptr, 0, nullptr);
+}
+
+void HiZPyramid::build(VkCommandBuffer buf)
+{
+	prepare(buf);
+
+	// Previous contents are fully overwritten, but readers of the last build must be done first
+	VkMemoryBarrier readDone = {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.srcAccessMask = VK_ACCESS_SHADER_READ_BIT,
+		.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+	};
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &readDone, 0, nullptr, 0, nullptr);
+
+	uint32_t mips = (uint32_t)_mipViews.size();
+	vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_COMPUTE, _build.pipeline());
+	VkExtent2D src = _depthExtent;
+	for (uint32_t i = 0; i < mips; i++) {
+		VkExtent2D dst = _mipExtents[i];
+		BuildConstants constants = { (int32_t)src.width, (int32_t)src.height, (int32_t)dst.width, (int32_t)dst.height };
+		vkCmdBindDescriptorSets(buf, VK_PIPELINE_BIND_POINT_COMPUTE, _layout, 0, 1, &_sets[i], 0, nullptr);
+		vkCmdPushConstants(buf, _layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+		vkCmdDispatch(buf, (dst.width + buildGroupSize - 1) / buildGroupSize, (dst.height + buildGroupSize - 1) / buildGroupSize, 1);
+
+		// Each mip is read by the next dispatch, the last one by whoever tests against the pyramid
+		VkMemoryBarrier written = {
+			.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+			.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+			.dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+		};
+		vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &written, 0, nullptr, 0, nullptr);
+		src = dst;
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+
+#include "vkctx.h"
+#include "computeshader.h"
+#include "descriptorallocator.h"
+
+// Hierarchical depth pyramid built from a depth buffer with compute (shaders/hiz_build.comp)
+// Mip 0 is half the depth resolution rounded up and every texel holds the farthest depth of the texels below it,
+// so an object whose nearest depth is behind a texel's value is hidden everywhere that texel covers
+class HiZPyramid {
+private:
+	struct BuildConstants {
+		int32_t srcWidth;
+		int32_t srcHeight;
+		int32_t dstWidth;
+		int32_t dstHeight;
+	};
+
+	VkImage _image;
+	VmaAllocation _alloc;
+	VkImageView _view;
+	std::vector<VkImageView> _mipViews;
+	std::vector<VkExtent2D> _mipExtents;
+	VkSampler _sampler;
+	VkDescriptorSetLayout _descriptorLayout;
+	VkPipelineLayout _layout;
+	std::vector<VkDescriptorSet> _sets;
+	ComputeShader _build;
+	VkExtent2D _depthExtent;
+	bool _initialized;
+public:
+	HiZPyramid(const VkCtx& ctx, DescriptorAllocator& descriptors, const ShaderModule& buildShader, VkImageView depthView, VkExtent2D depthExtent);
+	void destroy(const VkCtx& ctx);
+
+	// Clears the pyramid to the far plane the first time it is used so testing before the first build culls nothing
+	void prepare(VkCommandBuffer buf);
+	// depth must be in SHADER_READ_ONLY_OPTIMAL with its writes made visible to compute
+	// Leaves the pyramid in GENERAL with its writes visible to compute shader reads
+	void build(VkCommandBuffer buf);
+
+	VkImageView view() const { return _view; }
+	VkSampler sampler() const { return _sampler; }
+	VkExtent2D depthExtent() const { return _depthExtent; }
+	uint32_t mipCount() const { return (uint32_t)_mipViews.size(); }
+};
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "jobsystem.h"
+
+#include <algorithm>
+
+JobSystem::JobSystem(size_t workers)
+	: _fn(nullptr),
+	_count(0),
+	_grain(1),
+	_next(0),
+	_active(0),
+	_generation(0),
+	_quit(false)
+{
+	for (size_t i = 0; i < workers; i++) {
+		_threads.emplace_back(&JobSystem::worker, this);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_quit = true;
+	}
+	_wake.notify_all();
+	for (std::thread& thread : _threads) {
+		thread.join();
+	}
+}
+
+void JobSystem::runChunks()
+{
+	size_t begin;
+	while ((begin = _next.fetch_add(_grain, std::memory_order_relaxed)) < _count) {
+		(*_fn)(begin, std::min(begin + _grain, _count));
+	}
+}
+
+void JobSystem::worker()
+{
+	uint64_t seen = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_wake.wait(lock, [&] { return _quit || _generation != seen; });
+			if (_quit) {
+				return;
+			}
+			seen = _generation;
+			// Job parameters are only changed while no worker is active
+			_active++;
+		}
+		runChunks();
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (--_active == 0) {
+				_done.notify_all();
+			}
+		}
+	}
+}
+
+void JobSystem::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn)
+{
+	if (count == 0) {
+		return;
+	}
+	grain = std::max<size_t>(grain, 1);
+	if (count <= grain) {
+		fn(0, count);
+		return;
+	}
+	if (_threads.empty()) {
+		// Same chunks as the threaded path, callers may keep per chunk state
+		for (size_t begin = 0; begin < count; begin += grain) {
+			fn(begin, std::min(begin + grain, count));
+		}
+		return;
+	}
+
+	std::lock_guard<std::mutex> submit(_submitMutex);
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		// A worker that woke late for the previous job may still be draining it
+		_done.wait(lock, [&] { return _active == 0; });
+		_fn = &fn;
+		_count = count;
+		_grain = grain;
+		_next.store(0, std::memory_order_relaxed);
+		_generation++;
+	}
+	_wake.notify_all();
+	runChunks();
+	std::unique_lock<std::mutex> lock(_mutex);
+	_done.wait(lock, [&] { return _active == 0; });
+}
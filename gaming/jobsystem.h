@@ -0,0 +1,39 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent worker threads for splitting per frame loops (culling, sorting, binning) across cores
+// Only one parallelFor runs at a time, the calling thread works on chunks too
+class JobSystem {
+private:
+	std::vector<std::thread> _threads;
+	std::mutex _submitMutex;
+	std::mutex _mutex;
+	std::condition_variable _wake;
+	std::condition_variable _done;
+	const std::function<void(size_t, size_t)>* _fn;
+	size_t _count;
+	size_t _grain;
+	std::atomic<size_t> _next;
+	size_t _active;
+	uint64_t _generation;
+	bool _quit;
+
+	void runChunks();
+	void worker();
+public:
+	explicit JobSystem(size_t workers = std::max(1u, std::thread::hardware_concurrency()) - 1);
+	~JobSystem();
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// Calls fn(begin, end) for consecutive chunks of at most grain items covering [0, count), returns once all are done
+	void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn);
+	size_t threadCount() const { return _threads.size() + 1; }
+};
\ No newline at end of file
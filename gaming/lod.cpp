@@ -0,0 +1,208 @@
+#include "lod.h"
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <set>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+std::vector<uint32_t> simplifyClusters(std::span<const glm::vec3> positions, std::span<const uint32_t> indices, float cellSize, float& error)
+{
+	glm::vec3 lo(FLT_MAX);
+	for (uint32_t i : indices) {
+		lo = glm::min(lo, positions[i]);
+	}
+
+	struct Cluster {
+		glm::vec3 sum;
+		uint32_t count;
+		uint32_t representative;
+		float distance;
+	};
+	std::unordered_map<uint64_t, uint32_t> cellClusters;
+	std::vector<Cluster> clusters;
+	std::unordered_map<uint32_t, uint32_t> vertexClusters;
+	// 21 bits per axis, plenty for any cell size worth simplifying with
+	auto cellOf = [&](const glm::vec3& p) {
+		glm::vec3 cell = glm::floor((p - lo) / cellSize);
+		return (uint64_t)cell.x | ((uint64_t)cell.y << 21) | ((uint64_t)cell.z << 42);
+	};
+
+	for (uint32_t i : indices) {
+		if (vertexClusters.count(i)) {
+			continue;
+		}
+		auto [it, added] = cellClusters.try_emplace(cellOf(positions[i]), (uint32_t)clusters.size());
+		if (added) {
+			clusters.push_back({ glm::vec3(0.0f), 0, i, FLT_MAX });
+		}
+		clusters[it->second].sum += positions[i];
+		clusters[it->second].count++;
+		vertexClusters[i] = it->second;
+	}
+
+	// The vertex nearest the mean stands in for the whole cell so no new vertices are needed
+	for (const auto& [vertex, cluster] : vertexClusters) {
+		Cluster& c = clusters[cluster];
+		float d = glm::length(positions[vertex] - c.sum / (float)c.count);
+		if (d < c.distance || (d == c.distance && vertex < c.representative)) {
+			c.distance = d;
+			c.representative = vertex;
+		}
+	}
+
+	error = 0.0f;
+	for (const auto& [vertex, cluster] : vertexClusters) {
+		error = std::max(error, glm::length(positions[vertex] - positions[clusters[cluster].representative]));
+	}
+
+	std::vector<uint32_t> out;
+	std::set<std::array<uint32_t, 3>> seen;
+	for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+		uint32_t a = clusters[vertexClusters[indices[t]]].representative;
+		uint32_t b = clusters[vertexClusters[indices[t + 1]]].representative;
+		uint32_t c = clusters[vertexClusters[indices[t + 2]]].representative;
+		if (a == b || b == c || a == c) {
+			continue;
+		}
+		// Rotate the smallest index first so the same triangle always has the same key, winding is kept
+		while (a > b || a > c) {
+			std::swap(a, b);
+			std::swap(b, c);
+		}
+		if (!seen.insert({ a, b, c }).second) {
+			continue;
+		}
+		out.push_back(a);
+		out.push_back(b);
+		out.push_back(c);
+	}
+	return out;
+}
+
+LodBuild buildLods(std::span<const glm::vec3> positions, std::span<const uint32_t> indices, size_t maxLevels, size_t minTriangles)
+{
+	LodBuild build;
+	build.indices.assign(indices.begin(), indices.end());
+	build.levels.push_back({ 0, (uint32_t)indices.size(), 0.0f });
+
+	glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+	for (uint32_t i : indices) {
+		lo = glm::min(lo, positions[i]);
+		hi = glm::max(hi, positions[i]);
+	}
+	glm::vec3 center = (lo + hi) * 0.5f;
+	build.radius = 0.0f;
+	for (uint32_t i : indices) {
+		build.radius = std::max(build.radius, glm::length(positions[i] - center));
+	}
+
+	// Every level is simplified from the original triangles so errors do not accumulate
+	float cellSize = glm::length(hi - lo) / 128.0f;
+	size_t previous = indices.size() / 3;
+	float previousError = 0.0f;
+	while (build.levels.size() < maxLevels && previous >= minTriangles && cellSize > 0.0f) {
+		float error;
+		std::vector<uint32_t> simplified = simplifyClusters(positions, indices, cellSize, error);
+		cellSize *= 2.0f;
+		size_t triangles = simplified.size() / 3;
+		if (triangles == 0) {
+			break;
+		}
+		if (triangles * 4 > previous * 3) {
+			continue;
+		}
+		previousError = std::max(previousError, error);
+		build.levels.push_back({ (uint32_t)build.indices.size(), (uint32_t)simplified.size(), previousError });
+		build.indices.insert(build.indices.end(), simplified.begin(), simplified.end());
+		previous = triangles;
+	}
+	return build;
+}
+
+LodSelector::LodSelector(const LodSettings& settings)
+	: _settings(settings),
+	_camera(0.0f),
+	_projectionScale(1.0f),
+	_dt(0.0f),
+	_triangles(0)
+{
+}
+
+float LodSelector::projectionScale(float fovy, float viewportHeight)
+{
+	return viewportHeight / (2.0f * std::tan(fovy * 0.5f));
+}
+
+uint32_t LodSelector::add()
+{
+	_states.push_back({ noLevel, noLevel, 1.0f });
+	return (uint32_t)_states.size() - 1;
+}
+
+void LodSelector::clear()
+{
+	_states.clear();
+}
+
+void LodSelector::beginFrame(const glm::vec3& camera, float projectionScale, float dt)
+{
+	_camera = camera;
+	_projectionScale = projectionScale;
+	_dt = dt;
+	_triangles = 0;
+}
+
+uint32_t LodSelector::select(uint32_t object, const LodMesh& mesh, const glm::vec4& sphere, LodDraw draws[2])
+{
+	State& state = _states[object];
+	uint32_t levels = (uint32_t)mesh.levels.size();
+
+	// Pixels of screen error per unit of mesh space error, measured at the nearest point of the bounds
+	float distance = std::max(glm::length(glm::vec3(sphere) - _camera) - sphere.w, 1e-3f);
+	float scale = sphere.w / std::max(mesh.radius, FLT_MIN) * _projectionScale / distance;
+	auto coarsest = [&](float limit) {
+		uint32_t level = 0;
+		while (level + 1 < levels && mesh.errors[level + 1] * scale <= limit) {
+			level++;
+		}
+		return level;
+	};
+
+	uint32_t target;
+	if (state.level == noLevel || state.level >= levels) {
+		target = coarsest(_settings.pixelError);
+	} else if (mesh.errors[state.level] * scale > _settings.pixelError) {
+		target = coarsest(_settings.pixelError);
+	} else {
+		target = std::max(state.level, coarsest(_settings.pixelError * (1.0f - _settings.hysteresis)));
+	}
+
+	if (state.level == noLevel || state.level >= levels || _settings.fadeSeconds <= 0.0f) {
+		state.level = target;
+		state.fade = 1.0f;
+	} else if (target != state.level) {
+		// Switching mid fade drops the oldest level, the new fade starts from the current one
+		state.previous = state.level;
+		state.level = target;
+		state.fade = 0.0f;
+	}
+
+	uint32_t count = 0;
+	if (state.fade < 1.0f) {
+		state.fade = std::min(state.fade + _dt / _settings.fadeSeconds, 1.0f);
+	}
+	if (state.fade < 1.0f) {
+		draws[count++] = { state.level, state.fade };
+		draws[count++] = { state.previous, state.fade - 1.0f };
+	} else {
+		draws[count++] = { state.level, 1.0f };
+	}
+	for (uint32_t i = 0; i < count; i++) {
+		_triangles += mesh.levels[draws[i].level].indexCount / 3;
+	}
+	return count;
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include "mesh.h"
+
+// One level of detail, an index range into the shared index buffer
+// error is the largest distance in mesh space between a vertex and the one it was collapsed into
+struct LodLevel {
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	float error;
+};
+
+// All levels of a mesh packed into one index array, level 0 is the original triangles
+// Simplified levels only reference existing vertices so every level shares the original vertex buffer
+struct LodBuild {
+	std::vector<uint32_t> indices;
+	std::vector<LodLevel> levels;
+	float radius;
+};
+
+// Vertex clustering: vertices are snapped to a grid of cellSize and each cell collapses into the vertex closest to its mean
+// Degenerate and duplicate triangles are dropped, error receives the largest distance a vertex moved
+std::vector<uint32_t> simplifyClusters(std::span<const glm::vec3> positions, std::span<const uint32_t> indices, float cellSize, float& error);
+
+// Builds successively coarser levels, each with at most 3/4 of the previous level's triangles,
+// until maxLevels is reached or a level drops below minTriangles
+LodBuild buildLods(std::span<const glm::vec3> positions, std::span<const uint32_t> indices, size_t maxLevels = 6, size_t minTriangles = 16);
+
+struct LodMesh {
+	std::vector<Mesh> levels;
+	std::vector<float> errors;
+	// Radius of the mesh space bounding sphere, relates errors to an object's world space sphere
+	float radius;
+};
+
+// indices must hold build.indices, narrowed to 16 bit if the vertices fit
+template<class V, class I>
+LodMesh makeLodMesh(const PackedBuffer<V>& vertices, const PackedBuffer<I>& indices, const LodBuild& build) {
+	LodMesh mesh;
+	mesh.radius = build.radius;
+	for (const LodLevel& level : build.levels) {
+		mesh.levels.push_back({
+			.vertexBuffer = vertices.buffer(),
+			.indexBuffer = indices.buffer(),
+			.indexType = IndexTypeOf<I>::value,
+			.indexCount = level.indexCount,
+			.firstIndex = level.firstIndex,
+			.vertexOffset = 0,
+		});
+		mesh.errors.push_back(level.error);
+	}
+	return mesh;
+}
+
+// A level to draw this frame, fade goes in InstanceData::color.a for shaders/lod.frag
+// 1 draws every pixel, (0, 1) draws that fraction of a dither pattern and [-1, 0) the complementary fraction
+struct LodDraw {
+	uint32_t level;
+	float fade;
+};
+
+struct LodSettings {
+	// Largest acceptable projected error in pixels
+	float pixelError = 1.0f;
+	// A coarser level is only picked once its error is this fraction below pixelError, stops flickering at the boundary
+	float hysteresis = 0.25f;
+	// Length of the dithered crossfade between levels, 0 switches instantly
+	float fadeSeconds = 0.25f;
+};
+
+// Picks a level per object from the projected screen space error and crossfades between levels over time
+class LodSelector {
+private:
+	struct State {
+		uint32_t level;
+		uint32_t previous;
+		float fade;
+	};
+	static constexpr uint32_t noLevel = UINT32_MAX;
+
+	LodSettings _settings;
+	std::vector<State> _states;
+	glm::vec3 _camera;
+	float _projectionScale;
+	float _dt;
+	size_t _triangles;
+public:
+	explicit LodSelector(const LodSettings& settings = {});
+
+	// Pixels per world unit at distance 1 for a perspective projection
+	static float projectionScale(float fovy, float viewportHeight);
+
+	uint32_t add();
+	void clear();
+
+	// Call once per frame before any select
+	void beginFrame(const glm::vec3& camera, float projectionScale, float dt);
+	// sphere is the object's world space bounds, fills draws and returns how many levels to draw (1, or 2 while fading)
+	// Call at most once per object per frame, fades advance with every call
+	uint32_t select(uint32_t object, const LodMesh& mesh, const glm::vec4& sphere, LodDraw draws[2]);
+
+	// Triangles selected since beginFrame, both levels count while fading
+	size_t triangleCount() const { return _triangles; }
+	const LodSettings& settings() const { return _settings; }
+};
\ No newline at end of file
@@ -0,0 +1,345 @@
+#include "maskedocclusion.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include <immintrin.h>
+
+// Vertices closer than this to the camera plane have no stable projection
+static constexpr float minW = 1e-4f;
+
+// Pixel spans [lo, hi] covered by a triangle on the 8 rows of tile row ty, empty rows have lo > hi
+static void rowSpans(const float* edgeA, const float* edgeB, const float* edgeC, int ty, int width, int32_t* lo, int32_t* hi)
+{
+	const int rows = MaskedOcclusion::tileHeight;
+#ifdef __AVX2__
+	__m256 y = _mm256_add_ps(_mm256_set1_ps((float)(ty * rows) + 0.5f), _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f));
+	__m256 left = _mm256_set1_ps(-1.0f);
+	__m256 right = _mm256_set1_ps((float)width);
+	for (int e = 0; e < 3; e++) {
+		// A x + B y + C >= 0 bounds x from the left when A > 0 and from the right when A < 0
+		__m256 d = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(edgeB[e]), y), _mm256_set1_ps(edgeC[e]));
+		if (edgeA[e] > 0.0f) {
+			left = _mm256_max_ps(left, _mm256_mul_ps(d, _mm256_set1_ps(-1.0f / edgeA[e])));
+		} else if (edgeA[e] < 0.0f) {
+			right = _mm256_min_ps(right, _mm256_mul_ps(d, _mm256_set1_ps(-1.0f / edgeA[e])));
+		} else {
+			left = _mm256_blendv_ps(_mm256_set1_ps((float)width), left, _mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_GE_OQ));
+		}
+	}
+	// Clamped before conversion so far off screen intercepts cannot overflow
+	left = _mm256_min_ps(left, _mm256_set1_ps((float)width));
+	right = _mm256_max_ps(right, _mm256_set1_ps(-1.0f));
+	// Pixel x is covered when its center x + 0.5 lies within [left, right]
+	__m256 half = _mm256_set1_ps(0.5f);
+	_mm256_storeu_si256((__m256i*)lo, _mm256_cvtps_epi32(_mm256_ceil_ps(_mm256_sub_ps(left, half))));
+	_mm256_storeu_si256((__m256i*)hi, _mm256_cvtps_epi32(_mm256_floor_ps(_mm256_sub_ps(right, half))));
+#else
+	for (int r = 0; r < rows; r++) {
+		float y = (float)(ty * rows + r) + 0.5f;
+		float left = -1.0f;
+		float right = (float)width;
+		for (int e = 0; e < 3; e++) {
+			float d = edgeB[e] * y + edgeC[e];
+			if (edgeA[e] > 0.0f) {
+				left = std::max(left, -d / edgeA[e]);
+			} else if (edgeA[e] < 0.0f) {
+				right = std::min(right, -d / edgeA[e]);
+			} else if (d < 0.0f) {
+				left = (float)width;
+			}
+		}
+		left = std::min(left, (float)width);
+		right = std::max(right, -1.0f);
+		lo[r] = (int32_t)std::ceil(left - 0.5f);
+		hi[r] = (int32_t)std::floor(right - 0.5f);
+	}
+#endif
+}
+
+// Coverage bits of spans [lo, hi] within the tile starting at pixel x, returns false if nothing is covered
+static bool rowMasks(const int32_t* lo, const int32_t* hi, int x, uint32_t* masks)
+{
+#ifdef __AVX2__
+	__m256i base = _mm256_set1_epi32(x);
+	__m256i first = _mm256_max_epi32(_mm256_sub_epi32(_mm256_loadu_si256((const __m256i*)lo), base), _mm256_setzero_si256());
+	__m256i last = _mm256_min_epi32(_mm256_sub_epi32(_mm256_loadu_si256((const __m256i*)hi), base), _mm256_set1_epi32(MaskedOcclusion::tileWidth - 1));
+	// Empty spans shift by 32 or more which variable shifts turn into 0
+	__m256i ones = _mm256_srlv_epi32(_mm256_set1_epi32(-1), _mm256_sub_epi32(_mm256_set1_epi32(MaskedOcclusion::tileWidth - 1), _mm256_sub_epi32(last, first)));
+	__m256i mask = _mm256_sllv_epi32(ones, first);
+	_mm256_storeu_si256((__m256i*)masks, mask);
+	return !_mm256_testz_si256(mask, mask);
+#else
+	uint32_t any = 0;
+	for (int r = 0; r < MaskedOcclusion::tileHeight; r++) {
+		int first = std::max(lo[r] - x, 0);
+		int last = std::min(hi[r] - x, MaskedOcclusion::tileWidth - 1);
+		masks[r] = last < first ? 0 : (0xFFFFFFFFu >> (MaskedOcclusion::tileWidth - 1 - (last - first))) << first;
+		any |= masks[r];
+	}
+	return any != 0;
+#endif
+}
+
+MaskedOcclusion::MaskedOcclusion(int width, int height)
+	: _tilesX((width + tileWidth - 1) / tileWidth),
+	_tilesY((height + tileHeight - 1) / tileHeight),
+	_viewProj(1.0f)
+{
+	_width = _tilesX * tileWidth;
+	_height = _tilesY * tileHeight;
+	_tiles.resize((size_t)_tilesX * _tilesY);
+	clearTiles(0, _tilesY);
+}
+
+void MaskedOcclusion::addOccluder(std::span<const glm::vec3> vertices, std::span<const uint32_t> indices)
+{
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		_occluders.push_back(vertices[indices[i]]);
+		_occluders.push_back(vertices[indices[i + 1]]);
+		_occluders.push_back(vertices[indices[i + 2]]);
+	}
+}
+
+void MaskedOcclusion::clearOccluders()
+{
+	_occluders.clear();
+}
+
+void MaskedOcclusion::clearTiles(int tileRowBegin, int tileRowEnd)
+{
+	for (int ty = tileRowBegin; ty < tileRowEnd; ty++) {
+		for (int tx = 0; tx < _tilesX; tx++) {
+			Tile& tile = _tiles[(size_t)ty * _tilesX + tx];
+			std::fill(std::begin(tile.mask), std::end(tile.mask), 0u);
+			tile.z0 = 1.0f;
+			tile.z1 = 0.0f;
+		}
+	}
+}
+
+bool MaskedOcclusion::setup(const glm::vec3* v, const glm::mat4& viewProj, Triangle& out) const
+{
+	float x[3], y[3], z[3];
+	for (int i = 0; i < 3; i++) {
+		glm::vec4 clip = viewProj * glm::vec4(v[i], 1.0f);
+		// Occluders are optional, dropping triangles that cross the camera plane only loses culling
+		if (clip.w <= minW) {
+			return false;
+		}
+		x[i] = (clip.x / clip.w * 0.5f + 0.5f) * (float)_width;
+		y[i] = (clip.y / clip.w * 0.5f + 0.5f) * (float)_height;
+		z[i] = clip.z / clip.w;
+	}
+
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+	if (!(std::abs(area) > 0.0f)) {
+		return false;
+	}
+	// Occluders are double sided, wind everything the same way
+	if (area < 0.0f) {
+		std::swap(x[1], x[2]);
+		std::swap(y[1], y[2]);
+		std::swap(z[1], z[2]);
+		area = -area;
+	}
+
+	out.zMax = std::max(std::max(z[0], z[1]), z[2]);
+	if (out.zMax > 1.0f) {
+		return false;
+	}
+	out.minX = std::max((int)std::floor(std::min(std::min(x[0], x[1]), x[2])), 0);
+	out.minY = std::max((int)std::floor(std::min(std::min(y[0], y[1]), y[2])), 0);
+	out.maxX = std::min((int)std::floor(std::max(std::max(x[0], x[1]), x[2])), _width - 1);
+	out.maxY = std::min((int)std::floor(std::max(std::max(y[0], y[1]), y[2])), _height - 1);
+	if (out.minX > out.maxX || out.minY > out.maxY) {
+		return false;
+	}
+
+	for (int e = 0; e < 3; e++) {
+		int n = (e + 1) % 3;
+		out.edgeA[e] = y[e] - y[n];
+		out.edgeB[e] = x[n] - x[e];
+		out.edgeC[e] = -(out.edgeA[e] * x[e] + out.edgeB[e] * y[e]);
+	}
+	out.zA = ((z[1] - z[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (z[2] - z[0])) / area;
+	out.zB = ((x[1] - x[0]) * (z[2] - z[0]) - (z[1] - z[0]) * (x[2] - x[0])) / area;
+	out.zC = z[0] - out.zA * x[0] - out.zB * y[0];
+	return true;
+}
+
+void MaskedOcclusion::rasterize(const Triangle& tri, int tileRowBegin, int tileRowEnd)
+{
+	int firstRow = std::max(tri.minY / tileHeight, tileRowBegin);
+	int lastRow = std::min(tri.maxY / tileHeight, tileRowEnd - 1);
+	alignas(32) int32_t lo[tileHeight];
+	alignas(32) int32_t hi[tileHeight];
+	alignas(32) uint32_t coverage[tileHeight];
+	for (int ty = firstRow; ty <= lastRow; ty++) {
+		rowSpans(tri.edgeA, tri.edgeB, tri.edgeC, ty, _width, lo, hi);
+		for (int tx = tri.minX / tileWidth; tx <= tri.maxX / tileWidth; tx++) {
+			if (!rowMasks(lo, hi, tx * tileWidth, coverage)) {
+				continue;
+			}
+
+			// Farthest depth of the triangle over the part of the tile it can touch, the plane is linear so a corner holds it
+			float x0 = (float)std::max(tx * tileWidth, tri.minX);
+			float x1 = (float)std::min((tx + 1) * tileWidth, tri.maxX + 1);
+			float y0 = (float)std::max(ty * tileHeight, tri.minY);
+			float y1 = (float)std::min((ty + 1) * tileHeight, tri.maxY + 1);
+			float zx0 = tri.zA * x0 + tri.zC;
+			float zx1 = tri.zA * x1 + tri.zC;
+			float z = std::max(std::max(zx0, zx1) + tri.zB * y0, std::max(zx0, zx1) + tri.zB * y1);
+			z = std::min(z, tri.zMax);
+
+			Tile& tile = _tiles[(size_t)ty * _tilesX + tx];
+			if (z >= tile.z0) {
+				continue;
+			}
+			// A working layer far behind the new triangle only holds z1 back, start a new one instead
+			if (tile.z1 - z > tile.z0 - tile.z1) {
+				std::fill(std::begin(tile.mask), std::end(tile.mask), 0u);
+				tile.z1 = 0.0f;
+			}
+			tile.z1 = std::max(tile.z1, z);
+#ifdef __AVX2__
+			__m256i mask = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)tile.mask), _mm256_load_si256((const __m256i*)coverage));
+			bool full = _mm256_testc_si256(mask, _mm256_set1_epi32(-1));
+			_mm256_storeu_si256((__m256i*)tile.mask, mask);
+#else
+			bool full = true;
+			for (int r = 0; r < tileHeight; r++) {
+				tile.mask[r] |= coverage[r];
+				full = full && tile.mask[r] == 0xFFFFFFFFu;
+			}
+#endif
+			// Fully covered, the working layer becomes the bound for the whole tile
+			if (full) {
+				tile.z0 = tile.z1;
+				tile.z1 = 0.0f;
+				std::fill(std::begin(tile.mask), std::end(tile.mask), 0u);
+			}
+		}
+	}
+}
+
+void MaskedOcclusion::render(const glm::mat4& viewProj)
+{
+	_viewProj = viewProj;
+	clearTiles(0, _tilesY);
+	Triangle tri;
+	for (size_t i = 0; i < _occluders.size(); i += 3) {
+		if (setup(&_occluders[i], viewProj, tri)) {
+			rasterize(tri, 0, _tilesY);
+		}
+	}
+}
+
+void MaskedOcclusion::render(const glm::mat4& viewProj, JobSystem& jobs)
+{
+	size_t triangles = occluderTriangles();
+	if (triangles <= setupChunkSize) {
+		render(viewProj);
+		return;
+	}
+	_viewProj = viewProj;
+
+	// Bands of whole tile rows never share a tile, so each can be rasterized by a different thread
+	int bands = std::min(_tilesY, (int)jobs.threadCount() * 2);
+	int bandRows = (_tilesY + bands - 1) / bands;
+	size_t chunks = (triangles + setupChunkSize - 1) / setupChunkSize;
+	_chunkTriangles.resize(chunks);
+	_bins.resize(chunks * bands);
+
+	jobs.parallelFor(triangles, setupChunkSize, [&](size_t begin, size_t end) {
+		size_t chunk = begin / setupChunkSize;
+		std::vector<Triangle>& tris = _chunkTriangles[chunk];
+		tris.clear();
+		for (int b = 0; b < bands; b++) {
+			_bins[chunk * bands + b].clear();
+		}
+		Triangle tri;
+		for (size_t i = begin; i < end; i++) {
+			if (!setup(&_occluders[i * 3], viewProj, tri)) {
+				continue;
+			}
+			uint32_t index = (uint32_t)tris.size();
+			tris.push_back(tri);
+			for (int b = tri.minY / tileHeight / bandRows; b <= tri.maxY / tileHeight / bandRows; b++) {
+				_bins[chunk * bands + b].push_back(index);
+			}
+		}
+	});
+
+	jobs.parallelFor(bands, 1, [&](size_t begin, size_t end) {
+		for (size_t b = begin; b < end; b++) {
+			int rowBegin = (int)b * bandRows;
+			int rowEnd = std::min(rowBegin + bandRows, _tilesY);
+			clearTiles(rowBegin, rowEnd);
+			// Chunks are walked in order so the result matches the serial path exactly
+			for (size_t chunk = 0; chunk < chunks; chunk++) {
+				for (uint32_t index : _bins[chunk * bands + b]) {
+					rasterize(_chunkTriangles[chunk][index], rowBegin, rowEnd);
+				}
+			}
+		}
+	});
+}
+
+bool MaskedOcclusion::visible(const glm::vec4& sphere) const
+{
+	float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+	float nearestZ = 1.0f;
+	for (int c = 0; c < 8; c++) {
+		glm::vec3 corner = glm::vec3(sphere) + sphere.w * glm::vec3((c & 1) ? 1.0f : -1.0f, (c & 2) ? 1.0f : -1.0f, (c & 4) ? 1.0f : -1.0f);
+		glm::vec4 clip = _viewProj * glm::vec4(corner, 1.0f);
+		// Crossing the camera plane, the projection is unbounded so never cull
+		if (clip.w <= minW) {
+			return true;
+		}
+		float x = (clip.x / clip.w * 0.5f + 0.5f) * (float)_width;
+		float y = (clip.y / clip.w * 0.5f + 0.5f) * (float)_height;
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+		nearestZ = std::min(nearestZ, clip.z / clip.w);
+	}
+
+	// Every pixel the rectangle touches, rounded outwards
+	int x0 = std::max((int)std::floor(minX), 0);
+	int y0 = std::max((int)std::floor(minY), 0);
+	int x1 = std::min((int)std::floor(maxX), _width - 1);
+	int y1 = std::min((int)std::floor(maxY), _height - 1);
+	// Off screen objects are left to the frustum culler
+	if (x0 > x1 || y0 > y1) {
+		return true;
+	}
+
+	for (int ty = y0 / tileHeight; ty <= y1 / tileHeight; ty++) {
+		for (int tx = x0 / tileWidth; tx <= x1 / tileWidth; tx++) {
+			const Tile& tile = _tiles[(size_t)ty * _tilesX + tx];
+			int first = std::max(x0 - tx * tileWidth, 0);
+			int last = std::min(x1 - tx * tileWidth, tileWidth - 1);
+			uint32_t columns = (0xFFFFFFFFu >> (tileWidth - 1 - (last - first))) << first;
+			// Only pixels outside the working layer are limited to z0, covered ones to z1
+			bool outsideLayer = false;
+			for (int r = 0; r < tileHeight; r++) {
+				int y = ty * tileHeight + r;
+				if (y >= y0 && y <= y1) {
+					outsideLayer = outsideLayer || (columns & ~tile.mask[r]) != 0;
+				}
+			}
+			if (nearestZ < (outsideLayer ? tile.z0 : tile.z1)) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void MaskedOcclusion::cull(std::vector<uint32_t>& visible, std::span<const glm::vec4> spheres) const
+{
+	visible.erase(std::remove_if(visible.begin(), visible.end(), [&](uint32_t i) { return !this->visible(spheres[i]); }), visible.end());
+}
\ No newline at end of file
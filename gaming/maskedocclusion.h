@@ -0,0 +1,76 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+#include "jobsystem.h"
+
+// CPU occlusion culling with a low resolution masked depth buffer
+// The screen is split into 32x8 pixel tiles, each holding a coverage bit per pixel and two depths:
+// z0 bounds every pixel of the tile, z1 bounds the pixels whose bit is set. Occluder triangles only
+// ever lower those bounds so the buffer is conservative, objects whose nearest depth is behind them are hidden
+// Coverage masks are built 8 rows at a time with AVX2 when built with GAMING_AVX2
+// Depth is 0 at the near plane and 1 at the far plane
+class MaskedOcclusion {
+public:
+	static constexpr int tileWidth = 32;
+	static constexpr int tileHeight = 8;
+	static constexpr size_t setupChunkSize = 1024;
+private:
+	struct Tile {
+		uint32_t mask[tileHeight];
+		float z0;
+		float z1;
+	};
+
+	// Screen space triangle, edge functions are >= 0 inside and z is a plane over pixel coordinates
+	struct Triangle {
+		float edgeA[3];
+		float edgeB[3];
+		float edgeC[3];
+		float zA, zB, zC;
+		float zMax;
+		int minX, minY, maxX, maxY;
+	};
+
+	int _width;
+	int _height;
+	int _tilesX;
+	int _tilesY;
+	std::vector<Tile> _tiles;
+	// World space occluder triangles, three vertices each
+	std::vector<glm::vec3> _occluders;
+	// Per setup chunk triangles and, for the binned path, per chunk and band triangle indices
+	std::vector<std::vector<Triangle>> _chunkTriangles;
+	std::vector<std::vector<uint32_t>> _bins;
+	glm::mat4 _viewProj;
+
+	bool setup(const glm::vec3* v, const glm::mat4& viewProj, Triangle& out) const;
+	void rasterize(const Triangle& tri, int tileRowBegin, int tileRowEnd);
+	void clearTiles(int tileRowBegin, int tileRowEnd);
+public:
+	// Rounded up to whole tiles
+	MaskedOcclusion(int width = 256, int height = 128);
+
+	void addOccluder(std::span<const glm::vec3> vertices, std::span<const uint32_t> indices);
+	void clearOccluders();
+	size_t occluderTriangles() const { return _occluders.size() / 3; }
+
+	// Clears the buffer and rasterizes every occluder
+	void render(const glm::mat4& viewProj);
+	// Same as render, triangle setup is split across threads and binned into bands of tile rows
+	// which are then rasterized in parallel, each band keeping the serial triangle order
+	void render(const glm::mat4& viewProj, JobSystem& jobs);
+
+	// sphere is xyz world space center and w radius, tested against the last render
+	bool visible(const glm::vec4& sphere) const;
+	// Removes the indices of occluded spheres from visible, keeping the order of the rest
+	void cull(std::vector<uint32_t>& visible, std::span<const glm::vec4> spheres) const;
+
+	int width() const { return _width; }
+	int height() const { return _height; }
+};
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <span>
+#include <variant>
+
+#include "vkbuffer.h"
+#include "meshformat.h"
+
+// A range of indexed geometry inside a vertex/index buffer pair, the unit draws are batched and sorted by
+struct Mesh {
+	VkBuffer vertexBuffer;
+	VkBuffer indexBuffer;
+	VkIndexType indexType;
+	uint32_t indexCount;
+	uint32_t firstIndex;
+	int32_t vertexOffset;
+};
+
+template<class V, class I>
+Mesh makeMesh(const PackedBuffer<V>& vertices, const PackedBuffer<I>& indices) {
+	return {
+		.vertexBuffer = vertices.buffer(),
+		.indexBuffer = indices.buffer(),
+		.indexType = IndexTypeOf<I>::value,
+		.indexCount = (uint32_t)indices.size(),
+		.firstIndex = 0,
+		.vertexOffset = 0,
+	};
+}
+
+// The same geometry read from another vertex stream in the same vertex order, e.g. a positionStream for a depth prepass
+template<class V>
+Mesh withVertexStream(Mesh mesh, const PackedBuffer<V>& vertices) {
+	mesh.vertexBuffer = vertices.buffer();
+	return mesh;
+}
+
+// Vertex and index buffers of one mesh, indices are 16 bit whenever every vertex fits (fitsIndex16)
+// which halves index memory and bandwidth for the common case of meshes under 64K vertices
+template<class V>
+struct MeshBuffers {
+	PackedBuffer<V> vertices;
+	std::variant<IndexBuffer16, IndexBuffer> indices;
+
+	Mesh mesh() const {
+		return std::visit([&](const auto& i) { return makeMesh(vertices, i); }, indices);
+	}
+};
+
+template<class V>
+MeshBuffers<V> makeMeshBuffers(const VkCtx& ctx, std::vector<V> vertices, std::span<const uint32_t> indices) {
+	bool narrow = fitsIndex16(vertices.size());
+	PackedBuffer<V> vertexBuffer(ctx, std::move(vertices), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+	if (narrow) {
+		return { std::move(vertexBuffer), IndexBuffer16(ctx, std::vector<uint16_t>(indices.begin(), indices.end()), VK_BUFFER_USAGE_INDEX_BUFFER_BIT) };
+	}
+	return { std::move(vertexBuffer), IndexBuffer(ctx, std::vector<uint32_t>(indices.begin(), indices.end()), VK_BUFFER_USAGE_INDEX_BUFFER_BIT) };
+}
+
+// Loads a mesh written by meshtool
+inline MeshBuffers<DefaultVertex> loadMesh(const VkCtx& ctx, const std::string& path) {
+	MeshData data = readMeshFile(path);
+	return makeMeshBuffers(ctx, std::move(data.vertices), data.indices);
+}
\ No newline at end of file
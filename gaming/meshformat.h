@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glm/vec4.hpp>
+
+#include "defaultvertex.h"
+
+// A cluster of at most meshletMaxVertices vertices and meshletMaxTriangles triangles, a contiguous range of the mesh's indices
+// Layout matches Cluster in shaders/cluster_cull.comp (std430)
+struct Meshlet {
+	// Mesh space bounding sphere, xyz center and w radius
+	glm::vec4 sphere;
+	// Every triangle's normal is within the cone around xyz, w is the sine of the cone's half angle
+	// The cluster faces away from a viewer at v when dot(center - v, axis) >= w * |center - v| + radius,
+	// w is 1 when the normals spread 90 degrees or more so the test never passes
+	glm::vec4 cone;
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	uint32_t pad0;
+	uint32_t pad1;
+};
+
+constexpr uint32_t meshletMaxVertices = 64;
+constexpr uint32_t meshletMaxTriangles = 124;
+
+// Binary mesh produced by meshtool: a MeshFileHeader, vertexCount DefaultVertex, indexCount indices of indexSize bytes,
+// then meshletCount Meshlet
+// Indices are stored as 16 bit whenever every vertex can be addressed with them
+struct MeshFileHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	uint32_t indexSize;
+	uint32_t meshletCount;
+};
+
+constexpr uint32_t meshFileMagic = 0x48534D47; // "GMSH"
+constexpr uint32_t meshFileVersion = 2;
+
+struct MeshData {
+	std::vector<DefaultVertex> vertices;
+	std::vector<uint32_t> indices;
+	std::vector<Meshlet> meshlets;
+};
+
+// 0xFFFF is left free so primitive restart can be enabled on 16 bit meshes
+inline bool fitsIndex16(size_t vertexCount) {
+	return vertexCount < 0xFFFF;
+}
+
+inline MeshData readMeshFile(const std::string& path) {
+	std::ifstream in(path, std::ios::binary);
+	if (!in) {
+		throw std::runtime_error("Cannot open mesh " + path);
+	}
+	MeshFileHeader header;
+	in.read((char*)&header, sizeof(header));
+	if (!in || header.magic != meshFileMagic || header.version != meshFileVersion || (header.indexSize != 2 && header.indexSize != 4)) {
+		throw std::runtime_error("Not a mesh file " + path);
+	}
+
+	MeshData mesh;
+	mesh.vertices.resize(header.vertexCount);
+	in.read((char*)mesh.vertices.data(), header.vertexCount * sizeof(DefaultVertex));
+	mesh.indices.resize(header.indexCount);
+	if (header.indexSize == 2) {
+		std::vector<uint16_t> narrow(header.indexCount);
+		in.read((char*)narrow.data(), header.indexCount * sizeof(uint16_t));
+		mesh.indices.assign(narrow.begin(), narrow.end());
+	} else {
+		in.read((char*)mesh.indices.data(), header.indexCount * sizeof(uint32_t));
+	}
+	mesh.meshlets.resize(header.meshletCount);
+	in.read((char*)mesh.meshlets.data(), header.meshletCount * sizeof(Meshlet));
+	if (!in) {
+		throw std::runtime_error("Truncated mesh " + path);
+	}
+	return mesh;
+}
+
+inline void writeMeshFile(const std::string& path, const MeshData& mesh) {
+	std::ofstream out(path, std::ios::binary);
+	if (!out) {
+		throw std::runtime_error("Cannot write mesh " + path);
+	}
+	bool narrow = fitsIndex16(mesh.vertices.size());
+	MeshFileHeader header = {
+		.magic = meshFileMagic,
+		.version = meshFileVersion,
+		.vertexCount = (uint32_t)mesh.vertices.size(),
+		.indexCount = (uint32_t)mesh.indices.size(),
+		.indexSize = narrow ? 2u : 4u,
+		.meshletCount = (uint32_t)mesh.meshlets.size(),
+	};
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)mesh.vertices.data(), mesh.vertices.size() * sizeof(DefaultVertex));
+	if (narrow) {
+		std::vector<uint16_t> indices(mesh.indices.begin(), mesh.indices.end());
+		out.write((const char*)indices.data(), indices.size() * sizeof(uint16_t));
+	} else {
+		out.write((const char*)mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+	}
+	out.write((const char*)mesh.meshlets.data(), mesh.meshlets.size() * sizeof(Meshlet));
+}
\ No newline at end of file
@@ -0,0 +1,195 @@
+#include "multiviewtarget.h"
+
+#include <stdexcept>
+
+#include "defaultvertex.h"
+#include "vkimage.h"
+
+static uint32_t gridColumns(uint32_t viewCount)
+{
+	return viewCount > 1 ? 2 : 1;
+}
+
+static uint32_t gridRows(uint32_t viewCount)
+{
+	return (viewCount + gridColumns(viewCount) - 1) / gridColumns(viewCount);
+}
+
+MultiviewTarget::MultiviewTarget(const VkCtx& ctx, VkFormat colorFormat, VkExtent2D viewExtent, uint32_t viewCount)
+	: _colorImage(VK_NULL_HANDLE),
+	_colorAlloc(nullptr),
+	_colorView(VK_NULL_HANDLE),
+	_depthImage(VK_NULL_HANDLE),
+	_depthAlloc(nullptr),
+	_depthView(VK_NULL_HANDLE),
+	_renderPass(VK_NULL_HANDLE),
+	_framebuffer(VK_NULL_HANDLE),
+	_viewExtent(viewExtent),
+	_viewCount(viewCount)
+{
+	if (!ctx.features11().multiview) {
+		throw std::runtime_error("Device does not support multiview");
+	}
+	if (viewCount == 0 || viewCount > maxMultiviewViews) {
+		throw std::runtime_error("Unsupported multiview view count");
+	}
+
+	VkFormat depthFormat = VK_FORMAT_D32_SFLOAT;
+	createDeviceImage(ctx, colorFormat, viewExtent, viewCount, VK_IMAGE_VIEW_TYPE_2D_ARRAY, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+		VK_IMAGE_ASPECT_COLOR_BIT, _colorImage, _colorAlloc, _colorView);
+	createDeviceImage(ctx, depthFormat, viewExtent, viewCount, VK_IMAGE_VIEW_TYPE_2D_ARRAY, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+		VK_IMAGE_ASPECT_DEPTH_BIT, _depthImage, _depthAlloc, _depthView);
+
+	VkAttachmentDescription descs[] = {
+		{
+			.format = colorFormat,
+			.samples = VK_SAMPLE_COUNT_1_BIT,
+			.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+			.storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+			.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+			.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+			.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+			.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		},
+		{
+			.format = depthFormat,
+			.samples = VK_SAMPLE_COUNT_1_BIT,
+			.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+			.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+			.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+			.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+			.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+			.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+		},
+	};
+
+	VkAttachmentReference colorRef = {
+		.attachment = 0,
+		.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+	};
+	VkAttachmentReference depthRef = {
+		.attachment = 1,
+		.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+	};
+	VkSubpassDescription subpassDesc = {
+		.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+		.colorAttachmentCount = 1,
+		.pColorAttachments = &colorRef,
+		.pDepthStencilAttachment = &depthRef,
+	};
+
+	VkSubpassDependency deps[] = {
+		{
+			.srcSubpass = VK_SUBPASS_EXTERNAL,
+			.dstSubpass = 0,
+			.srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+			.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+			.srcAccessMask = 0,
+			.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+		},
+		{
+			.srcSubpass = 0,
+			.dstSubpass = VK_SUBPASS_EXTERNAL,
+			.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT,
+			.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+			.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+		},
+	};
+
+	// Views are spatially close cameras of the same scene, so the implementation may share work between them
+	uint32_t viewMask = (1u << viewCount) - 1;
+	VkRenderPassMultiviewCreateInfo multiviewInfo = {
+		.sType = VK_STRUCTURE_TYPE_RENDER_PASS_MULTIVIEW_CREATE_INFO,
+		.subpassCount = 1,
+		.pViewMasks = &viewMask,
+		.correlationMaskCount = 1,
+		.pCorrelationMasks = &viewMask,
+	};
+
+	VkRenderPassCreateInfo renderpassInfo = {
+		.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+		.pNext = &multiviewInfo,
+		.attachmentCount = 2,
+		.pAttachments = descs,
+		.subpassCount = 1,
+		.pSubpasses = &subpassDesc,
+		.dependencyCount = 2,
+		.pDependencies = deps,
+	};
+	CHK_ERR(vkCreateRenderPass(ctx.device(), &renderpassInfo, nullptr, &_renderPass));
+
+	// With multiview the framebuffer has one layer, the views select the attachment layers
+	VkImageView views[] = { _colorView, _depthView };
+	VkFramebufferCreateInfo framebufferInfo = {
+		.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+		.renderPass = _renderPass,
+		.attachmentCount = 2,
+		.pAttachments = views,
+		.width = viewExtent.width,
+		.height = viewExtent.height,
+		.layers = 1,
+	};
+	CHK_ERR(vkCreateFramebuffer(ctx.device(), &framebufferInfo, nullptr, &_framebuffer));
+}
+
+void MultiviewTarget::destroy(const VkCtx& ctx)
+{
+	vkDestroyFramebuffer(ctx.device(), _framebuffer, nullptr);
+	vkDestroyRenderPass(ctx.device(), _renderPass, nullptr);
+	vkDestroyImageView(ctx.device(), _depthView, nullptr);
+	vmaDestroyImage(ctx.allocator(), _depthImage, _depthAlloc);
+	vkDestroyImageView(ctx.device(), _colorView, nullptr);
+	vmaDestroyImage(ctx.allocator(), _colorImage, _colorAlloc);
+}
+
+VkExtent2D MultiviewTarget::splitExtent(VkExtent2D windowExtent, uint32_t viewCount)
+{
+	return { windowExtent.width / gridColumns(viewCount), windowExtent.height / gridRows(viewCount) };
+}
+
+void MultiviewTarget::composite(VkCommandBuffer buf, VkImage target, VkExtent2D targetExtent) const
+{
+	// Cleared first so cells no view covers (3 views in a 2x2 grid) are black
+	VkImageMemoryBarrier toTransfer = {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+		.srcAccessMask = 0,
+		.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+		.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+		.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.image = target,
+		.subresourceRange = {
+			.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+			.baseMipLevel = 0,
+			.levelCount = 1,
+			.baseArrayLayer = 0,
+			.layerCount = 1,
+		},
+	};
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+	VkClearColorValue black = {};
+	vkCmdClearColorImage(buf, target, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &black, 1, &toTransfer.subresourceRange);
+	VkMemoryBarrier cleared = {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+	};
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &cleared, 0, nullptr, 0, nullptr);
+
+	uint32_t columns = gridColumns(_viewCount);
+	VkExtent2D cell = splitExtent(targetExtent, _viewCount);
+	for (uint32_t i = 0; i < _viewCount; i++) {
+		int32_t x = (int32_t)((i % columns) * cell.width);
+		int32_t y = (int32_t)((i / columns) * cell.height);
+		VkImageBlit region = {
+			.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, i, 1 },
+			.srcOffsets = { { 0, 0, 0 }, { (int32_t)_viewExtent.width, (int32_t)_viewExtent.height, 1 } },
+			.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
+			.dstOffsets = { { x, y, 0 }, { x + (int32_t)cell.width, y + (int32_t)cell.height, 1 } },
+		};
+		vkCmdBlitImage(buf, _colorImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, target, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region, VK_FILTER_LINEAR);
+	}
+}
\ No newline at end of file
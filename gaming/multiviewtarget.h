@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+
+#include "vkctx.h"
+
+// Layered offscreen target rendered by one multiview pass (VK_KHR_multiview, core in 1.1)
+// Every draw recorded in the pass is broadcast to all views, each writing its own array layer, so split-screen
+// players or extra cameras cost one set of draw commands instead of one per view
+// Pipelines are created against renderPass() as usual, the vertex shader selects the view's camera with
+// gl_ViewIndex (shaders/instanced_multiview.vert with a MultiviewCameraUniform)
+class MultiviewTarget {
+private:
+	VkImage _colorImage;
+	VmaAllocation _colorAlloc;
+	VkImageView _colorView;
+	VkImage _depthImage;
+	VmaAllocation _depthAlloc;
+	VkImageView _depthView;
+	VkRenderPass _renderPass;
+	VkFramebuffer _framebuffer;
+	VkExtent2D _viewExtent;
+	uint32_t _viewCount;
+public:
+	// viewExtent is the size of one view, colorFormat must support blits to the window (the swapchain format does)
+	MultiviewTarget(const VkCtx& ctx, VkFormat colorFormat, VkExtent2D viewExtent, uint32_t viewCount);
+	void destroy(const VkCtx& ctx);
+
+	// Splits the window into a grid of viewCount cells, 2 views side by side, 3-4 in a 2x2 grid
+	static VkExtent2D splitExtent(VkExtent2D windowExtent, uint32_t viewCount);
+
+	// Blits each view into its grid cell of target, the pass must have ended
+	// target is left in TRANSFER_DST_OPTIMAL for WindowSwapchain::overlayPass, which presents it
+	void composite(VkCommandBuffer buf, VkImage target, VkExtent2D targetExtent) const;
+
+	VkRenderPass renderPass() const { return _renderPass; }
+	VkFramebuffer framebuffer() const { return _framebuffer; }
+	VkImageView colorView() const { return _colorView; }
+	VkExtent2D viewExtent() const { return _viewExtent; }
+	uint32_t viewCount() const { return _viewCount; }
+};
\ No newline at end of file
@@ -0,0 +1,305 @@
+#include "particlesystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <glm/glm.hpp>
+
+static constexpr uint32_t groupSize = 256;
+// Elements one group sorts in shared memory with two per thread, matches shaders/particle_sort.comp
+static constexpr uint32_t sortBlock = 1024;
+static constexpr uint32_t sortGroupSize = sortBlock / 2;
+// Push constants of every particle pass fit in this range
+static constexpr uint32_t pushSize = 64;
+
+// Mirrors ParticleState in the shaders, the indirect arguments come first at fixed offsets
+static constexpr VkDeviceSize dispatchOffset = 0;
+static constexpr VkDeviceSize drawOffset = 16;
+static constexpr VkDeviceSize stateSize = 48;
+
+// Modes of shaders/particle_update.comp
+enum UpdateMode : uint32_t {
+	UpdateReset = 0,
+	UpdatePrepare = 1,
+	UpdateFinalize = 2,
+};
+
+// Modes of shaders/particle_sort.comp
+enum SortMode : uint32_t {
+	SortLocal = 0,
+	SortGlobalStep = 1,
+	SortLocalMerge = 2,
+};
+
+// Matches ParticleData in the shaders (std430)
+struct GpuParticle {
+	glm::vec4 positionAge;
+	glm::vec4 velocityLifetime;
+	glm::vec4 color;
+};
+
+static VkDescriptorSetLayout createParticleSetLayout(const VkCtx& ctx)
+{
+	VkDescriptorSetLayoutBinding bindings[7];
+	for (uint32_t i = 0; i < 7; i++) {
+		bindings[i] = {
+			.binding = i,
+			.descriptorType = i == 5 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
+				: i == 6 ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.descriptorCount = 1,
+			.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+		};
+	}
+	VkDescriptorSetLayoutCreateInfo descriptorLayoutInfo = {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+		.bindingCount = 7,
+		.pBindings = bindings,
+	};
+	VkDescriptorSetLayout descriptorLayout;
+	CHK_ERR(vkCreateDescriptorSetLayout(ctx.device(), &descriptorLayoutInfo, nullptr, &descriptorLayout));
+	return descriptorLayout;
+}
+
+// Shared by the compute passes and the draw, only compute uses push constants
+static VkPipelineLayout createParticleLayout(const VkCtx& ctx, VkDescriptorSetLayout descriptorLayout)
+{
+	VkPushConstantRange pushRange = {
+		.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+		.offset = 0,
+		.size = pushSize,
+	};
+	VkPipelineLayoutCreateInfo info = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+		.setLayoutCount = 1,
+		.pSetLayouts = &descriptorLayout,
+		.pushConstantRangeCount = 1,
+		.pPushConstantRanges = &pushRange,
+	};
+	VkPipelineLayout layout;
+	CHK_ERR(vkCreatePipelineLayout(ctx.device(), &info, nullptr, &layout));
+	return layout;
+}
+
+static uint32_t sortSizeFor(uint32_t capacity)
+{
+	uint32_t size = sortBlock;
+	while (size < capacity) {
+		size <<= 1;
+	}
+	return size;
+}
+
+static void computeBarrier(VkCommandBuffer buf, VkPipelineStageFlags dstStages, VkAccessFlags dstAccess)
+{
+	VkMemoryBarrier written = {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+		.dstAccessMask = dstAccess,
+	};
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, dstStages, 0, 1, &written, 0, nullptr, 0, nullptr);
+}
+
+ParticleSystem::ParticleSystem(const VkCtx& ctx, DescriptorAllocator& descriptors, const ShaderModule& updateShader, const ShaderModule& emitShader,
+	const ShaderModule& simulateShader, const ShaderModule& sortShader, const ShaderModule& vertexShader, const ShaderModule& fragmentShader,
+	VkRenderPass renderPass, VkImageView depthView, VkExtent2D depthExtent, size_t frames, uint32_t capacity, BlendMode blend)
+	: _particles(ctx, capacity * sizeof(GpuParticle), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT),
+	_deadList(ctx, capacity * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT),
+	_aliveLists(ctx, 2 * capacity * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT),
+	_state(ctx, stateSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT),
+	_sortKeys(ctx, sortSizeFor(capacity) * 2 * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT),
+	_uniform(ctx, frames),
+	_sampler(VK_NULL_HANDLE),
+	_descriptorLayout(createParticleSetLayout(ctx)),
+	_layout(createParticleLayout(ctx, _descriptorLayout)),
+	_set(descriptors.allocate(ctx, _descriptorLayout)),
+	_update(ctx, _layout, updateShader),
+	_emit(ctx, _layout, emitShader),
+	_simulate(ctx, _layout, simulateShader),
+	_sort(ctx, _layout, sortShader),
+	_render(ctx, _layout, vertexShader, fragmentShader, renderPass, noVertexInput, DepthMode::ReadOnly, blend),
+	_capacity(capacity),
+	_sortSize(sortSizeFor(capacity)),
+	_parity(0),
+	_seed(0),
+	_time(0.0f),
+	_depthExtent(depthExtent),
+	_blend(blend),
+	_initialized(false)
+{
+	if (!ctx.supportsSubgroupOps(VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_BALLOT_BIT)) {
+		throw std::runtime_error("Particle simulation needs subgroup ballot in compute shaders");
+	}
+	// Reads use texelFetch, the sampler only exists to satisfy the combined image sampler binding
+	VkSamplerCreateInfo samplerInfo = {
+		.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+		.magFilter = VK_FILTER_NEAREST,
+		.minFilter = VK_FILTER_NEAREST,
+		.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+		.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		.maxLod = VK_LOD_CLAMP_NONE,
+	};
+	CHK_ERR(vkCreateSampler(ctx.device(), &samplerInfo, nullptr, &_sampler));
+
+	DescriptorBindings()
+		.buffer(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _particles.buffer())
+		.buffer(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _deadList.buffer())
+		.buffer(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _aliveLists.buffer())
+		.buffer(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _state.buffer())
+		.buffer(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _sortKeys.buffer())
+		.buffer(5, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, _uniform.buffer(), 0, sizeof(SimulationUniform))
+		.image(6, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, depthView, _sampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+		.write(ctx, _set);
+}
+
+void ParticleSystem::destroy(const VkCtx& ctx)
+{
+	_render.destroy(ctx);
+	_sort.destroy(ctx);
+	_simulate.destroy(ctx);
+	_emit.destroy(ctx);
+	_update.destroy(ctx);
+	vkDestroyPipelineLayout(ctx.device(), _layout, nullptr);
+	vkDestroyDescriptorSetLayout(ctx.device(), _descriptorLayout, nullptr);
+	vkDestroySampler(ctx.device(), _sampler, nullptr);
+}
+
+void ParticleSystem::runUpdate(VkCommandBuffer buf, uint32_t mode, uint32_t groups)
+{
+	vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_COMPUTE, _update.pipeline());
+	vkCmdPushConstants(buf, _layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(mode), &mode);
+	vkCmdDispatch(buf, groups, 1, 1);
+}
+
+void ParticleSystem::sort(VkCommandBuffer buf)
+{
+	// Bitonic sort of the alive particles' depth keys, padded to _sortSize with keys that sort last
+	// Steps within a sortBlock run in shared memory, only the wider steps of the late stages go through memory
+	struct SortConstants {
+		uint32_t k;
+		uint32_t j;
+		uint32_t mode;
+	};
+	vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_COMPUTE, _sort.pipeline());
+	SortConstants constants = { sortBlock, 0, SortLocal };
+	vkCmdPushConstants(buf, _layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+	vkCmdDispatch(buf, _sortSize / sortBlock, 1, 1);
+	computeBarrier(buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+	for (uint32_t k = sortBlock * 2; k <= _sortSize; k <<= 1) {
+		for (uint32_t j = k / 2; j >= sortBlock; j >>= 1) {
+			constants = { k, j, SortGlobalStep };
+			vkCmdPushConstants(buf, _layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+			// One thread per compared pair
+			vkCmdDispatch(buf, _sortSize / 2 / sortGroupSize, 1, 1);
+			computeBarrier(buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+		}
+		constants = { k, sortBlock / 2, SortLocalMerge };
+		vkCmdPushConstants(buf, _layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+		vkCmdDispatch(buf, _sortSize / sortBlock, 1, 1);
+		computeBarrier(buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+	}
+}
+
+void ParticleSystem::update(VkCommandBuffer buf, size_t frame, float deltaTime, const glm::mat4& view, const glm::mat4& proj,
+	std::span<const ParticleEmitter> emitters, const ParticleForces& forces)
+{
+	_time += deltaTime;
+	glm::mat4 viewProj = proj * view;
+	SimulationUniform uniform = {
+		.view = view,
+		.viewProj = viewProj,
+		.invViewProj = glm::inverse(viewProj),
+		.gravityDrag = glm::vec4(forces.gravity, forces.drag),
+		.depthSize = glm::vec2((float)_depthExtent.width, (float)_depthExtent.height),
+		.deltaTime = deltaTime,
+		.time = _time,
+		.curlStrength = forces.curlStrength,
+		.curlScale = forces.curlScale,
+		.restitution = forces.restitution,
+		.collisionThickness = forces.collisionThickness,
+		.size = forces.size,
+		.parity = _parity,
+		.capacity = _capacity,
+		.sorted = _blend == BlendMode::Alpha,
+	};
+	_uniform.write(frame, uniform);
+
+	// Last frame's draw and passes must be done with the buffers this frame rewrites
+	VkMemoryBarrier readDone = {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+	};
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &readDone, 0, nullptr, 0, nullptr);
+
+	uint32_t offset = _uniform.offset(frame);
+	vkCmdBindDescriptorSets(buf, VK_PIPELINE_BIND_POINT_COMPUTE, _layout, 0, 1, &_set, 1, &offset);
+
+	if (!_initialized) {
+		// Every slot starts on the dead list
+		_initialized = true;
+		runUpdate(buf, UpdateReset, (_capacity + groupSize - 1) / groupSize);
+		computeBarrier(buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+	}
+
+	// Emitters keep their fractional particles for the next frame so low rates still emit
+	_emitCarry.resize(emitters.size(), 0.0f);
+	vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_COMPUTE, _emit.pipeline());
+	bool emitted = false;
+	for (size_t i = 0; i < emitters.size(); i++) {
+		const ParticleEmitter& emitter = emitters[i];
+		float wanted = emitter.rate * deltaTime + _emitCarry[i];
+		uint32_t count = (uint32_t)std::min(std::floor(wanted), (float)_capacity);
+		_emitCarry[i] = wanted - std::floor(wanted);
+		if (count == 0) {
+			continue;
+		}
+		EmitConstants constants = {
+			.positionRadius = glm::vec4(emitter.position, emitter.radius),
+			.velocitySpread = glm::vec4(emitter.velocity, emitter.spread),
+			.color = emitter.color,
+			.minLifetime = emitter.minLifetime,
+			.maxLifetime = emitter.maxLifetime,
+			.count = count,
+			.seed = _seed++,
+		};
+		vkCmdPushConstants(buf, _layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+		vkCmdDispatch(buf, (count + groupSize - 1) / groupSize, 1, 1);
+		emitted = true;
+	}
+	if (emitted) {
+		computeBarrier(buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+	}
+
+	// Sizes the simulation to the alive count, which only the GPU knows
+	runUpdate(buf, UpdatePrepare, 1);
+	computeBarrier(buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+		VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+
+	vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_COMPUTE, _simulate.pipeline());
+	vkCmdDispatchIndirect(buf, _state.buffer(), dispatchOffset);
+	computeBarrier(buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+	runUpdate(buf, UpdateFinalize, 1);
+	if (_blend == BlendMode::Alpha) {
+		computeBarrier(buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+		sort(buf);
+	}
+	computeBarrier(buf, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+		VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+
+	// The compacted list is the one read next frame and by this frame's draw
+	_parity ^= 1;
+}
+
+void ParticleSystem::draw(VkCommandBuffer buf, size_t frame) const
+{
+	uint32_t offset = _uniform.offset(frame);
+	vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_GRAPHICS, _render.pipeline());
+	vkCmdBindDescriptorSets(buf, VK_PIPELINE_BIND_POINT_GRAPHICS, _layout, 0, 1, &_set, 1, &offset);
+	vkCmdDrawIndirect(buf, _state.buffer(), drawOffset, 1, 0);
+}
\ No newline at end of file
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+#include "vkctx.h"
+#include "vkbuffer.h"
+#include "computeshader.h"
+#include "defaultshader.h"
+#include "descriptorallocator.h"
+
+// Where and how an emitter spawns particles, the only per frame input from the CPU
+struct ParticleEmitter {
+	glm::vec3 position;
+	// Particles spawn uniformly inside this sphere
+	float radius;
+	glm::vec3 velocity;
+	// Random velocity added in every direction, in units per second
+	float spread;
+	glm::vec4 color;
+	float minLifetime;
+	float maxLifetime;
+	// Particles per second
+	float rate;
+};
+
+struct ParticleForces {
+	glm::vec3 gravity = glm::vec3(0.0f, -9.81f, 0.0f);
+	// Fraction of the velocity lost per second
+	float drag = 0.1f;
+	// Acceleration along a divergence free noise field, swirls without gathering particles in sinks
+	float curlStrength = 2.0f;
+	// Size of the swirls in world units
+	float curlScale = 2.0f;
+	// Fraction of the normal velocity kept when bouncing off the depth buffer
+	float restitution = 0.4f;
+	// Particles further than this behind the depth buffer surface are treated as occluded, not colliding
+	float collisionThickness = 0.5f;
+	// Billboard half size in world units
+	float size = 0.05f;
+};
+
+// GPU particle system where particles never leave the GPU: emission, simulation, compaction, sorting and the draw's
+// arguments are all compute passes over storage buffers, and drawing is one indirect draw of the alive particles
+// Dead particle slots are kept on a stack (the dead list), emission pops slots off it and simulation pushes expired
+// ones back while compacting the survivors into the next frame's alive list, so the work follows the alive count
+// Collisions test against the scene's depth buffer, so they are only as good as what the camera sees
+//
+// Per frame, outside a render pass: update(), then inside the scene pass after the opaque draws: draw()
+class ParticleSystem {
+private:
+	// Matches SimulationUniform in the particle shaders (std140)
+	struct SimulationUniform {
+		glm::mat4 view;
+		glm::mat4 viewProj;
+		glm::mat4 invViewProj;
+		glm::vec4 gravityDrag;
+		glm::vec2 depthSize;
+		float deltaTime;
+		float time;
+		float curlStrength;
+		float curlScale;
+		float restitution;
+		float collisionThickness;
+		float size;
+		uint32_t parity;
+		uint32_t capacity;
+		uint32_t sorted;
+	};
+	// Matches EmitConstants in shaders/particle_emit.comp
+	struct EmitConstants {
+		glm::vec4 positionRadius;
+		glm::vec4 velocitySpread;
+		glm::vec4 color;
+		float minLifetime;
+		float maxLifetime;
+		uint32_t count;
+		uint32_t seed;
+	};
+
+	DeviceBuffer _particles;
+	DeviceBuffer _deadList;
+	// Two alive lists of capacity entries, simulation reads one and compacts into the other
+	DeviceBuffer _aliveLists;
+	// Indirect dispatch and draw arguments followed by the counters, see ParticleState in the shaders
+	DeviceBuffer _state;
+	DeviceBuffer _sortKeys;
+	FrameUniformBuffer<SimulationUniform> _uniform;
+	VkSampler _sampler;
+	VkDescriptorSetLayout _descriptorLayout;
+	VkPipelineLayout _layout;
+	VkDescriptorSet _set;
+	ComputeShader _update;
+	ComputeShader _emit;
+	ComputeShader _simulate;
+	ComputeShader _sort;
+	DefaultShader _render;
+	std::vector<float> _emitCarry;
+	uint32_t _capacity;
+	// Power of two the sort runs over
+	uint32_t _sortSize;
+	uint32_t _parity;
+	uint32_t _seed;
+	float _time;
+	VkExtent2D _depthExtent;
+	BlendMode _blend;
+	bool _initialized;
+
+	void runUpdate(VkCommandBuffer buf, uint32_t mode, uint32_t groups);
+	void sort(VkCommandBuffer buf);
+public:
+	// depthView is the scene depth sampled for collisions, it must be in SHADER_READ_ONLY_OPTIMAL during update()
+	// Alpha blended particles are sorted back to front every frame, additive ones skip the sort
+	ParticleSystem(const VkCtx& ctx, DescriptorAllocator& descriptors, const ShaderModule& updateShader, const ShaderModule& emitShader,
+		const ShaderModule& simulateShader, const ShaderModule& sortShader, const ShaderModule& vertexShader, const ShaderModule& fragmentShader,
+		VkRenderPass renderPass, VkImageView depthView, VkExtent2D depthExtent, size_t frames, uint32_t capacity, BlendMode blend = BlendMode::Additive);
+	void destroy(const VkCtx& ctx);
+
+	// Emits, simulates deltaTime seconds, compacts and sorts, view and proj are the camera that draws the particles
+	void update(VkCommandBuffer buf, size_t frame, float deltaTime, const glm::mat4& view, const glm::mat4& proj,
+		std::span<const ParticleEmitter> emitters, const ParticleForces& forces);
+	void draw(VkCommandBuffer buf, size_t frame) const;
+
+	uint32_t capacity() const { return _capacity; }
+};
\ No newline at end of file
@@ -0,0 +1,313 @@
+#include "postchain.h"
+
+#include <algorithm>
+#include <array>
+
+static constexpr uint32_t groupSize = 8;
+static constexpr VkFormat postFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+static VkDescriptorSetLayout createImageSetLayout(const VkCtx& ctx, uint32_t samplers)
+{
+	// Sampled images first, then the storage image written by the pass
+	VkDescriptorSetLayoutBinding bindings[3];
+	for (uint32_t i = 0; i <= samplers; i++) {
+		bindings[i] = {
+			.binding = i,
+			.descriptorType = i < samplers ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+			.descriptorCount = 1,
+			.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+		};
+	}
+	VkDescriptorSetLayoutCreateInfo descriptorLayoutInfo = {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+		.bindingCount = samplers + 1,
+		.pBindings = bindings,
+	};
+	VkDescriptorSetLayout descriptorLayout;
+	CHK_ERR(vkCreateDescriptorSetLayout(ctx.device(), &descriptorLayoutInfo, nullptr, &descriptorLayout));
+	return descriptorLayout;
+}
+
+static VkPipelineLayout createPassLayout(const VkCtx& ctx, VkDescriptorSetLayout descriptorLayout, uint32_t pushSize)
+{
+	VkPushConstantRange pushRange = {
+		.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+		.offset = 0,
+		.size = pushSize,
+	};
+	VkPipelineLayoutCreateInfo info = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+		.setLayoutCount = 1,
+		.pSetLayouts = &descriptorLayout,
+		.pushConstantRangeCount = 1,
+		.pPushConstantRanges = &pushRange,
+	};
+	VkPipelineLayout layout;
+	CHK_ERR(vkCreatePipelineLayout(ctx.device(), &info, nullptr, &layout));
+	return layout;
+}
+
+static void createPostImage(const VkCtx& ctx, VkExtent2D extent, uint32_t mips, VkImageUsageFlags usage, VkImage& image, VmaAllocation& alloc)
+{
+	VkImageCreateInfo imageInfo = {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+		.imageType = VK_IMAGE_TYPE_2D,
+		.format = postFormat,
+		.extent = { .width = extent.width, .height = extent.height, .depth = 1, },
+		.mipLevels = mips,
+		.arrayLayers = 1,
+		.samples = VK_SAMPLE_COUNT_1_BIT,
+		.tiling = VK_IMAGE_TILING_OPTIMAL,
+		.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | usage,
+		.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+	};
+	VmaAllocationCreateInfo allocInfo{};
+	allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+	CHK_ERR(vmaCreateImage(ctx.allocator(), &imageInfo, &allocInfo, &image, &alloc, nullptr));
+}
+
+static VkImageView createMipView(const VkCtx& ctx, VkImage image, uint32_t mip)
+{
+	VkImageViewCreateInfo viewInfo = {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+		.image = image,
+		.viewType = VK_IMAGE_VIEW_TYPE_2D,
+		.format = postFormat,
+		.components = { }, // VK_COMPONENT_SWIZZLE_IDENTITY == 0 therefore zero struct
+		.subresourceRange = {
+			.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+			.baseMipLevel = mip,
+			.levelCount = 1,
+			.baseArrayLayer = 0,
+			.layerCount = 1,
+		}
+	};
+	VkImageView view;
+	CHK_ERR(vkCreateImageView(ctx.device(), &viewInfo, nullptr, &view));
+	return view;
+}
+
+static VkImageMemoryBarrier imageBarrier(VkImage image, uint32_t mips, VkAccessFlags srcAccess, VkAccessFlags dstAccess, VkImageLayout oldLayout, VkImageLayout newLayout)
+{
+	return {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+		.srcAccessMask = srcAccess,
+		.dstAccessMask = dstAccess,
+		.oldLayout = oldLayout,
+		.newLayout = newLayout,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.image = image,
+		.subresourceRange = {
+			.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+			.baseMipLevel = 0,
+			.levelCount = mips,
+			.baseArrayLayer = 0,
+			.layerCount = 1,
+		},
+	};
+}
+
+static void computeBarrier(VkCommandBuffer buf)
+{
+	VkMemoryBarrier written = {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+	};
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &written, 0, nullptr, 0, nullptr);
+}
+
+PostChain::PostChain(const VkCtx& ctx, DescriptorAllocator& descriptors, const ShaderModule& postShader, const ShaderModule& bloomDownShader,
+	const ShaderModule& bloomUpShader, VkImageView source, VkExtent2D extent)
+	: _bloomImage(VK_NULL_HANDLE),
+	_bloomAlloc(nullptr),
+	_outputImage(VK_NULL_HANDLE),
+	_outputAlloc(nullptr),
+	_outputView(VK_NULL_HANDLE),
+	_sampler(VK_NULL_HANDLE),
+	_bloomDescriptorLayout(createImageSetLayout(ctx, 1)),
+	_bloomLayout(createPassLayout(ctx, _bloomDescriptorLayout, sizeof(BloomConstants))),
+	_postDescriptorLayout(createImageSetLayout(ctx, 2)),
+	_postLayout(createPassLayout(ctx, _postDescriptorLayout, sizeof(PostConstants))),
+	_bloomDown(ctx, _bloomLayout, bloomDownShader),
+	_bloomUp(ctx, _bloomLayout, bloomUpShader),
+	_postShader(postShader),
+	_extent(extent),
+	_initialized(false)
+{
+	// Mip 0 is half the source resolution, every further mip halves again
+	VkExtent2D bloomExtent = { std::max(extent.width / 2, 1u), std::max(extent.height / 2, 1u) };
+	createPostImage(ctx, bloomExtent, bloomMips, 0, _bloomImage, _bloomAlloc);
+	for (uint32_t i = 0; i < bloomMips; i++) {
+		_bloomViews.push_back(createMipView(ctx, _bloomImage, i));
+		_bloomExtents.push_back({ std::max(bloomExtent.width >> i, 1u), std::max(bloomExtent.height >> i, 1u) });
+	}
+	createPostImage(ctx, extent, 1, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, _outputImage, _outputAlloc);
+	_outputView = createMipView(ctx, _outputImage, 0);
+
+	// Bilinear, the bloom filters rely on it to average four texels per tap
+	VkSamplerCreateInfo samplerInfo = {
+		.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+		.magFilter = VK_FILTER_LINEAR,
+		.minFilter = VK_FILTER_LINEAR,
+		.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+		.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		.maxLod = VK_LOD_CLAMP_NONE,
+	};
+	CHK_ERR(vkCreateSampler(ctx.device(), &samplerInfo, nullptr, &_sampler));
+
+	// Downsample i reads the source (i == 0) or mip i - 1 and writes mip i
+	_downSets.resize(bloomMips);
+	descriptors.allocate(ctx, _bloomDescriptorLayout, _downSets);
+	for (uint32_t i = 0; i < bloomMips; i++) {
+		DescriptorBindings()
+			.image(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, i == 0 ? source : _bloomViews[i - 1], _sampler,
+				i == 0 ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL)
+			.image(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, _bloomViews[i], VK_NULL_HANDLE, VK_IMAGE_LAYOUT_GENERAL)
+			.write(ctx, _downSets[i]);
+	}
+	// Upsample i reads mip i + 1 and accumulates into mip i
+	_upSets.resize(bloomMips - 1);
+	descriptors.allocate(ctx, _bloomDescriptorLayout, _upSets);
+	for (uint32_t i = 0; i + 1 < bloomMips; i++) {
+		DescriptorBindings()
+			.image(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, _bloomViews[i + 1], _sampler, VK_IMAGE_LAYOUT_GENERAL)
+			.image(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, _bloomViews[i], VK_NULL_HANDLE, VK_IMAGE_LAYOUT_GENERAL)
+			.write(ctx, _upSets[i]);
+	}
+	_postSet = descriptors.allocate(ctx, _postDescriptorLayout);
+	DescriptorBindings()
+		.image(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, source, _sampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+		.image(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, _bloomViews[0], _sampler, VK_IMAGE_LAYOUT_GENERAL)
+		.image(2, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, _outputView, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_GENERAL)
+		.write(ctx, _postSet);
+}
+
+void PostChain::destroy(const VkCtx& ctx)
+{
+	for (auto& [effects, pipeline] : _postPipelines) {
+		pipeline.destroy(ctx);
+	}
+	_bloomUp.destroy(ctx);
+	_bloomDown.destroy(ctx);
+	vkDestroyPipelineLayout(ctx.device(), _postLayout, nullptr);
+	vkDestroyDescriptorSetLayout(ctx.device(), _postDescriptorLayout, nullptr);
+	vkDestroyPipelineLayout(ctx.device(), _bloomLayout, nullptr);
+	vkDestroyDescriptorSetLayout(ctx.device(), _bloomDescriptorLayout, nullptr);
+	vkDestroySampler(ctx.device(), _sampler, nullptr);
+	vkDestroyImageView(ctx.device(), _outputView, nullptr);
+	vmaDestroyImage(ctx.allocator(), _outputImage, _outputAlloc);
+	for (VkImageView view : _bloomViews) {
+		vkDestroyImageView(ctx.device(), view, nullptr);
+	}
+	vmaDestroyImage(ctx.allocator(), _bloomImage, _bloomAlloc);
+}
+
+const ComputeShader& PostChain::postPipeline(const VkCtx& ctx, uint32_t effects)
+{
+	auto it = _postPipelines.find(effects);
+	if (it != _postPipelines.end()) {
+		return it->second;
+	}
+
+	// constant_id i enables stage i, disabled stages are dead code the driver compiles away
+	std::array<VkBool32, 4> enabled;
+	std::array<VkSpecializationMapEntry, 4> entries;
+	for (uint32_t i = 0; i < 4; i++) {
+		enabled[i] = (effects >> i) & 1;
+		entries[i] = { .constantID = i, .offset = i * (uint32_t)sizeof(VkBool32), .size = sizeof(VkBool32) };
+	}
+	VkSpecializationInfo specialization = {
+		.mapEntryCount = (uint32_t)entries.size(),
+		.pMapEntries = entries.data(),
+		.dataSize = sizeof(enabled),
+		.pData = enabled.data(),
+	};
+	return _postPipelines.try_emplace(effects, ctx, _postLayout, _postShader, &specialization).first->second;
+}
+
+void PostChain::bloom(VkCommandBuffer buf, const PostSettings& settings)
+{
+	vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_COMPUTE, _bloomDown.pipeline());
+	VkExtent2D src = _extent;
+	for (uint32_t i = 0; i < bloomMips; i++) {
+		VkExtent2D dst = _bloomExtents[i];
+		BloomConstants constants = { (int32_t)src.width, (int32_t)src.height, (int32_t)dst.width, (int32_t)dst.height, settings.bloomThreshold, i == 0 };
+		vkCmdBindDescriptorSets(buf, VK_PIPELINE_BIND_POINT_COMPUTE, _bloomLayout, 0, 1, &_downSets[i], 0, nullptr);
+		vkCmdPushConstants(buf, _bloomLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+		vkCmdDispatch(buf, (dst.width + groupSize - 1) / groupSize, (dst.height + groupSize - 1) / groupSize, 1);
+		computeBarrier(buf);
+		src = dst;
+	}
+
+	vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_COMPUTE, _bloomUp.pipeline());
+	for (uint32_t i = bloomMips - 1; i-- > 0;) {
+		VkExtent2D dst = _bloomExtents[i];
+		BloomConstants constants = { (int32_t)_bloomExtents[i + 1].width, (int32_t)_bloomExtents[i + 1].height,
+			(int32_t)dst.width, (int32_t)dst.height, settings.bloomThreshold, 0 };
+		vkCmdBindDescriptorSets(buf, VK_PIPELINE_BIND_POINT_COMPUTE, _bloomLayout, 0, 1, &_upSets[i], 0, nullptr);
+		vkCmdPushConstants(buf, _bloomLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+		vkCmdDispatch(buf, (dst.width + groupSize - 1) / groupSize, (dst.height + groupSize - 1) / groupSize, 1);
+		computeBarrier(buf);
+	}
+}
+
+void PostChain::apply(const VkCtx& ctx, VkCommandBuffer buf, uint32_t effects, const PostSettings& settings)
+{
+	// Everything is rewritten each frame, so the old contents are discarded but last frame's readers must be done
+	VkImageMemoryBarrier toGeneral[] = {
+		imageBarrier(_outputImage, 1, 0, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL),
+		imageBarrier(_bloomImage, bloomMips, 0, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+			_initialized ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL),
+	};
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 0, nullptr, 0, nullptr, 2, toGeneral);
+	_initialized = true;
+
+	if (effects & PostBloom) {
+		bloom(buf, settings);
+	}
+
+	PostConstants constants = {
+		.width = (int32_t)_extent.width,
+		.height = (int32_t)_extent.height,
+		.exposure = settings.exposure,
+		.contrast = settings.contrast,
+		.saturation = settings.saturation,
+		.vignetteStrength = settings.vignetteStrength,
+		.vignetteRadius = settings.vignetteRadius,
+		.bloomIntensity = settings.bloomIntensity,
+	};
+	vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_COMPUTE, postPipeline(ctx, effects).pipeline());
+	vkCmdBindDescriptorSets(buf, VK_PIPELINE_BIND_POINT_COMPUTE, _postLayout, 0, 1, &_postSet, 0, nullptr);
+	vkCmdPushConstants(buf, _postLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+	vkCmdDispatch(buf, (_extent.width + groupSize - 1) / groupSize, (_extent.height + groupSize - 1) / groupSize, 1);
+
+	VkImageMemoryBarrier toRead = imageBarrier(_outputImage, 1, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT,
+		VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 0, nullptr, 0, nullptr, 1, &toRead);
+}
+
+void PostChain::present(VkCommandBuffer buf, VkImage target) const
+{
+	VkImageMemoryBarrier toCopy[] = {
+		imageBarrier(_outputImage, 1, 0, VK_ACCESS_TRANSFER_READ_BIT,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL),
+		imageBarrier(target, 1, 0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL),
+	};
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 2, toCopy);
+
+	// A 1:1 blit, unlike a copy it converts to the swapchain format
+	VkImageBlit region = {
+		.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
+		.srcOffsets = { { 0, 0, 0 }, { (int32_t)_extent.width, (int32_t)_extent.height, 1 } },
+		.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
+		.dstOffsets = { { 0, 0, 0 }, { (int32_t)_extent.width, (int32_t)_extent.height, 1 } },
+	};
+	vkCmdBlitImage(buf, _outputImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, target, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region, VK_FILTER_NEAREST);
+}
\ No newline at end of file
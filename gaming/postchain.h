@@ -0,0 +1,108 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "vkctx.h"
+#include "computeshader.h"
+#include "descriptorallocator.h"
+
+// Per pixel post effects, combined as a bitmask
+// They run in this order, each reading the previous one's result in registers
+enum PostEffect : uint32_t {
+	// Adds the blurred bloom chain to the HDR color
+	PostBloom = 1 << 0,
+	// Exposure and a filmic curve from HDR to display range
+	PostTonemap = 1 << 1,
+	// Contrast and saturation
+	PostColorGrade = 1 << 2,
+	PostVignette = 1 << 3,
+};
+
+struct PostSettings {
+	float exposure = 1.0f;
+	float contrast = 1.0f;
+	float saturation = 1.0f;
+	float vignetteStrength = 0.3f;
+	// Distance from the center, as a fraction of the half diagonal, where darkening starts
+	float vignetteRadius = 0.5f;
+	float bloomIntensity = 0.05f;
+	// Luminance above which pixels feed the bloom
+	float bloomThreshold = 1.0f;
+};
+
+// Post processing in as few full screen memory round trips as possible
+// Every per pixel effect runs fused in one compute dispatch (shaders/post.comp): each effect is a stage guarded by a
+// specialization constant, so a pipeline specialized for an effect mask only contains those stages and adding an
+// effect never adds a pass. Effects needing neighbourhood data get their own passes, currently the bloom chain
+// which downsamples the bright parts of the source (shaders/bloom_down.comp) and blurs them back up
+// (shaders/bloom_up.comp) before the fused pass samples the result
+class PostChain {
+public:
+	static constexpr uint32_t bloomMips = 5;
+private:
+	// Matches PostConstants in shaders/post.comp
+	struct PostConstants {
+		int32_t width;
+		int32_t height;
+		float exposure;
+		float contrast;
+		float saturation;
+		float vignetteStrength;
+		float vignetteRadius;
+		float bloomIntensity;
+	};
+	// Matches BloomConstants in shaders/bloom_down.comp and shaders/bloom_up.comp
+	struct BloomConstants {
+		int32_t srcWidth;
+		int32_t srcHeight;
+		int32_t dstWidth;
+		int32_t dstHeight;
+		float threshold;
+		// Only the first downsample applies the threshold
+		int32_t prefilter;
+	};
+
+	VkImage _bloomImage;
+	VmaAllocation _bloomAlloc;
+	std::vector<VkImageView> _bloomViews;
+	std::vector<VkExtent2D> _bloomExtents;
+	VkImage _outputImage;
+	VmaAllocation _outputAlloc;
+	VkImageView _outputView;
+	VkSampler _sampler;
+	VkDescriptorSetLayout _bloomDescriptorLayout;
+	VkPipelineLayout _bloomLayout;
+	VkDescriptorSetLayout _postDescriptorLayout;
+	VkPipelineLayout _postLayout;
+	std::vector<VkDescriptorSet> _downSets;
+	std::vector<VkDescriptorSet> _upSets;
+	VkDescriptorSet _postSet;
+	ComputeShader _bloomDown;
+	ComputeShader _bloomUp;
+	const ShaderModule& _postShader;
+	// Fused pipelines by effect mask, created the first time a mask is used
+	std::unordered_map<uint32_t, ComputeShader> _postPipelines;
+	VkExtent2D _extent;
+	bool _initialized;
+
+	const ComputeShader& postPipeline(const VkCtx& ctx, uint32_t effects);
+	void bloom(VkCommandBuffer buf, const PostSettings& settings);
+public:
+	// source is the HDR scene color, read in SHADER_READ_ONLY_OPTIMAL with its writes visible to compute
+	// postShader must outlive the chain, it specializes new pipelines from it
+	PostChain(const VkCtx& ctx, DescriptorAllocator& descriptors, const ShaderModule& postShader, const ShaderModule& bloomDownShader,
+		const ShaderModule& bloomUpShader, VkImageView source, VkExtent2D extent);
+	void destroy(const VkCtx& ctx);
+
+	// Creates the fused pipeline for an effect mask ahead of time so switching to it doesn't hitch
+	void prepare(const VkCtx& ctx, uint32_t effects) { postPipeline(ctx, effects); }
+	// Runs the bloom passes if needed and the fused pass, leaving the result in output() in SHADER_READ_ONLY_OPTIMAL
+	// with its writes visible to compute and transfer reads (SpatialUpscaler can take it as its source)
+	void apply(const VkCtx& ctx, VkCommandBuffer buf, uint32_t effects, const PostSettings& settings);
+	// Copies the result over target and leaves it in TRANSFER_DST_OPTIMAL for WindowSwapchain::overlayPass
+	void present(VkCommandBuffer buf, VkImage target) const;
+
+	VkImageView output() const { return _outputView; }
+	VkExtent2D extent() const { return _extent; }
+};
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "radixsort.h"
+
+#include <array>
+
+static constexpr int digitBits = 8;
+static constexpr int passes = 64 / digitBits;
+static constexpr size_t buckets = 1 << digitBits;
+static constexpr size_t parallelThreshold = 32768;
+static constexpr size_t chunkSize = 16384;
+
+static size_t digit(uint64_t key, int pass)
+{
+	return (size_t)(key >> (pass * digitBits)) & (buckets - 1);
+}
+
+void radixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch)
+{
+	size_t count = entries.size();
+	if (count < 2) {
+		return;
+	}
+	scratch.resize(count);
+
+	// Digit counts do not depend on order so every pass is counted in one sweep
+	std::array<std::array<size_t, buckets>, passes> histograms{};
+	for (const SortEntry& e : entries) {
+		for (int p = 0; p < passes; p++) {
+			histograms[p][digit(e.key, p)]++;
+		}
+	}
+
+	for (int p = 0; p < passes; p++) {
+		std::array<size_t, buckets>& histogram = histograms[p];
+		if (histogram[digit(entries[0].key, p)] == count) {
+			continue;
+		}
+		size_t sum = 0;
+		for (size_t& h : histogram) {
+			size_t n = h;
+			h = sum;
+			sum += n;
+		}
+		for (const SortEntry& e : entries) {
+			scratch[histogram[digit(e.key, p)]++] = e;
+		}
+		entries.swap(scratch);
+	}
+}
+
+void radixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch, JobSystem& jobs)
+{
+	size_t count = entries.size();
+	if (count < parallelThreshold) {
+		radixSort(entries, scratch);
+		return;
+	}
+	scratch.resize(count);
+
+	// Each chunk scatters into its own slice of every bucket, so chunks write without synchronisation
+	// and the order within a bucket stays the input order
+	size_t chunks = (count + chunkSize - 1) / chunkSize;
+	std::vector<std::array<size_t, buckets>> offsets(chunks);
+	for (int p = 0; p < passes; p++) {
+		// The prefix sum below reads every chunk's histogram, not only those the jobs filled
+		for (std::array<size_t, buckets>& histogram : offsets) {
+			histogram.fill(0);
+		}
+		jobs.parallelFor(count, chunkSize, [&](size_t begin, size_t end) {
+			std::array<size_t, buckets>& histogram = offsets[begin / chunkSize];
+			for (size_t i = begin; i < end; i++) {
+				histogram[digit(entries[i].key, p)]++;
+			}
+		});
+
+		size_t sum = 0;
+		bool skip = false;
+		for (size_t b = 0; b < buckets; b++) {
+			size_t start = sum;
+			for (size_t c = 0; c < chunks; c++) {
+				size_t n = offsets[c][b];
+				offsets[c][b] = sum;
+				sum += n;
+			}
+			skip = skip || sum - start == count;
+		}
+		if (skip) {
+			continue;
+		}
+
+		jobs.parallelFor(count, chunkSize, [&](size_t begin, size_t end) {
+			std::array<size_t, buckets>& offset = offsets[begin / chunkSize];
+			for (size_t i = begin; i < end; i++) {
+				scratch[offset[digit(entries[i].key, p)]++] = entries[i];
+			}
+		});
+		entries.swap(scratch);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "jobsystem.h"
+
+// A 64 bit sort key and the index of whatever it sorts
+struct SortEntry {
+	uint64_t key;
+	uint32_t index;
+};
+
+// Stable LSD radix sort on key, 8 bits per pass, passes where every key has the same digit are skipped
+// scratch is resized as needed and can be reused between calls to avoid allocating
+void radixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch);
+
+// Same as radixSort, large inputs are histogrammed and scattered in parallel chunks
+void radixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch, JobSystem& jobs);
\ No newline at end of file
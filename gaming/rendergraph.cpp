@@ -0,0 +1,663 @@
+#include "rendergraph.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+struct AccessInfo {
+	VkImageLayout layout;
+	VkPipelineStageFlags stage;
+	VkAccessFlags access;
+	VkImageUsageFlags usage;
+	bool write;
+};
+
+static constexpr VkAccessFlags writeAccesses = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+	| VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+static AccessInfo accessInfo(RenderGraph::Access access, RenderGraph::PassType type)
+{
+	VkPipelineStageFlags shaderStage = type == RenderGraph::PassType::Compute ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	VkPipelineStageFlags depthStages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	switch (access) {
+	case RenderGraph::Access::ColorAttachment:
+		return { VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, true };
+	case RenderGraph::Access::DepthAttachment:
+		return { VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, depthStages,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, true };
+	case RenderGraph::Access::DepthRead:
+		return { VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, depthStages,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, false };
+	case RenderGraph::Access::Sampled:
+		return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, shaderStage, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_USAGE_SAMPLED_BIT, false };
+	case RenderGraph::Access::StorageRead:
+		return { VK_IMAGE_LAYOUT_GENERAL, shaderStage, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_USAGE_STORAGE_BIT, false };
+	case RenderGraph::Access::StorageWrite:
+		return { VK_IMAGE_LAYOUT_GENERAL, shaderStage, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_USAGE_STORAGE_BIT, true };
+	case RenderGraph::Access::TransferSrc:
+		return { VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, false };
+	case RenderGraph::Access::TransferDst:
+		return { VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_USAGE_TRANSFER_DST_BIT, true };
+	}
+	throw std::runtime_error("Unknown render graph access");
+}
+
+static bool isAttachment(RenderGraph::Access access)
+{
+	return access == RenderGraph::Access::ColorAttachment || access == RenderGraph::Access::DepthAttachment || access == RenderGraph::Access::DepthRead;
+}
+
+static VkImageAspectFlags formatAspect(VkFormat format)
+{
+	switch (format) {
+	case VK_FORMAT_D16_UNORM:
+	case VK_FORMAT_X8_D24_UNORM_PACK32:
+	case VK_FORMAT_D32_SFLOAT:
+		return VK_IMAGE_ASPECT_DEPTH_BIT;
+	case VK_FORMAT_D16_UNORM_S8_UINT:
+	case VK_FORMAT_D24_UNORM_S8_UINT:
+	case VK_FORMAT_D32_SFLOAT_S8_UINT:
+		return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+	case VK_FORMAT_S8_UINT:
+		return VK_IMAGE_ASPECT_STENCIL_BIT;
+	default:
+		return VK_IMAGE_ASPECT_COLOR_BIT;
+	}
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::color(Handle image)
+{
+	return use(image, Access::ColorAttachment);
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::color(Handle image, VkClearColorValue clear)
+{
+	use(image, Access::ColorAttachment);
+	Use& added = _graph._passes[_pass].uses.back();
+	added.clear = true;
+	added.clearValue.color = clear;
+	return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::depth(Handle image)
+{
+	return use(image, Access::DepthAttachment);
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::depth(Handle image, float clear)
+{
+	use(image, Access::DepthAttachment);
+	Use& added = _graph._passes[_pass].uses.back();
+	added.clear = true;
+	added.clearValue.depthStencil = { clear, 0 };
+	return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::read(Handle image, Access access)
+{
+	if (accessInfo(access, PassType::Graphics).write) {
+		throw std::runtime_error("Render graph read with a write access");
+	}
+	return use(image, access);
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::write(Handle image, Access access)
+{
+	if (!accessInfo(access, PassType::Graphics).write) {
+		throw std::runtime_error("Render graph write with a read access");
+	}
+	return use(image, access);
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::use(Handle image, Access access)
+{
+	Pass& pass = _graph._passes[_pass];
+	if (_graph._compiled) {
+		throw std::runtime_error("Render graph is already compiled");
+	}
+	if (isAttachment(access) != (pass.type == PassType::Graphics)) {
+		throw std::runtime_error("Attachments are only used by graphics passes in " + pass.name);
+	}
+	// One layout per image per pass, barriers are only recorded between passes
+	for (const Use& existing : pass.uses) {
+		if (existing.image == image) {
+			throw std::runtime_error("Image " + _graph._images[image].name + " is used twice by " + pass.name);
+		}
+	}
+	pass.uses.push_back({ image, access, false, {} });
+	return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::sideEffect()
+{
+	_graph._passes[_pass].sideEffect = true;
+	return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::execute(ExecuteFn fn)
+{
+	_graph._passes[_pass].execute = std::move(fn);
+	return *this;
+}
+
+RenderGraph::RenderGraph()
+	: _stats({}),
+	_compiled(false)
+{
+}
+
+void RenderGraph::destroy(const VkCtx& ctx)
+{
+	for (Pass& pass : _passes) {
+		for (auto& [views, framebuffer] : pass.framebuffers) {
+			vkDestroyFramebuffer(ctx.device(), framebuffer, nullptr);
+		}
+		pass.framebuffers.clear();
+		vkDestroyRenderPass(ctx.device(), pass.renderPass, nullptr);
+		pass.renderPass = VK_NULL_HANDLE;
+	}
+	for (Image& image : _images) {
+		if (!image.imported) {
+			vkDestroyImageView(ctx.device(), image.view, nullptr);
+			vkDestroyImage(ctx.device(), image.image, nullptr);
+		}
+	}
+	for (Slot& slot : _slots) {
+		vmaFreeMemory(ctx.allocator(), slot.alloc);
+	}
+	_slots.clear();
+}
+
+RenderGraph::Handle RenderGraph::createImage(const std::string& name, VkFormat format, VkExtent2D extent)
+{
+	_images.push_back({
+		.name = name,
+		.format = format,
+		.extent = extent,
+		.aspect = formatAspect(format),
+		.usage = 0,
+		.imported = false,
+		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+		.finalLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+		.image = VK_NULL_HANDLE,
+		.view = VK_NULL_HANDLE,
+		.firstPass = UINT32_MAX,
+		.lastPass = 0,
+		.slot = UINT32_MAX,
+	});
+	return (Handle)_images.size() - 1;
+}
+
+RenderGraph::Handle RenderGraph::importImage(const std::string& name, VkFormat format, VkExtent2D extent, VkImageLayout initialLayout, VkImageLayout finalLayout)
+{
+	Handle handle = createImage(name, format, extent);
+	Image& image = _images[handle];
+	image.imported = true;
+	image.initialLayout = initialLayout;
+	image.finalLayout = finalLayout;
+	return handle;
+}
+
+void RenderGraph::setImported(Handle image, VkImage vkImage, VkImageView view)
+{
+	if (!_images[image].imported) {
+		throw std::runtime_error("Image " + _images[image].name + " is not imported");
+	}
+	_images[image].image = vkImage;
+	_images[image].view = view;
+}
+
+void RenderGraph::releaseImported(const VkCtx& ctx)
+{
+	for (Pass& pass : _passes) {
+		bool imported = std::any_of(pass.uses.begin(), pass.uses.end(),
+			[this](const Use& use) { return isAttachment(use.access) && _images[use.image].imported; });
+		if (!imported) {
+			continue;
+		}
+		for (auto& [views, framebuffer] : pass.framebuffers) {
+			vkDestroyFramebuffer(ctx.device(), framebuffer, nullptr);
+		}
+		pass.framebuffers.clear();
+	}
+}
+
+RenderGraph::PassBuilder RenderGraph::addPass(const std::string& name, PassType type)
+{
+	if (_compiled) {
+		throw std::runtime_error("Render graph is already compiled");
+	}
+	_passes.push_back({
+		.name = name,
+		.type = type,
+		.sideEffect = false,
+		.culled = false,
+		.renderPass = VK_NULL_HANDLE,
+		.extent = {},
+	});
+	return PassBuilder(*this, (Handle)_passes.size() - 1);
+}
+
+// Walks the passes backwards tracking which images' current contents are still consumed
+// A pass survives if it has side effects or writes consumed contents, a cleared attachment ends the
+// consumption of the contents written before it
+void RenderGraph::cull()
+{
+	std::vector<bool> needed(_images.size());
+	for (size_t i = 0; i < _images.size(); i++) {
+		needed[i] = _images[i].imported && _images[i].finalLayout != VK_IMAGE_LAYOUT_UNDEFINED;
+	}
+	for (size_t p = _passes.size(); p-- > 0;) {
+		Pass& pass = _passes[p];
+		pass.culled = !pass.sideEffect;
+		for (const Use& use : pass.uses) {
+			if (accessInfo(use.access, pass.type).write && needed[use.image]) {
+				pass.culled = false;
+			}
+		}
+		if (pass.culled) {
+			continue;
+		}
+		for (const Use& use : pass.uses) {
+			needed[use.image] = !use.clear;
+		}
+	}
+}
+
+// Greedy interval packing in order of first use, each image joins the slot whose last user finished before it
+// starts and that grows the least, slots are then allocated once at the largest requirement of their images
+void RenderGraph::allocate(const VkCtx& ctx)
+{
+	std::vector<Handle> order;
+	for (Handle h = 0; h < (Handle)_images.size(); h++) {
+		Image& image = _images[h];
+		if (image.imported || image.firstPass == UINT32_MAX) {
+			continue;
+		}
+		VkImageCreateInfo imageInfo = {
+			.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+			.imageType = VK_IMAGE_TYPE_2D,
+			.format = image.format,
+			.extent = { .width = image.extent.width, .height = image.extent.height, .depth = 1, },
+			.mipLevels = 1,
+			.arrayLayers = 1,
+			.samples = VK_SAMPLE_COUNT_1_BIT,
+			.tiling = VK_IMAGE_TILING_OPTIMAL,
+			.usage = image.usage,
+			.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+			.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+		};
+		CHK_ERR(vkCreateImage(ctx.device(), &imageInfo, nullptr, &image.image));
+		order.push_back(h);
+	}
+	std::sort(order.begin(), order.end(), [this](Handle a, Handle b) { return _images[a].firstPass < _images[b].firstPass; });
+
+	for (Handle h : order) {
+		Image& image = _images[h];
+		VkMemoryRequirements reqs;
+		vkGetImageMemoryRequirements(ctx.device(), image.image, &reqs);
+		_stats.transientMemory += reqs.size;
+
+		uint32_t best = UINT32_MAX;
+		VkDeviceSize bestGrowth = 0;
+		for (uint32_t s = 0; s < (uint32_t)_slots.size(); s++) {
+			const Slot& slot = _slots[s];
+			if (slot.lastPass >= image.firstPass || !(slot.requirements.memoryTypeBits & reqs.memoryTypeBits)) {
+				continue;
+			}
+			VkDeviceSize growth = reqs.size > slot.requirements.size ? reqs.size - slot.requirements.size : 0;
+			if (best == UINT32_MAX || growth < bestGrowth) {
+				best = s;
+				bestGrowth = growth;
+			}
+		}
+		if (best == UINT32_MAX) {
+			_slots.push_back({ reqs, nullptr, image.lastPass, { h } });
+			image.slot = (uint32_t)_slots.size() - 1;
+			continue;
+		}
+		Slot& slot = _slots[best];
+		slot.requirements.size = std::max(slot.requirements.size, reqs.size);
+		slot.requirements.alignment = std::max(slot.requirements.alignment, reqs.alignment);
+		slot.requirements.memoryTypeBits &= reqs.memoryTypeBits;
+		slot.lastPass = image.lastPass;
+		slot.images.push_back(h);
+		image.slot = best;
+	}
+
+	for (Slot& slot : _slots) {
+		VmaAllocationCreateInfo allocInfo{};
+		allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+		CHK_ERR(vmaAllocateMemory(ctx.allocator(), &slot.requirements, &allocInfo, &slot.alloc, nullptr));
+		_stats.aliasedMemory += slot.requirements.size;
+		for (Handle h : slot.images) {
+			Image& image = _images[h];
+			CHK_ERR(vmaBindImageMemory(ctx.allocator(), slot.alloc, image.image));
+			VkImageViewCreateInfo viewInfo = {
+				.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+				.image = image.image,
+				.viewType = VK_IMAGE_VIEW_TYPE_2D,
+				.format = image.format,
+				.components = { }, // VK_COMPONENT_SWIZZLE_IDENTITY == 0 therefore zero struct
+				.subresourceRange = {
+					.aspectMask = image.aspect,
+					.baseMipLevel = 0,
+					.levelCount = 1,
+					.baseArrayLayer = 0,
+					.layerCount = 1,
+				}
+			};
+			CHK_ERR(vkCreateImageView(ctx.device(), &viewInfo, nullptr, &image.view));
+		}
+	}
+}
+
+// Attachments start and end in the layout of their use, transitions are done by the graph's barriers
+// Contents are loaded only if an earlier pass or the importer produced them, and stored only if a later pass
+// or the importer consumes them
+void RenderGraph::createRenderPass(const VkCtx& ctx, Pass& pass)
+{
+	uint32_t index = (uint32_t)(&pass - _passes.data());
+	std::vector<VkAttachmentDescription> descs;
+	std::vector<VkAttachmentReference> colorRefs;
+	VkAttachmentReference depthRef = {};
+	bool hasDepth = false;
+	bool hasExtent = false;
+	for (const Use& use : pass.uses) {
+		if (!isAttachment(use.access)) {
+			continue;
+		}
+		const Image& image = _images[use.image];
+		AccessInfo info = accessInfo(use.access, pass.type);
+		bool contents = image.firstPass < index || (image.imported && image.initialLayout != VK_IMAGE_LAYOUT_UNDEFINED);
+		bool consumed = image.lastPass > index || (image.imported && image.finalLayout != VK_IMAGE_LAYOUT_UNDEFINED);
+		VkAttachmentLoadOp loadOp = use.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : contents ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		VkAttachmentStoreOp storeOp = consumed ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		bool stencil = image.aspect & VK_IMAGE_ASPECT_STENCIL_BIT;
+		descs.push_back({
+			.format = image.format,
+			.samples = VK_SAMPLE_COUNT_1_BIT,
+			.loadOp = loadOp,
+			.storeOp = storeOp,
+			.stencilLoadOp = stencil ? loadOp : VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+			.stencilStoreOp = stencil ? storeOp : VK_ATTACHMENT_STORE_OP_DONT_CARE,
+			.initialLayout = info.layout,
+			.finalLayout = info.layout,
+		});
+		pass.clearValues.push_back(use.clearValue);
+
+		VkAttachmentReference ref = { (uint32_t)descs.size() - 1, info.layout };
+		if (use.access == Access::ColorAttachment) {
+			colorRefs.push_back(ref);
+		} else {
+			depthRef = ref;
+			hasDepth = true;
+		}
+		if (hasExtent && (image.extent.width != pass.extent.width || image.extent.height != pass.extent.height)) {
+			throw std::runtime_error("Attachment sizes differ in " + pass.name);
+		}
+		pass.extent = image.extent;
+		hasExtent = true;
+	}
+	if (!hasExtent) {
+		throw std::runtime_error("Graphics pass " + pass.name + " has no attachments");
+	}
+
+	VkSubpassDescription subpassDesc = {
+		.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+		.colorAttachmentCount = (uint32_t)colorRefs.size(),
+		.pColorAttachments = colorRefs.data(),
+		.pDepthStencilAttachment = hasDepth ? &depthRef : nullptr,
+	};
+	VkRenderPassCreateInfo renderpassInfo = {
+		.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+		.attachmentCount = (uint32_t)descs.size(),
+		.pAttachments = descs.data(),
+		.subpassCount = 1,
+		.pSubpasses = &subpassDesc,
+	};
+	CHK_ERR(vkCreateRenderPass(ctx.device(), &renderpassInfo, nullptr, &pass.renderPass));
+}
+
+// Simulates every image's layout and pending accesses through the surviving passes
+// Reads after reads in the same layout need nothing, a read waits once per stage on the last write,
+// and a write or layout change waits on the last write and every read since
+void RenderGraph::buildBarriers()
+{
+	struct State {
+		VkImageLayout layout;
+		VkPipelineStageFlags writeStage;
+		VkAccessFlags writeAccess;
+		VkPipelineStageFlags readStages;
+		VkPipelineStageFlags synced;
+	};
+	std::vector<State> states(_images.size());
+	// Transient images' first barriers wait on the previous user of their memory, filled in once it is known
+	std::vector<std::pair<uint32_t, size_t>> firstBarrier(_images.size(), { UINT32_MAX, 0 });
+	for (size_t i = 0; i < _images.size(); i++) {
+		const Image& image = _images[i];
+		if (image.imported) {
+			// Whatever wrote the image before the graph is unknown
+			states[i] = { image.initialLayout, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+				image.initialLayout == VK_IMAGE_LAYOUT_UNDEFINED ? 0u : (VkAccessFlags)VK_ACCESS_MEMORY_WRITE_BIT, 0, 0 };
+		} else {
+			states[i] = { VK_IMAGE_LAYOUT_UNDEFINED, 0, 0, 0, 0 };
+		}
+	}
+
+	for (uint32_t p = 0; p < (uint32_t)_passes.size(); p++) {
+		Pass& pass = _passes[p];
+		if (pass.culled) {
+			continue;
+		}
+		for (const Use& use : pass.uses) {
+			const Image& image = _images[use.image];
+			State& state = states[use.image];
+			AccessInfo info = accessInfo(use.access, pass.type);
+			bool contents = image.firstPass < p || (image.imported && image.initialLayout != VK_IMAGE_LAYOUT_UNDEFINED);
+			bool transition = state.layout != info.layout;
+			bool first = !image.imported && firstBarrier[use.image].first == UINT32_MAX;
+			bool waitAll = info.write || transition;
+			bool needed = waitAll ? (transition || state.writeStage || state.readStages) : (state.writeStage && !(state.synced & info.stage));
+			if (needed || first) {
+				VkPipelineStageFlags src = waitAll ? state.writeStage | state.readStages : state.writeStage;
+				pass.barriers.push_back({
+					.image = use.image,
+					// Cleared or never written contents are discarded instead of transitioned
+					.oldLayout = use.clear || !contents ? VK_IMAGE_LAYOUT_UNDEFINED : state.layout,
+					.newLayout = info.layout,
+					.srcStage = src ? src : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+					.dstStage = info.stage,
+					.srcAccess = state.writeAccess,
+					.dstAccess = info.access,
+				});
+				if (first) {
+					firstBarrier[use.image] = { p, pass.barriers.size() - 1 };
+				}
+			}
+
+			if (info.write) {
+				state = { info.layout, info.stage, info.access & writeAccesses, 0, 0 };
+			} else if (transition) {
+				// Later readers in other stages chain on this barrier's destination stage
+				state = { info.layout, info.stage, 0, info.stage, info.stage };
+			} else {
+				state.readStages |= info.stage;
+				if (needed) {
+					state.synced |= info.stage;
+				}
+			}
+		}
+	}
+
+	// Within a frame the previous occupant of the slot, for the first occupant the last one of the previous frame
+	for (const Slot& slot : _slots) {
+		for (size_t i = 0; i < slot.images.size(); i++) {
+			Handle image = slot.images[i];
+			Handle previous = slot.images[(i + slot.images.size() - 1) % slot.images.size()];
+			auto [p, b] = firstBarrier[image];
+			Barrier& barrier = _passes[p].barriers[b];
+			VkPipelineStageFlags src = states[previous].writeStage | states[previous].readStages;
+			barrier.srcStage = src ? src : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			barrier.srcAccess = states[previous].writeAccess;
+		}
+	}
+
+	for (Handle h = 0; h < (Handle)_images.size(); h++) {
+		const Image& image = _images[h];
+		const State& state = states[h];
+		if (!image.imported || image.finalLayout == VK_IMAGE_LAYOUT_UNDEFINED || state.layout == image.finalLayout) {
+			continue;
+		}
+		VkPipelineStageFlags src = state.writeStage | state.readStages;
+		_finalBarriers.push_back({
+			.image = h,
+			.oldLayout = state.layout,
+			.newLayout = image.finalLayout,
+			.srcStage = src ? src : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			.dstStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			.srcAccess = state.writeAccess,
+			.dstAccess = 0,
+		});
+	}
+}
+
+void RenderGraph::compile(const VkCtx& ctx)
+{
+	if (_compiled) {
+		throw std::runtime_error("Render graph is already compiled");
+	}
+	_compiled = true;
+	cull();
+
+	_stats = {};
+	for (uint32_t p = 0; p < (uint32_t)_passes.size(); p++) {
+		Pass& pass = _passes[p];
+		if (pass.culled) {
+			_stats.culledPasses++;
+			continue;
+		}
+		_stats.passes++;
+		for (const Use& use : pass.uses) {
+			Image& image = _images[use.image];
+			image.firstPass = std::min(image.firstPass, p);
+			image.lastPass = std::max(image.lastPass, p);
+			image.usage |= accessInfo(use.access, pass.type).usage;
+		}
+	}
+
+	allocate(ctx);
+	for (Pass& pass : _passes) {
+		if (!pass.culled && pass.type == PassType::Graphics) {
+			createRenderPass(ctx, pass);
+		}
+	}
+	buildBarriers();
+
+	for (const Pass& pass : _passes) {
+		_stats.imageBarriers += (uint32_t)pass.barriers.size();
+		_stats.barrierBatches += pass.barriers.empty() ? 0 : 1;
+	}
+	_stats.imageBarriers += (uint32_t)_finalBarriers.size();
+	_stats.barrierBatches += _finalBarriers.empty() ? 0 : 1;
+}
+
+void RenderGraph::recordBarriers(VkCommandBuffer buf, const std::vector<Barrier>& barriers) const
+{
+	if (barriers.empty()) {
+		return;
+	}
+	// One call per pass, the stage masks are the union of every image's
+	std::vector<VkImageMemoryBarrier> imageBarriers;
+	VkPipelineStageFlags src = 0;
+	VkPipelineStageFlags dst = 0;
+	for (const Barrier& barrier : barriers) {
+		const Image& image = _images[barrier.image];
+		imageBarriers.push_back({
+			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+			.srcAccessMask = barrier.srcAccess,
+			.dstAccessMask = barrier.dstAccess,
+			.oldLayout = barrier.oldLayout,
+			.newLayout = barrier.newLayout,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = image.image,
+			.subresourceRange = {
+				.aspectMask = image.aspect,
+				.baseMipLevel = 0,
+				.levelCount = 1,
+				.baseArrayLayer = 0,
+				.layerCount = 1,
+			},
+		});
+		src |= barrier.srcStage;
+		dst |= barrier.dstStage;
+	}
+	vkCmdPipelineBarrier(buf, src, dst, 0, 0, nullptr, 0, nullptr, (uint32_t)imageBarriers.size(), imageBarriers.data());
+}
+
+VkFramebuffer RenderGraph::framebuffer(const VkCtx& ctx, Pass& pass)
+{
+	std::vector<VkImageView> views;
+	for (const Use& use : pass.uses) {
+		if (isAttachment(use.access)) {
+			views.push_back(_images[use.image].view);
+		}
+	}
+	auto it = pass.framebuffers.find(views);
+	if (it != pass.framebuffers.end()) {
+		return it->second;
+	}
+
+	VkFramebufferCreateInfo framebufferInfo = {
+		.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+		.renderPass = pass.renderPass,
+		.attachmentCount = (uint32_t)views.size(),
+		.pAttachments = views.data(),
+		.width = pass.extent.width,
+		.height = pass.extent.height,
+		.layers = 1,
+	};
+	VkFramebuffer framebuffer;
+	CHK_ERR(vkCreateFramebuffer(ctx.device(), &framebufferInfo, nullptr, &framebuffer));
+	pass.framebuffers.emplace(std::move(views), framebuffer);
+	return framebuffer;
+}
+
+void RenderGraph::execute(const VkCtx& ctx, VkCommandBuffer buf)
+{
+	if (!_compiled) {
+		throw std::runtime_error("Render graph is not compiled");
+	}
+	for (Pass& pass : _passes) {
+		if (pass.culled) {
+			continue;
+		}
+		recordBarriers(buf, pass.barriers);
+		if (pass.type != PassType::Graphics) {
+			if (pass.execute) {
+				pass.execute(buf);
+			}
+			continue;
+		}
+
+		VkRenderPassBeginInfo beginInfo = {
+			.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+			.renderPass = pass.renderPass,
+			.framebuffer = framebuffer(ctx, pass),
+			.renderArea = { { 0, 0 }, pass.extent },
+			.clearValueCount = (uint32_t)pass.clearValues.size(),
+			.pClearValues = pass.clearValues.data(),
+		};
+		vkCmdBeginRenderPass(buf, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		VkViewport viewport = { 0.0f, 0.0f, (float)pass.extent.width, (float)pass.extent.height, 0.0f, 1.0f };
+		VkRect2D scissor = { { 0, 0 }, pass.extent };
+		vkCmdSetViewport(buf, 0, 1, &viewport);
+		vkCmdSetScissor(buf, 0, 1, &scissor);
+		if (pass.execute) {
+			pass.execute(buf);
+		}
+		vkCmdEndRenderPass(buf);
+	}
+	recordBarriers(buf, _finalBarriers);
+}
\ No newline at end of file
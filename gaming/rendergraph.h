@@ -0,0 +1,171 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "vkctx.h"
+
+// Totals for the compiled graph, barriers are per executed frame
+struct RenderGraphStats {
+	uint32_t passes;
+	uint32_t culledPasses;
+	uint32_t imageBarriers;
+	uint32_t barrierBatches;
+	// Transient image memory if every image had its own allocation, and what was allocated after aliasing
+	VkDeviceSize transientMemory;
+	VkDeviceSize aliasedMemory;
+};
+
+// Frame graph of passes that declare the images they read and write
+// compile() culls passes whose results are never used, picks attachment load/store ops, creates the render passes
+// and framebuffers, aliases the memory of transient images with disjoint lifetimes and precomputes one batched
+// pipeline barrier per pass, execute() then only records barriers and calls the passes
+// The graph is built and compiled once, imported images (the swapchain) are swapped per frame with setImported
+// Pass extents and transient images are sized at compile, so a resize means destroying and rebuilding the graph
+// Buffers are not tracked, passes keep synchronising their own buffer writes
+class RenderGraph {
+public:
+	typedef uint32_t Handle;
+	// For graphics passes the command buffer is inside the pass's render pass with viewport and scissor set
+	typedef std::function<void(VkCommandBuffer)> ExecuteFn;
+
+	enum class PassType {
+		Graphics,
+		Compute,
+		Transfer,
+	};
+
+	enum class Access {
+		ColorAttachment,
+		DepthAttachment,
+		// Depth tested but not written
+		DepthRead,
+		// Sampled in the fragment shader of a graphics pass or in a compute pass
+		Sampled,
+		StorageRead,
+		StorageWrite,
+		TransferSrc,
+		TransferDst,
+	};
+
+	class PassBuilder {
+	private:
+		RenderGraph& _graph;
+		Handle _pass;
+
+		PassBuilder& use(Handle image, Access access);
+	public:
+		PassBuilder(RenderGraph& graph, Handle pass) : _graph(graph), _pass(pass) {}
+		// Attachments without a clear value load the previous contents, or leave them undefined if nothing wrote them
+		PassBuilder& color(Handle image);
+		PassBuilder& color(Handle image, VkClearColorValue clear);
+		PassBuilder& depth(Handle image);
+		PassBuilder& depth(Handle image, float clear);
+		PassBuilder& read(Handle image, Access access);
+		PassBuilder& write(Handle image, Access access);
+		// Kept even when nothing reads its results (readbacks, queries)
+		PassBuilder& sideEffect();
+		PassBuilder& execute(ExecuteFn fn);
+		Handle handle() const { return _pass; }
+	};
+private:
+	struct Use {
+		Handle image;
+		Access access;
+		bool clear;
+		VkClearValue clearValue;
+	};
+
+	struct Barrier {
+		Handle image;
+		VkImageLayout oldLayout;
+		VkImageLayout newLayout;
+		VkPipelineStageFlags srcStage;
+		VkPipelineStageFlags dstStage;
+		VkAccessFlags srcAccess;
+		VkAccessFlags dstAccess;
+	};
+
+	struct Pass {
+		std::string name;
+		PassType type;
+		std::vector<Use> uses;
+		ExecuteFn execute;
+		bool sideEffect;
+		bool culled;
+		std::vector<Barrier> barriers;
+		VkRenderPass renderPass;
+		VkExtent2D extent;
+		std::vector<VkClearValue> clearValues;
+		// Keyed by attachment views since imported views change every frame, one entry per swapchain image
+		// until releaseImported drops the ones built on imported views
+		std::map<std::vector<VkImageView>, VkFramebuffer> framebuffers;
+	};
+
+	struct Image {
+		std::string name;
+		VkFormat format;
+		VkExtent2D extent;
+		VkImageAspectFlags aspect;
+		VkImageUsageFlags usage;
+		bool imported;
+		VkImageLayout initialLayout;
+		VkImageLayout finalLayout;
+		VkImage image;
+		VkImageView view;
+		uint32_t firstPass;
+		uint32_t lastPass;
+		uint32_t slot;
+	};
+
+	// Memory shared by transient images used by disjoint ranges of passes
+	struct Slot {
+		VkMemoryRequirements requirements;
+		VmaAllocation alloc;
+		uint32_t lastPass;
+		std::vector<Handle> images;
+	};
+
+	std::vector<Pass> _passes;
+	std::vector<Image> _images;
+	std::vector<Slot> _slots;
+	std::vector<Barrier> _finalBarriers;
+	RenderGraphStats _stats;
+	bool _compiled;
+
+	void cull();
+	void allocate(const VkCtx& ctx);
+	void createRenderPass(const VkCtx& ctx, Pass& pass);
+	void buildBarriers();
+	void recordBarriers(VkCommandBuffer buf, const std::vector<Barrier>& barriers) const;
+	VkFramebuffer framebuffer(const VkCtx& ctx, Pass& pass);
+public:
+	RenderGraph();
+	void destroy(const VkCtx& ctx);
+
+	// Transient image owned by the graph, its usage flags are derived from the passes that access it
+	Handle createImage(const std::string& name, VkFormat format, VkExtent2D extent);
+	// Image owned elsewhere, its contents are discarded when initialLayout is UNDEFINED and are not needed
+	// after the frame when finalLayout is UNDEFINED, otherwise it is left in finalLayout
+	Handle importImage(const std::string& name, VkFormat format, VkExtent2D extent, VkImageLayout initialLayout, VkImageLayout finalLayout);
+	void setImported(Handle image, VkImage vkImage, VkImageView view);
+	// Destroys the cached framebuffers that attach imported views, call with the device idle whenever the imported
+	// images are recreated at the same extent since new views may reuse old handles
+	// Extents are fixed at compile, a swapchain resize needs a new graph built for the new extent
+	void releaseImported(const VkCtx& ctx);
+	PassBuilder addPass(const std::string& name, PassType type);
+
+	void compile(const VkCtx& ctx);
+	// Imported images must have been set for this frame
+	void execute(const VkCtx& ctx, VkCommandBuffer buf);
+
+	// For pipeline creation, valid after compile
+	VkRenderPass renderPass(Handle pass) const { return _passes[pass].renderPass; }
+	// For binding transient images in descriptors, valid after compile
+	VkImageView view(Handle image) const { return _images[image].view; }
+	VkImage image(Handle image) const { return _images[image].image; }
+	bool culled(Handle pass) const { return _passes[pass].culled; }
+	const RenderGraphStats& stats() const { return _stats; }
+};
\ No newline at end of file
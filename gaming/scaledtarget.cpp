@@ -0,0 +1,237 @@
+#include "scaledtarget.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "vkimage.h"
+
+ScaledTarget::ScaledTarget(const VkCtx& ctx, VkFormat colorFormat, VkExtent2D extent, VkImageLayout colorLayout)
+	: _colorImage(VK_NULL_HANDLE),
+	_colorAlloc(nullptr),
+	_colorView(VK_NULL_HANDLE),
+	_depthImage(VK_NULL_HANDLE),
+	_depthAlloc(nullptr),
+	_depthView(VK_NULL_HANDLE),
+	_renderPass(VK_NULL_HANDLE),
+	_framebuffer(VK_NULL_HANDLE),
+	_extent(extent)
+{
+	VkFormat depthFormat = VK_FORMAT_D32_SFLOAT;
+	createDeviceImage(ctx, colorFormat, extent, 1, VK_IMAGE_VIEW_TYPE_2D,
+		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		VK_IMAGE_ASPECT_COLOR_BIT, _colorImage, _colorAlloc, _colorView);
+	createDeviceImage(ctx, depthFormat, extent, 1, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+		VK_IMAGE_ASPECT_DEPTH_BIT, _depthImage, _depthAlloc, _depthView);
+
+	VkAttachmentDescription descs[] = {
+		{
+			.format = colorFormat,
+			.samples = VK_SAMPLE_COUNT_1_BIT,
+			.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+			.storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+			.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+			.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+			.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+			.finalLayout = colorLayout,
+		},
+		{
+			.format = depthFormat,
+			.samples = VK_SAMPLE_COUNT_1_BIT,
+			.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+			.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+			.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+			.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+			.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+			.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+		},
+	};
+
+	VkAttachmentReference colorRef = {
+		.attachment = 0,
+		.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+	};
+	VkAttachmentReference depthRef = {
+		.attachment = 1,
+		.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+	};
+	VkSubpassDescription subpassDesc = {
+		.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+		.colorAttachmentCount = 1,
+		.pColorAttachments = &colorRef,
+		.pDepthStencilAttachment = &depthRef,
+	};
+
+	VkSubpassDependency deps[] = {
+		// The previous frame's upscale may still be reading the color image
+		{
+			.srcSubpass = VK_SUBPASS_EXTERNAL,
+			.dstSubpass = 0,
+			.srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+			.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+			.srcAccessMask = 0,
+			.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+		},
+		{
+			.srcSubpass = 0,
+			.dstSubpass = VK_SUBPASS_EXTERNAL,
+			.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+			.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+		},
+	};
+
+	VkRenderPassCreateInfo renderpassInfo = {
+		.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+		.attachmentCount = 2,
+		.pAttachments = descs,
+		.subpassCount = 1,
+		.pSubpasses = &subpassDesc,
+		.dependencyCount = 2,
+		.pDependencies = deps,
+	};
+	CHK_ERR(vkCreateRenderPass(ctx.device(), &renderpassInfo, nullptr, &_renderPass));
+
+	VkImageView views[] = { _colorView, _depthView };
+	VkFramebufferCreateInfo framebufferInfo = {
+		.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+		.renderPass = _renderPass,
+		.attachmentCount = 2,
+		.pAttachments = views,
+		.width = extent.width,
+		.height = extent.height,
+		.layers = 1,
+	};
+	CHK_ERR(vkCreateFramebuffer(ctx.device(), &framebufferInfo, nullptr, &_framebuffer));
+}
+
+void ScaledTarget::destroy(const VkCtx& ctx)
+{
+	vkDestroyFramebuffer(ctx.device(), _framebuffer, nullptr);
+	vkDestroyRenderPass(ctx.device(), _renderPass, nullptr);
+	vkDestroyImageView(ctx.device(), _depthView, nullptr);
+	vmaDestroyImage(ctx.allocator(), _depthImage, _depthAlloc);
+	vkDestroyImageView(ctx.device(), _colorView, nullptr);
+	vmaDestroyImage(ctx.allocator(), _colorImage, _colorAlloc);
+}
+
+VkExtent2D ScaledTarget::renderExtent(float scale) const
+{
+	uint32_t width = (uint32_t)std::lround(_extent.width * scale);
+	uint32_t height = (uint32_t)std::lround(_extent.height * scale);
+	return { std::clamp(width, 1u, _extent.width), std::clamp(height, 1u, _extent.height) };
+}
+
+void ScaledTarget::begin(VkCommandBuffer buf, VkExtent2D renderExtent) const
+{
+	VkClearValue clearValues[] = { {}, {} };
+	clearValues[1].depthStencil = { 1.0f, 0 };
+	VkRenderPassBeginInfo beginInfo = {
+		.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+		.renderPass = _renderPass,
+		.framebuffer = _framebuffer,
+		.renderArea = { { 0, 0 }, renderExtent },
+		.clearValueCount = 2,
+		.pClearValues = clearValues,
+	};
+	vkCmdBeginRenderPass(buf, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	VkViewport viewport = { 0.0f, 0.0f, (float)renderExtent.width, (float)renderExtent.height, 0.0f, 1.0f };
+	VkRect2D scissor = { { 0, 0 }, renderExtent };
+	vkCmdSetViewport(buf, 0, 1, &viewport);
+	vkCmdSetScissor(buf, 0, 1, &scissor);
+}
+
+static void colorBarrier(VkCommandBuffer buf, VkImage image, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkAccessFlags dstAccess,
+	VkImageLayout oldLayout, VkImageLayout newLayout)
+{
+	VkImageMemoryBarrier barrier = {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+		.srcAccessMask = srcAccess,
+		.dstAccessMask = dstAccess,
+		.oldLayout = oldLayout,
+		.newLayout = newLayout,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.image = image,
+		.subresourceRange = {
+			.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+			.baseMipLevel = 0,
+			.levelCount = 1,
+			.baseArrayLayer = 0,
+			.layerCount = 1,
+		},
+	};
+	vkCmdPipelineBarrier(buf, srcStage, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+static VkImageCopy texelStrip(int32_t srcX, int32_t srcY, int32_t dstX, int32_t dstY, uint32_t width, uint32_t height)
+{
+	return {
+		.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
+		.srcOffset = { srcX, srcY, 0 },
+		.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
+		.dstOffset = { dstX, dstY, 0 },
+		.extent = { width, height, 1 },
+	};
+}
+
+void ScaledTarget::clampEdges(VkCommandBuffer buf, VkExtent2D renderExtent) const
+{
+	bool column = renderExtent.width < _extent.width;
+	bool row = renderExtent.height < _extent.height;
+	if (!column && !row) {
+		return;
+	}
+	// The copies read and write the same image, which needs GENERAL
+	colorBarrier(buf, _colorImage, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+		VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL);
+	int32_t w = (int32_t)renderExtent.width;
+	int32_t h = (int32_t)renderExtent.height;
+	if (column) {
+		VkImageCopy copy = texelStrip(w - 1, 0, w, 0, 1, renderExtent.height);
+		vkCmdCopyImage(buf, _colorImage, VK_IMAGE_LAYOUT_GENERAL, _colorImage, VK_IMAGE_LAYOUT_GENERAL, 1, &copy);
+	}
+	if (row) {
+		if (column) {
+			// The row copy includes the corner texel the column copy just wrote
+			colorBarrier(buf, _colorImage, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+				VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+		}
+		VkImageCopy copy = texelStrip(0, h - 1, 0, h, renderExtent.width + (column ? 1 : 0), 1);
+		vkCmdCopyImage(buf, _colorImage, VK_IMAGE_LAYOUT_GENERAL, _colorImage, VK_IMAGE_LAYOUT_GENERAL, 1, &copy);
+	}
+	colorBarrier(buf, _colorImage, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+}
+
+void ScaledTarget::upscale(VkCommandBuffer buf, VkExtent2D renderExtent, VkImage target, VkExtent2D targetExtent) const
+{
+	clampEdges(buf, renderExtent);
+
+	VkImageMemoryBarrier toTransfer = {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+		.srcAccessMask = 0,
+		.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+		.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+		.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.image = target,
+		.subresourceRange = {
+			.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+			.baseMipLevel = 0,
+			.levelCount = 1,
+			.baseArrayLayer = 0,
+			.layerCount = 1,
+		},
+	};
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+	VkImageBlit region = {
+		.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
+		.srcOffsets = { { 0, 0, 0 }, { (int32_t)renderExtent.width, (int32_t)renderExtent.height, 1 } },
+		.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
+		.dstOffsets = { { 0, 0, 0 }, { (int32_t)targetExtent.width, (int32_t)targetExtent.height, 1 } },
+	};
+	vkCmdBlitImage(buf, _colorImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, target, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region, VK_FILTER_LINEAR);
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "vkctx.h"
+
+// Offscreen color and depth target the scene is rendered into at a variable resolution (DynamicResolution)
+// The images are allocated once at the full extent and each frame only renders into the top left renderExtent,
+// so changing the scale never reallocates anything and can happen every frame
+// Pipelines are created against renderPass(), viewport and scissor are already dynamic state
+class ScaledTarget {
+private:
+	VkImage _colorImage;
+	VmaAllocation _colorAlloc;
+	VkImageView _colorView;
+	VkImage _depthImage;
+	VmaAllocation _depthAlloc;
+	VkImageView _depthView;
+	VkRenderPass _renderPass;
+	VkFramebuffer _framebuffer;
+	VkExtent2D _extent;
+
+	// Bilinear taps at the right and bottom edge of the rendered area reach one texel past it, which still holds
+	// whatever an earlier frame rendered at a larger scale, so the edge texels are copied outwards first
+	void clampEdges(VkCommandBuffer buf, VkExtent2D renderExtent) const;
+public:
+	// extent is the largest render size, usually the window's, colorFormat must support blits to the window
+	// colorLayout is where the pass leaves the color image, TRANSFER_SRC_OPTIMAL for upscale() or
+	// SHADER_READ_ONLY_OPTIMAL for SpatialUpscaler
+	ScaledTarget(const VkCtx& ctx, VkFormat colorFormat, VkExtent2D extent, VkImageLayout colorLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+	void destroy(const VkCtx& ctx);
+
+	// The extent rendered at scale, never empty or larger than the target
+	VkExtent2D renderExtent(float scale) const;
+
+	// Begins the pass over renderExtent and sets the matching viewport and scissor
+	void begin(VkCommandBuffer buf, VkExtent2D renderExtent) const;
+	// Stretches the rendered area over target with a bilinear blit, the pass must have ended with TRANSFER_SRC_OPTIMAL
+	// The color image is also written: its edge texels are repeated one texel outside renderExtent
+	// target is left in TRANSFER_DST_OPTIMAL for WindowSwapchain::overlayPass, which presents it
+	void upscale(VkCommandBuffer buf, VkExtent2D renderExtent, VkImage target, VkExtent2D targetExtent) const;
+
+	VkRenderPass renderPass() const { return _renderPass; }
+	VkFramebuffer framebuffer() const { return _framebuffer; }
+	VkImage colorImage() const { return _colorImage; }
+	VkImageView colorView() const { return _colorView; }
+	VkImageView depthView() const { return _depthView; }
+	VkExtent2D extent() const { return _extent; }
+};
\ No newline at end of file
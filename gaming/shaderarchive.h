@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+// A compiled SPIR-V module packed into the executable at build time (see cmake/EmbedShaders.cmake)
+struct EmbeddedShader {
+	std::string_view name;
+	const uint32_t* code;
+	size_t size; // In bytes, as expected by VkShaderModuleCreateInfo::codeSize
+};
+
+// Every module in the archive, generated into shaderarchive.cpp in the build directory
+std::span<const EmbeddedShader> embeddedShaders();
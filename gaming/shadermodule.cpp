@@ -1,30 +1,37 @@
 #include "shadermodule.h"
 
-#include <fstream>
 #include <stdexcept>
+#include <string>
 
-ShaderModule::ShaderModule(const VkCtx& ctx, std::string filename) :
-	_module(VK_NULL_HANDLE)
-{
-	std::ifstream file(filename, std::ios::ate | std::ios::binary);
-	if (!file.is_open()) {
-		throw std::runtime_error("Could not file file for shader module");
+static const EmbeddedShader& findEmbeddedShader(std::string_view name) {
+	for (const EmbeddedShader& shader : embeddedShaders()) {
+		if (shader.name == name) {
+			return shader;
+		}
 	}
-	size_t size = file.tellg();
-	file.seekg(0, file.beg);	
-	char* buff = new char[size];
-	file.read(buff, size);
-	file.close();
+	throw std::runtime_error("Could not find shader " + std::string(name) + " in shader archive");
+}
+
+ShaderModule::ShaderModule(const VkCtx& ctx, std::string_view name) :
+	ShaderModule(ctx, findEmbeddedShader(name))
+{
+}
 
+ShaderModule::ShaderModule(const VkCtx& ctx, const EmbeddedShader& shader) :
+	ShaderModule(ctx, shader.code, shader.size)
+{
+}
+
+ShaderModule::ShaderModule(const VkCtx& ctx, const uint32_t* code, size_t size) :
+	_module(VK_NULL_HANDLE)
+{
 	VkShaderModuleCreateInfo info = {
 		.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
 		.codeSize = size,
-		.pCode = reinterpret_cast<uint32_t*>(buff),
+		.pCode = code,
 	};
 
 	CHK_ERR(vkCreateShaderModule(ctx.device(), &info, nullptr, &_module));
-
-	delete[] buff;
 }
 
 void ShaderModule::destroy(const VkCtx& ctx)
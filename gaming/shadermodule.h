@@ -1,15 +1,19 @@
 #pragma once
 
-#include <string>
+#include <string_view>
 
 #include "vkctx.h"
+#include "shaderarchive.h"
 
 
 class ShaderModule {
 private:
 	VkShaderModule _module;
 public:
-	ShaderModule(const VkCtx& ctx, std::string filename);
+	// Creates the module from the embedded shader archive, name is the compiled path e.g. "shaders/default.vert.spv"
+	ShaderModule(const VkCtx& ctx, std::string_view name);
+	ShaderModule(const VkCtx& ctx, const EmbeddedShader& shader);
+	ShaderModule(const VkCtx& ctx, const uint32_t* code, size_t size);
 	void destroy(const VkCtx& ctx);
 	VkShaderModule shaderModule() const { return _module; }
 };
\ No newline at end of file
@@ -0,0 +1,21 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(set = 0, binding = 0) readonly buffer Materials {
+    vec4 baseColor;
+} materials[];
+
+layout(push_constant) uniform Indices {
+    uint camera;
+    uint objects;
+    uint object;
+    uint material;
+} indices;
+
+layout(location = 0) in vec3 fragColor;
+
+layout(location = 0) out vec3 outColor;
+
+void main() {
+    outColor = fragColor * materials[indices.material].baseColor.rgb;
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Every buffer lives in one array, the push constants say which entries this draw reads
+layout(set = 0, binding = 0) readonly buffer Camera {
+    mat4 view;
+    mat4 proj;
+} cameras[];
+
+layout(set = 0, binding = 0) readonly buffer Objects {
+    mat4 model[];
+} objects[];
+
+layout(push_constant) uniform Indices {
+    uint camera;
+    uint objects;
+    uint object;
+    uint material;
+} indices;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNorm;
+layout(location = 2) in vec3 inColor;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    mat4 model = objects[indices.objects].model[indices.object + gl_InstanceIndex];
+    gl_Position = cameras[indices.camera].proj * cameras[indices.camera].view * model * vec4(inPosition, 1.0);
+    fragColor = inColor;
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+// Clustered shading shared by shaders/lit.frag (forward) and shaders/deferred.frag, set 1 is ClusteredLighting's set
+const uvec3 GRID = uvec3(16, 9, 24);
+const uint MAX_LIGHTS_PER_CLUSTER = 128;
+const vec3 AMBIENT = vec3(0.03);
+
+struct Light {
+    vec4 positionRange;
+    vec4 colorIntensity;
+    vec4 direction;
+    vec4 spot;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer Lights {
+    Light lights[];
+};
+
+layout(std430, set = 1, binding = 1) readonly buffer ClusterCounts {
+    uint clusterCounts[];
+};
+
+layout(std430, set = 1, binding = 2) readonly buffer ClusterLights {
+    uint clusterLights[];
+};
+
+layout(std140, set = 1, binding = 3) uniform ClusterUniform {
+    mat4 view;
+    mat4 invProj;
+    vec2 screenSize;
+    vec2 tileSize;
+    float sliceScale;
+    float sliceBias;
+    uint lightCount;
+} clusters;
+
+// Lights the world space position of the current fragment, loops only over the lights binned into its cluster
+vec3 shadeClustered(vec3 position, vec3 normal, vec3 albedo) {
+    // Positive distance along the view direction, selects the depth slice
+    float viewDepth = -(clusters.view * vec4(position, 1.0)).z;
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / clusters.tileSize), GRID.xy - 1);
+    uint slice = min(uint(max(log(viewDepth) * clusters.sliceScale + clusters.sliceBias, 0.0)), GRID.z - 1);
+    uint cluster = (slice * GRID.y + tile.y) * GRID.x + tile.x;
+
+    vec3 light = AMBIENT;
+    uint count = clusterCounts[cluster];
+    for (uint i = 0; i < count; i++) {
+        Light l = lights[clusterLights[cluster * MAX_LIGHTS_PER_CLUSTER + i]];
+        vec3 toLight = l.positionRange.xyz - position;
+        float distance2 = dot(toLight, toLight);
+        float range2 = l.positionRange.w * l.positionRange.w;
+        if (distance2 >= range2) {
+            continue;
+        }
+        vec3 L = toLight * inversesqrt(distance2);
+        // Inverse square falloff windowed to reach zero at the range
+        float window = clamp(1.0 - (distance2 / range2) * (distance2 / range2), 0.0, 1.0);
+        float attenuation = window * window / max(distance2, 1e-4);
+        float spot = clamp(dot(-L, l.direction.xyz) * l.spot.x + l.spot.y, 0.0, 1.0);
+        light += l.colorIntensity.rgb * l.colorIntensity.w * max(dot(normal, L), 0.0) * attenuation * spot * spot;
+    }
+    return albedo * light;
+}
\ No newline at end of file
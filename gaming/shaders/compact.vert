@@ -0,0 +1,35 @@
+#version 450
+
+// Vertex shader for CompactVertex and HalfVertex, vertex fetch already expands the packed formats to floats
+// For CompactVertex the model matrix must include dequantizeTransform
+
+layout(binding = 0) uniform CameraUniform {
+    mat4 view;
+    mat4 proj;
+} camera;
+
+layout(push_constant) uniform ObjectPushConstants {
+    mat4 model;
+} object;
+
+layout(location = 0) in vec4 inPosition;
+layout(location = 1) in vec2 inOctNormal;
+layout(location = 2) in vec4 inColor;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec3 fragNormal;
+
+vec3 octDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+void main() {
+    gl_Position = camera.proj * camera.view * object.model * vec4(inPosition.xyz, 1.0);
+    fragColor = inColor.rgb;
+    // Inverse transpose since the dequantization scale is not uniform
+    fragNormal = normalize(transpose(inverse(mat3(object.model))) * octDecode(inOctNormal));
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#version 450
+
+layout(binding = 0) uniform CameraUniform {
+    mat4 view;
+    mat4 proj;
+} camera;
+
+layout(push_constant) uniform ObjectPushConstants {
+    mat4 model;
+} object;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNorm;
+layout(location = 2) in vec3 inColor;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    gl_Position = camera.proj * camera.view * object.model * vec4(inPosition, 1.0);
+    fragColor = inColor;
+}
\ No newline at end of file
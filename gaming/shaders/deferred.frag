@@ -0,0 +1,28 @@
+#version 450
+
+// Lighting subpass of DeferredRenderer, reads this pixel's G-buffer texel in place and shades it with the
+// clustered light lists, the same shading as shaders/lit.frag
+#include "clustered.glsl"
+
+layout(input_attachment_index = 0, set = 2, binding = 0) uniform subpassInput gAlbedo;
+layout(input_attachment_index = 1, set = 2, binding = 1) uniform subpassInput gNormal;
+layout(input_attachment_index = 2, set = 2, binding = 2) uniform subpassInput gDepth;
+
+layout(std140, set = 2, binding = 3) uniform GBufferUniform {
+    mat4 invViewProj;
+} gbuffer;
+
+layout(location = 0) out vec3 outColor;
+
+void main() {
+    float depth = subpassLoad(gDepth).r;
+    // Nothing was drawn here, keep the clear color
+    if (depth >= 1.0) {
+        discard;
+    }
+    vec2 ndc = gl_FragCoord.xy / clusters.screenSize * 2.0 - 1.0;
+    vec4 world = gbuffer.invViewProj * vec4(ndc, depth, 1.0);
+    vec3 albedo = subpassLoad(gAlbedo).rgb;
+    vec3 n = normalize(subpassLoad(gNormal).xyz * 2.0 - 1.0);
+    outColor = shadeClustered(world.xyz / world.w, n, albedo);
+}
\ No newline at end of file
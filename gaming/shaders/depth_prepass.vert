@@ -0,0 +1,25 @@
+#version 450
+
+// Depth only pass for TransformPath::Instanced, reads a PositionVertex stream and has no fragment stage
+// The transform is the same expression as shaders/instanced.vert, both invariant so the depths are identical
+layout(binding = 0) uniform CameraUniform {
+    mat4 view;
+    mat4 proj;
+} camera;
+
+struct InstanceData {
+    mat4 model;
+    vec4 color;
+};
+
+layout(std430, binding = 1) readonly buffer Instances {
+    InstanceData instances[];
+};
+
+layout(location = 0) in vec3 inPosition;
+
+invariant gl_Position;
+
+void main() {
+    gl_Position = camera.proj * camera.view * instances[gl_InstanceIndex].model * vec4(inPosition, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,8 @@
+#version 450
+
+// One triangle covering the screen, drawn with vkCmdDraw(3) and no vertex buffers
+// Wound clockwise in framebuffer space to survive the default back face culling
+void main() {
+    vec2 uv = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+    gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);
+}
\ No newline at end of file
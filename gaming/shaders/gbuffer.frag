@@ -0,0 +1,19 @@
+#version 450
+
+// Geometry subpass of DeferredRenderer, lighting is deferred to shaders/deferred.frag
+#include "lodfade.glsl"
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in float fragFade;
+layout(location = 2) in vec3 fragPosition;
+layout(location = 3) in vec3 fragNormal;
+
+layout(location = 0) out vec4 outAlbedo;
+// Packed into A2B10G10R10
+layout(location = 1) out vec4 outNormal;
+
+void main() {
+    lodFade(fragFade);
+    outAlbedo = vec4(fragColor, 1.0);
+    outNormal = vec4(normalize(fragNormal) * 0.5 + 0.5, 0.0);
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#version 450
+
+layout(binding = 0) uniform CameraUniform {
+    mat4 view;
+    mat4 proj;
+} camera;
+
+struct InstanceData {
+    mat4 model;
+    vec4 color;
+};
+
+layout(std430, binding = 1) readonly buffer Instances {
+    InstanceData instances[];
+};
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNorm;
+layout(location = 2) in vec3 inColor;
+
+layout(location = 0) out vec3 fragColor;
+// LOD crossfade coverage for shaders/lod.frag, see LodDraw
+layout(location = 1) out float fragFade;
+// Must match shaders/depth_prepass.vert bit for bit for the EQUAL depth test after a prepass
+invariant gl_Position;
+
+void main() {
+    InstanceData instance = instances[gl_InstanceIndex];
+    gl_Position = camera.proj * camera.view * instance.model * vec4(inPosition, 1.0);
+    fragColor = inColor * instance.color.rgb;
+    fragFade = instance.color.a;
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#version 450
+#extension GL_EXT_multiview : require
+
+// shaders/instanced.vert for MultiviewTarget, every draw is broadcast to all views of the pass
+// and each view picks its camera with gl_ViewIndex
+layout(binding = 0) uniform MultiviewCameraUniform {
+    mat4 viewProj[4];
+} camera;
+
+struct InstanceData {
+    mat4 model;
+    vec4 color;
+};
+
+layout(std430, binding = 1) readonly buffer Instances {
+    InstanceData instances[];
+};
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNorm;
+layout(location = 2) in vec3 inColor;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out float fragFade;
+
+void main() {
+    InstanceData instance = instances[gl_InstanceIndex];
+    gl_Position = camera.viewProj[gl_ViewIndex] * instance.model * vec4(inPosition, 1.0);
+    fragColor = inColor * instance.color.rgb;
+    fragFade = instance.color.a;
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#version 450
+
+// Clustered forward shading, loops only over the lights ClusteredLighting binned into this fragment's cluster
+#include "clustered.glsl"
+#include "lodfade.glsl"
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in float fragFade;
+layout(location = 2) in vec3 fragPosition;
+layout(location = 3) in vec3 fragNormal;
+
+layout(location = 0) out vec3 outColor;
+
+void main() {
+    lodFade(fragFade);
+    outColor = shadeClustered(fragPosition, normalize(fragNormal), fragColor);
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#version 450
+
+// shaders/instanced.vert plus the world space position and normal for shaders/lit.frag
+layout(binding = 0) uniform CameraUniform {
+    mat4 view;
+    mat4 proj;
+} camera;
+
+struct InstanceData {
+    mat4 model;
+    vec4 color;
+};
+
+layout(std430, binding = 1) readonly buffer Instances {
+    InstanceData instances[];
+};
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNorm;
+layout(location = 2) in vec3 inColor;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out float fragFade;
+layout(location = 2) out vec3 fragPosition;
+layout(location = 3) out vec3 fragNormal;
+// Matches shaders/depth_prepass.vert for the EQUAL test after a prepass
+invariant gl_Position;
+
+void main() {
+    InstanceData instance = instances[gl_InstanceIndex];
+    gl_Position = camera.proj * camera.view * instance.model * vec4(inPosition, 1.0);
+    vec4 world = instance.model * vec4(inPosition, 1.0);
+    fragColor = inColor * instance.color.rgb;
+    fragFade = instance.color.a;
+    fragPosition = world.xyz;
+    // Assumes uniform scale, as the rest of the instanced path does
+    fragNormal = mat3(instance.model) * inNorm;
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+#version 450
+
+// default.frag with a dithered crossfade between two levels of detail
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in float fragFade;
+
+layout(location = 0) out vec3 outColor;
+
+#include "lodfade.glsl"
+
+void main() {
+    lodFade(fragFade);
+    outColor = fragColor;
+}
\ No newline at end of file
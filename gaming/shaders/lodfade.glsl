@@ -0,0 +1,17 @@
+// Dithered crossfade between two levels of detail, fade comes from InstanceData::color.a (see LodDraw)
+// fade > 0 keeps that fraction of a 4x4 ordered dither, fade < 0 keeps the complementary 1 + fade fraction
+// so the outgoing and incoming levels of an object never draw the same pixel, fade = 1 keeps every pixel
+const float bayer[16] = float[](
+     0.0,  8.0,  2.0, 10.0,
+    12.0,  4.0, 14.0,  6.0,
+     3.0, 11.0,  1.0,  9.0,
+    15.0,  7.0, 13.0,  5.0
+);
+
+void lodFade(float fade) {
+    ivec2 p = ivec2(gl_FragCoord.xy) & 3;
+    float threshold = (bayer[p.y * 4 + p.x] + 0.5) / 16.0;
+    if (fade >= 0.0 ? threshold >= fade : threshold < fade + 1.0) {
+        discard;
+    }
+}
\ No newline at end of file
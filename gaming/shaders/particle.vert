@@ -0,0 +1,64 @@
+#version 450
+
+// Camera facing quads for the particles ParticleSystem compacted this frame, two triangles per instance
+struct ParticleData {
+    vec4 positionAge;
+    vec4 velocityLifetime;
+    vec4 color;
+};
+
+layout(std430, binding = 0) readonly buffer Particles {
+    ParticleData particles[];
+};
+
+layout(std430, binding = 2) readonly buffer AliveLists {
+    uint aliveLists[];
+};
+
+layout(std430, binding = 4) readonly buffer SortKeys {
+    uvec2 sortKeys[];
+};
+
+layout(std140, binding = 5) uniform SimulationUniform {
+    mat4 view;
+    mat4 viewProj;
+    mat4 invViewProj;
+    vec4 gravityDrag;
+    vec2 depthSize;
+    float deltaTime;
+    float time;
+    float curlStrength;
+    float curlScale;
+    float restitution;
+    float collisionThickness;
+    float size;
+    uint parity;
+    uint capacity;
+    uint sorted;
+} sim;
+
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec2 fragCorner;
+
+const vec2 corners[6] = vec2[](
+    vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+    vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0)
+);
+
+void main() {
+    // The uniform still has the parity simulation read from, the draw reads the list it compacted into
+    uint slot = gl_InstanceIndex;
+    uint index = sim.sorted != 0 ? sortKeys[slot].y : aliveLists[(1 - sim.parity) * sim.capacity + slot];
+    ParticleData particle = particles[index];
+
+    vec2 corner = corners[gl_VertexIndex];
+    vec3 right = vec3(sim.view[0][0], sim.view[1][0], sim.view[2][0]);
+    vec3 up = vec3(sim.view[0][1], sim.view[1][1], sim.view[2][1]);
+    vec3 world = particle.positionAge.xyz + (right * corner.x + up * corner.y) * sim.size;
+    gl_Position = sim.viewProj * vec4(world, 1.0);
+
+    // Fades out over its life
+    float life = particle.positionAge.w / particle.velocityLifetime.w;
+    fragColor = vec4(particle.color.rgb, particle.color.a * (1.0 - life));
+    fragCorner = corner;
+}
\ No newline at end of file
@@ -0,0 +1,215 @@
+#include "skinning.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+static constexpr uint32_t groupSize = 64;
+
+// Matches SkinConstants in shaders/skinning.comp
+struct SkinConstants {
+	uint32_t jobCount;
+	uint32_t vertexCount;
+};
+
+static VkDescriptorSetLayout createSkinningSetLayout(const VkCtx& ctx)
+{
+	VkDescriptorSetLayoutBinding bindings[4];
+	for (uint32_t i = 0; i < 4; i++) {
+		bindings[i] = {
+			.binding = i,
+			.descriptorType = i == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.descriptorCount = 1,
+			.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+		};
+	}
+	VkDescriptorSetLayoutCreateInfo descriptorLayoutInfo = {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+		.bindingCount = 4,
+		.pBindings = bindings,
+	};
+	VkDescriptorSetLayout descriptorLayout;
+	CHK_ERR(vkCreateDescriptorSetLayout(ctx.device(), &descriptorLayoutInfo, nullptr, &descriptorLayout));
+	return descriptorLayout;
+}
+
+static VkPipelineLayout createSkinningLayout(const VkCtx& ctx, VkDescriptorSetLayout descriptorLayout)
+{
+	VkPushConstantRange pushRange = {
+		.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+		.offset = 0,
+		.size = sizeof(SkinConstants),
+	};
+	VkPipelineLayoutCreateInfo info = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+		.setLayoutCount = 1,
+		.pSetLayouts = &descriptorLayout,
+		.pushConstantRangeCount = 1,
+		.pPushConstantRanges = &pushRange,
+	};
+	VkPipelineLayout layout;
+	CHK_ERR(vkCreatePipelineLayout(ctx.device(), &info, nullptr, &layout));
+	return layout;
+}
+
+SkinningPass::SkinningPass(const VkCtx& ctx, DescriptorAllocator& descriptors, const ShaderModule& skinShader, size_t frames,
+	uint32_t maxVertices, uint32_t maxInstances, uint32_t maxOutputVertices, uint32_t maxJoints)
+	: _bindPose(ctx, (VkDeviceSize)maxVertices * sizeof(SkinVertex), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT),
+	_jobs(ctx, (VkDeviceSize)maxInstances * sizeof(SkinJob), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT),
+	_palette(ctx, frames, maxJoints),
+	_output(ctx, (VkDeviceSize)maxOutputVertices * sizeof(DefaultVertex), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT),
+	_stagingRetire(0),
+	_frames(frames),
+	_descriptorLayout(createSkinningSetLayout(ctx)),
+	_layout(createSkinningLayout(ctx, _descriptorLayout)),
+	_set(descriptors.allocate(ctx, _descriptorLayout)),
+	_skin(ctx, _layout, skinShader),
+	_maxVertices(maxVertices),
+	_vertexCount(0),
+	_uploadedJobs(0),
+	_outputCount(0),
+	_jointCount(0)
+{
+	DescriptorBindings()
+		.buffer(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _bindPose.buffer())
+		.buffer(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _jobs.buffer())
+		.buffer(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, _palette.buffer(), 0, _palette.range())
+		.buffer(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _output.buffer())
+		.write(ctx, _set);
+}
+
+void SkinningPass::destroy(const VkCtx& ctx)
+{
+	_vertexStaging.clear();
+	_jobStaging.clear();
+	_skin.destroy(ctx);
+	vkDestroyPipelineLayout(ctx.device(), _layout, nullptr);
+	vkDestroyDescriptorSetLayout(ctx.device(), _descriptorLayout, nullptr);
+}
+
+SkinnedMesh SkinningPass::addMesh(std::span<const SkinVertex> vertices)
+{
+	if (_vertexCount + vertices.size() > _maxVertices) {
+		throw std::runtime_error("Skinning bind pose capacity exceeded");
+	}
+	SkinnedMesh mesh = { _vertexCount, (uint32_t)vertices.size(), 0 };
+	for (const SkinVertex& v : vertices) {
+		for (int i = 0; i < 4; i++) {
+			if (v.weights[i] != 0) {
+				mesh.jointCount = std::max(mesh.jointCount, v.joints[i] + 1u);
+			}
+		}
+	}
+	_pendingVertices.insert(_pendingVertices.end(), vertices.begin(), vertices.end());
+	_vertexCount += mesh.vertexCount;
+	return mesh;
+}
+
+uint32_t SkinningPass::addInstance(const SkinnedMesh& mesh, uint32_t jointCount)
+{
+	// The shader indexes the shared palette without bounds checks, a short palette would read another instance's joints
+	if (jointCount < mesh.jointCount) {
+		throw std::runtime_error("Skinning instance has fewer joints than its mesh references");
+	}
+	if ((_jobData.size() + 1) * sizeof(SkinJob) > _jobs.size()) {
+		throw std::runtime_error("Skinning instance capacity exceeded");
+	}
+	if (_outputCount + mesh.vertexCount > _output.size() / sizeof(DefaultVertex)) {
+		throw std::runtime_error("Skinning output capacity exceeded");
+	}
+	if (_jointCount + jointCount > _palette.capacity()) {
+		throw std::runtime_error("Skinning palette capacity exceeded");
+	}
+	// Output ranges are handed out in instance order, the shader relies on that to find a vertex's instance
+	uint32_t instance = (uint32_t)_jointCounts.size();
+	_jobData.push_back({
+		.firstOutput = _outputCount,
+		.firstVertex = mesh.firstVertex,
+		.vertexCount = mesh.vertexCount,
+		.firstJoint = _jointCount,
+	});
+	_jointCounts.push_back(jointCount);
+	_outputCount += mesh.vertexCount;
+	_jointCount += jointCount;
+	return instance;
+}
+
+std::span<glm::mat4> SkinningPass::palette(size_t frame, uint32_t instance)
+{
+	return { _palette.data(frame) + _jobData[instance].firstJoint, _jointCounts[instance] };
+}
+
+void SkinningPass::upload(const VkCtx& ctx, VkCommandBuffer buf)
+{
+	// Earlier skin() calls may still be reading what was uploaded before, new data only lands past it
+	if (!_pendingVertices.empty()) {
+		VkDeviceSize size = _pendingVertices.size() * sizeof(SkinVertex);
+		VkBufferCopy region = {
+			.srcOffset = 0,
+			.dstOffset = (_vertexCount - _pendingVertices.size()) * sizeof(SkinVertex),
+			.size = size,
+		};
+		_vertexStaging.emplace_back(ctx, std::move(_pendingVertices), VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+		_pendingVertices.clear();
+		vkCmdCopyBuffer(buf, _vertexStaging.back().buffer(), _bindPose.buffer(), 1, &region);
+	}
+	if (_uploadedJobs < _jobData.size()) {
+		VkBufferCopy region = {
+			.srcOffset = 0,
+			.dstOffset = _uploadedJobs * sizeof(SkinJob),
+			.size = (_jobData.size() - _uploadedJobs) * sizeof(SkinJob),
+		};
+		_jobStaging.emplace_back(ctx, std::vector<SkinJob>(_jobData.begin() + _uploadedJobs, _jobData.end()), VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+		_uploadedJobs = (uint32_t)_jobData.size();
+		vkCmdCopyBuffer(buf, _jobStaging.back().buffer(), _jobs.buffer(), 1, &region);
+	}
+	_stagingRetire = _frames;
+
+	VkMemoryBarrier copied = {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+	};
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &copied, 0, nullptr, 0, nullptr);
+}
+
+void SkinningPass::skin(const VkCtx& ctx, VkCommandBuffer buf, size_t frame)
+{
+	if (_stagingRetire > 0 && --_stagingRetire == 0) {
+		// Every frame in flight has recorded a skin() since the staging buffers were last used
+		_vertexStaging.clear();
+		_jobStaging.clear();
+	}
+	if (!_pendingVertices.empty() || _uploadedJobs < _jobData.size()) {
+		upload(ctx, buf);
+	}
+	if (_outputCount == 0) {
+		return;
+	}
+	// Last frame's draws must be done reading the output before it is overwritten
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+
+	SkinConstants constants = {
+		.jobCount = (uint32_t)_jointCounts.size(),
+		.vertexCount = _outputCount,
+	};
+	uint32_t offset = _palette.offset(frame);
+	vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_COMPUTE, _skin.pipeline());
+	vkCmdBindDescriptorSets(buf, VK_PIPELINE_BIND_POINT_COMPUTE, _layout, 0, 1, &_set, 1, &offset);
+	vkCmdPushConstants(buf, _layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+	// One thread per output vertex of every instance
+	vkCmdDispatch(buf, (_outputCount + groupSize - 1) / groupSize, 1, 1);
+
+	VkMemoryBarrier written = {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+	};
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &written, 0, nullptr, 0, nullptr);
+}
+
+Mesh SkinningPass::mesh(uint32_t instance, Mesh source) const
+{
+	source.vertexBuffer = _output.buffer();
+	source.vertexOffset = (int32_t)_jobData[instance].firstOutput;
+	return source;
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include <glm/mat4x4.hpp>
+
+#include "vkctx.h"
+#include "vkbuffer.h"
+#include "mesh.h"
+#include "vertexformat.h"
+#include "computeshader.h"
+#include "descriptorallocator.h"
+
+// Bind pose vertices of one mesh inside SkinningPass, shared by every instance of it
+struct SkinnedMesh {
+	uint32_t firstVertex;
+	uint32_t vertexCount;
+	// One past the highest joint index with a nonzero weight, instances need at least this many palette entries
+	uint32_t jointCount;
+};
+
+// Linear blend skinning of every animated instance in one compute dispatch per frame
+// Each instance owns a range of a shared output buffer of DefaultVertex, so the depth prepass and the shaded pass
+// draw the skinned result as ordinary static geometry (see mesh(), positionOnlyInput) instead of skinning per pass
+//
+// Bind poses and the job table are device local, meshes and instances added since the last skin() are copied in
+// through staging buffers by the next one, only the joint palette is written by the CPU every frame
+//
+// Per frame: fill palette() for every instance, then skin() outside a render pass before any pass draws the output
+class SkinningPass {
+private:
+	// Matches SkinJob in shaders/skinning.comp (std430)
+	struct SkinJob {
+		uint32_t firstOutput;
+		uint32_t firstVertex;
+		uint32_t vertexCount;
+		uint32_t firstJoint;
+	};
+
+	DeviceBuffer _bindPose;
+	DeviceBuffer _jobs;
+	FrameStorageBuffer<glm::mat4> _palette;
+	DeviceBuffer _output;
+	// Added since the last upload, and the staging copies of earlier uploads the GPU may still be reading
+	std::vector<SkinVertex> _pendingVertices;
+	std::vector<PackedBuffer<SkinVertex>> _vertexStaging;
+	std::vector<PackedBuffer<SkinJob>> _jobStaging;
+	// Staging is released once every frame in flight has recorded a skin() after the last upload
+	size_t _stagingRetire;
+	size_t _frames;
+	VkDescriptorSetLayout _descriptorLayout;
+	VkPipelineLayout _layout;
+	VkDescriptorSet _set;
+	ComputeShader _skin;
+	std::vector<SkinJob> _jobData;
+	std::vector<uint32_t> _jointCounts;
+	uint32_t _maxVertices;
+	uint32_t _vertexCount;
+	uint32_t _uploadedJobs;
+	uint32_t _outputCount;
+	uint32_t _jointCount;
+
+	void upload(const VkCtx& ctx, VkCommandBuffer buf);
+public:
+	// maxOutputVertices bounds the vertices of all instances together, maxJoints the palette entries of all instances
+	SkinningPass(const VkCtx& ctx, DescriptorAllocator& descriptors, const ShaderModule& skinShader, size_t frames,
+		uint32_t maxVertices, uint32_t maxInstances, uint32_t maxOutputVertices, uint32_t maxJoints);
+	void destroy(const VkCtx& ctx);
+
+	SkinnedMesh addMesh(std::span<const SkinVertex> vertices);
+	// Returns the instance index, jointCount palette entries are reserved for it and must cover mesh.jointCount
+	uint32_t addInstance(const SkinnedMesh& mesh, uint32_t jointCount);
+
+	// Joint matrices of the instance for this frame, each the joint's object space transform times its inverse bind matrix
+	std::span<glm::mat4> palette(size_t frame, uint32_t instance);
+	void skin(const VkCtx& ctx, VkCommandBuffer buf, size_t frame);
+
+	// source indexes the same vertices, in the same order, that were given to addMesh
+	Mesh mesh(uint32_t instance, Mesh source) const;
+
+	VkBuffer output() const { return _output.buffer(); }
+	uint32_t instanceCount() const { return (uint32_t)_jointCounts.size(); }
+};
\ No newline at end of file
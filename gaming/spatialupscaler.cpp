@@ -0,0 +1,196 @@
+#include "spatialupscaler.h"
+
+#include <stdexcept>
+
+#include "vkimage.h"
+
+static constexpr uint32_t groupSize = 16;
+// Both passes keep 16 bit float intermediates so the sharpening isn't fed banded 8 bit input
+static constexpr VkFormat intermediateFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+static VkDescriptorSetLayout createUpscaleSetLayout(const VkCtx& ctx)
+{
+	VkDescriptorSetLayoutBinding bindings[] = {
+		{
+			.binding = 0,
+			.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+			.descriptorCount = 1,
+			.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+		},
+		{
+			.binding = 1,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+			.descriptorCount = 1,
+			.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+		},
+	};
+	VkDescriptorSetLayoutCreateInfo descriptorLayoutInfo = {
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+		.bindingCount = 2,
+		.pBindings = bindings,
+	};
+	VkDescriptorSetLayout descriptorLayout;
+	CHK_ERR(vkCreateDescriptorSetLayout(ctx.device(), &descriptorLayoutInfo, nullptr, &descriptorLayout));
+	return descriptorLayout;
+}
+
+static VkPipelineLayout createUpscaleLayout(const VkCtx& ctx, VkDescriptorSetLayout descriptorLayout, uint32_t pushSize)
+{
+	VkPushConstantRange pushRange = {
+		.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+		.offset = 0,
+		.size = pushSize,
+	};
+	VkPipelineLayoutCreateInfo info = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+		.setLayoutCount = 1,
+		.pSetLayouts = &descriptorLayout,
+		.pushConstantRangeCount = 1,
+		.pPushConstantRanges = &pushRange,
+	};
+	VkPipelineLayout layout;
+	CHK_ERR(vkCreatePipelineLayout(ctx.device(), &info, nullptr, &layout));
+	return layout;
+}
+
+static VkImageMemoryBarrier colorBarrier(VkImage image, VkAccessFlags srcAccess, VkAccessFlags dstAccess, VkImageLayout oldLayout, VkImageLayout newLayout)
+{
+	return {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+		.srcAccessMask = srcAccess,
+		.dstAccessMask = dstAccess,
+		.oldLayout = oldLayout,
+		.newLayout = newLayout,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.image = image,
+		.subresourceRange = {
+			.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+			.baseMipLevel = 0,
+			.levelCount = 1,
+			.baseArrayLayer = 0,
+			.layerCount = 1,
+		},
+	};
+}
+
+SpatialUpscaler::SpatialUpscaler(const VkCtx& ctx, DescriptorAllocator& descriptors, const ShaderModule& upscaleShader, const ShaderModule& sharpenShader,
+	VkImageView source, VkExtent2D outputExtent)
+	: _upscaledImage(VK_NULL_HANDLE),
+	_upscaledAlloc(nullptr),
+	_upscaledView(VK_NULL_HANDLE),
+	_outputImage(VK_NULL_HANDLE),
+	_outputAlloc(nullptr),
+	_outputView(VK_NULL_HANDLE),
+	_sampler(VK_NULL_HANDLE),
+	_descriptorLayout(createUpscaleSetLayout(ctx)),
+	_layout(createUpscaleLayout(ctx, _descriptorLayout, sizeof(UpscaleConstants))),
+	_upscaleSet(descriptors.allocate(ctx, _descriptorLayout)),
+	_sharpenSet(descriptors.allocate(ctx, _descriptorLayout)),
+	_upscale(ctx, _layout, upscaleShader),
+	_sharpen(ctx, _layout, sharpenShader),
+	_outputExtent(outputExtent),
+	_sharpness(0.5f),
+	_initialized(false)
+{
+	if (!ctx.supportsSubgroupOps(VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_VOTE_BIT)) {
+		throw std::runtime_error("Spatial upscaling needs subgroup vote in compute shaders");
+	}
+	createDeviceImage(ctx, intermediateFormat, outputExtent, 1, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		VK_IMAGE_ASPECT_COLOR_BIT, _upscaledImage, _upscaledAlloc, _upscaledView);
+	createDeviceImage(ctx, intermediateFormat, outputExtent, 1, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+		VK_IMAGE_ASPECT_COLOR_BIT, _outputImage, _outputAlloc, _outputView);
+
+	// Reads use texelFetch, the sampler only exists to satisfy the combined image sampler bindings
+	VkSamplerCreateInfo samplerInfo = {
+		.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+		.magFilter = VK_FILTER_NEAREST,
+		.minFilter = VK_FILTER_NEAREST,
+		.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+		.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		.maxLod = VK_LOD_CLAMP_NONE,
+	};
+	CHK_ERR(vkCreateSampler(ctx.device(), &samplerInfo, nullptr, &_sampler));
+
+	DescriptorBindings()
+		.image(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, source, _sampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+		.image(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, _upscaledView, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_GENERAL)
+		.write(ctx, _upscaleSet);
+	DescriptorBindings()
+		.image(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, _upscaledView, _sampler, VK_IMAGE_LAYOUT_GENERAL)
+		.image(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, _outputView, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_GENERAL)
+		.write(ctx, _sharpenSet);
+}
+
+void SpatialUpscaler::destroy(const VkCtx& ctx)
+{
+	_sharpen.destroy(ctx);
+	_upscale.destroy(ctx);
+	vkDestroyPipelineLayout(ctx.device(), _layout, nullptr);
+	vkDestroyDescriptorSetLayout(ctx.device(), _descriptorLayout, nullptr);
+	vkDestroySampler(ctx.device(), _sampler, nullptr);
+	vkDestroyImageView(ctx.device(), _outputView, nullptr);
+	vmaDestroyImage(ctx.allocator(), _outputImage, _outputAlloc);
+	vkDestroyImageView(ctx.device(), _upscaledView, nullptr);
+	vmaDestroyImage(ctx.allocator(), _upscaledImage, _upscaledAlloc);
+}
+
+void SpatialUpscaler::upscale(VkCommandBuffer buf, VkExtent2D sourceExtent, VkImage target)
+{
+	if (!_initialized) {
+		_initialized = true;
+		VkImageMemoryBarrier toGeneral[] = {
+			colorBarrier(_upscaledImage, 0, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL),
+			colorBarrier(_outputImage, 0, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL),
+		};
+		vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 2, toGeneral);
+	} else {
+		// Both intermediates are fully overwritten, but the last frame's sharpen and copy must be done reading them
+		vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, 0, nullptr, 0, nullptr, 0, nullptr);
+	}
+
+	uint32_t groupsX = (_outputExtent.width + groupSize - 1) / groupSize;
+	uint32_t groupsY = (_outputExtent.height + groupSize - 1) / groupSize;
+	UpscaleConstants constants = {
+		(int32_t)sourceExtent.width, (int32_t)sourceExtent.height,
+		(int32_t)_outputExtent.width, (int32_t)_outputExtent.height,
+		_sharpness,
+	};
+	vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_COMPUTE, _upscale.pipeline());
+	vkCmdBindDescriptorSets(buf, VK_PIPELINE_BIND_POINT_COMPUTE, _layout, 0, 1, &_upscaleSet, 0, nullptr);
+	vkCmdPushConstants(buf, _layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+	vkCmdDispatch(buf, groupsX, groupsY, 1);
+
+	VkMemoryBarrier upscaled = {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+	};
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &upscaled, 0, nullptr, 0, nullptr);
+
+	// Sharpening runs at the output resolution
+	constants.srcWidth = constants.dstWidth;
+	constants.srcHeight = constants.dstHeight;
+	vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_COMPUTE, _sharpen.pipeline());
+	vkCmdBindDescriptorSets(buf, VK_PIPELINE_BIND_POINT_COMPUTE, _layout, 0, 1, &_sharpenSet, 0, nullptr);
+	vkCmdPushConstants(buf, _layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+	vkCmdDispatch(buf, groupsX, groupsY, 1);
+
+	// The swapchain format is rarely a storage format, so the result is copied over with a 1:1 blit that converts it
+	VkImageMemoryBarrier toCopy[] = {
+		colorBarrier(_outputImage, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL),
+		colorBarrier(target, 0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL),
+	};
+	vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 2, toCopy);
+
+	VkImageBlit region = {
+		.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
+		.srcOffsets = { { 0, 0, 0 }, { (int32_t)_outputExtent.width, (int32_t)_outputExtent.height, 1 } },
+		.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
+		.dstOffsets = { { 0, 0, 0 }, { (int32_t)_outputExtent.width, (int32_t)_outputExtent.height, 1 } },
+	};
+	vkCmdBlitImage(buf, _outputImage, VK_IMAGE_LAYOUT_GENERAL, target, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region, VK_FILTER_NEAREST);
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "vkctx.h"
+#include "computeshader.h"
+#include "descriptorallocator.h"
+
+// Compute upscaler from a reduced internal resolution to the window's: an edge adaptive spatial upscale
+// (shaders/upscale.comp) followed by contrast adaptive sharpening (shaders/sharpen.comp)
+// Recovers most of the detail a bilinear blit loses, rendering at 67-75% scale comes close to native
+// The source is usually a ScaledTarget created with SHADER_READ_ONLY_OPTIMAL as its color layout
+class SpatialUpscaler {
+private:
+	// Matches UpscaleConstants in both shaders
+	struct UpscaleConstants {
+		int32_t srcWidth;
+		int32_t srcHeight;
+		int32_t dstWidth;
+		int32_t dstHeight;
+		float sharpness;
+	};
+
+	VkImage _upscaledImage;
+	VmaAllocation _upscaledAlloc;
+	VkImageView _upscaledView;
+	VkImage _outputImage;
+	VmaAllocation _outputAlloc;
+	VkImageView _outputView;
+	VkSampler _sampler;
+	VkDescriptorSetLayout _descriptorLayout;
+	VkPipelineLayout _layout;
+	VkDescriptorSet _upscaleSet;
+	VkDescriptorSet _sharpenSet;
+	ComputeShader _upscale;
+	ComputeShader _sharpen;
+	VkExtent2D _outputExtent;
+	float _sharpness;
+	bool _initialized;
+public:
+	// source is read in SHADER_READ_ONLY_OPTIMAL and must not be larger than outputExtent
+	SpatialUpscaler(const VkCtx& ctx, DescriptorAllocator& descriptors, const ShaderModule& upscaleShader, const ShaderModule& sharpenShader,
+		VkImageView source, VkExtent2D outputExtent);
+	void destroy(const VkCtx& ctx);
+
+	// Upscales the top left sourceExtent of the source over target and sharpens it, the source's writes must be
+	// visible to compute shader reads (ScaledTarget's pass does this)
+	// target is left in TRANSFER_DST_OPTIMAL for WindowSwapchain::overlayPass, which presents it
+	void upscale(VkCommandBuffer buf, VkExtent2D sourceExtent, VkImage target);
+
+	// 0 is the mildest sharpening and 1 the strongest
+	void setSharpness(float sharpness) { _sharpness = sharpness; }
+	float sharpness() const { return _sharpness; }
+	VkExtent2D outputExtent() const { return _outputExtent; }
+};
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "staticcommands.h"
+
+StaticCommands::StaticCommands(const VkCtx& ctx, size_t framesInFlight)
+	: _pool(VK_NULL_HANDLE),
+	_framesInFlight(framesInFlight),
+	_renderPass(VK_NULL_HANDLE),
+	_subpass(0),
+	_extent{},
+	_recorded(0),
+	_stats{}
+{
+	VkCommandPoolCreateInfo info = {
+		.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+		.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+		.queueFamilyIndex = ctx.graphicsQueueIndex(),
+	};
+	CHK_ERR(vkCreateCommandPool(ctx.device(), &info, nullptr, &_pool));
+}
+
+void StaticCommands::destroy(const VkCtx& ctx)
+{
+	// Destroying the pool frees every buffer allocated from it
+	vkDestroyCommandPool(ctx.device(), _pool, nullptr);
+	_segments.clear();
+	_retired.clear();
+	_free.clear();
+}
+
+uint32_t StaticCommands::addSegment(RecordFn record)
+{
+	_segments.push_back({ std::move(record), VK_NULL_HANDLE, {}, true });
+	return (uint32_t)_segments.size() - 1;
+}
+
+void StaticCommands::invalidate(uint32_t segment)
+{
+	_segments[segment].dirty = true;
+}
+
+void StaticCommands::invalidateAll()
+{
+	for (Segment& segment : _segments) {
+		segment.dirty = true;
+	}
+}
+
+void StaticCommands::setTarget(VkRenderPass renderPass, uint32_t subpass, VkExtent2D extent)
+{
+	if (renderPass != _renderPass || subpass != _subpass || extent.width != _extent.width || extent.height != _extent.height) {
+		_renderPass = renderPass;
+		_subpass = subpass;
+		_extent = extent;
+		invalidateAll();
+	}
+}
+
+void StaticCommands::beginFrame()
+{
+	_recorded = 0;
+	for (size_t i = 0; i < _retired.size();) {
+		if (--_retired[i].framesLeft == 0) {
+			_free.push_back(_retired[i].buf);
+			_retired[i] = _retired.back();
+			_retired.pop_back();
+		} else {
+			i++;
+		}
+	}
+}
+
+VkCommandBuffer StaticCommands::acquire(const VkCtx& ctx)
+{
+	if (!_free.empty()) {
+		VkCommandBuffer buf = _free.back();
+		_free.pop_back();
+		CHK_ERR(vkResetCommandBuffer(buf, 0));
+		return buf;
+	}
+	VkCommandBufferAllocateInfo info = {
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+		.commandPool = _pool,
+		.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+		.commandBufferCount = 1,
+	};
+	VkCommandBuffer buf;
+	CHK_ERR(vkAllocateCommandBuffers(ctx.device(), &info, &buf));
+	return buf;
+}
+
+void StaticCommands::record(const VkCtx& ctx, Segment& segment)
+{
+	if (segment.buf != VK_NULL_HANDLE) {
+		_retired.push_back({ segment.buf, _framesInFlight });
+	}
+	segment.buf = acquire(ctx);
+
+	VkCommandBufferInheritanceInfo inheritance = {
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+		.renderPass = _renderPass,
+		.subpass = _subpass,
+		// Left null so the same buffer runs against every swapchain framebuffer
+		.framebuffer = VK_NULL_HANDLE,
+	};
+	VkCommandBufferBeginInfo beginInfo = {
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+		.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT,
+		.pInheritanceInfo = &inheritance,
+	};
+	CHK_ERR(vkBeginCommandBuffer(segment.buf, &beginInfo));
+
+	VkViewport viewport = {
+		.width = (float)_extent.width,
+		.height = (float)_extent.height,
+		.minDepth = 0.0f,
+		.maxDepth = 1.0f,
+	};
+	VkRect2D scissor = {
+		.extent = _extent,
+	};
+	vkCmdSetViewport(segment.buf, 0, 1, &viewport);
+	vkCmdSetScissor(segment.buf, 0, 1, &scissor);
+
+	CommandEncoder encoder(segment.buf);
+	segment.record(encoder);
+	segment.stats = encoder.stats();
+	CHK_ERR(vkEndCommandBuffer(segment.buf));
+	segment.dirty = false;
+	_recorded++;
+}
+
+void StaticCommands::execute(const VkCtx& ctx, VkCommandBuffer primary)
+{
+	if (_segments.empty()) {
+		return;
+	}
+	_execute.clear();
+	_stats = {};
+	for (Segment& segment : _segments) {
+		if (segment.dirty) {
+			record(ctx, segment);
+		}
+		_execute.push_back(segment.buf);
+		_stats.pipelines += segment.stats.pipelines;
+		_stats.descriptorSets += segment.stats.descriptorSets;
+		_stats.vertexBuffers += segment.stats.vertexBuffers;
+		_stats.indexBuffers += segment.stats.indexBuffers;
+		_stats.draws += segment.stats.draws;
+		_stats.redundant += segment.stats.redundant;
+	}
+	vkCmdExecuteCommands(primary, (uint32_t)_execute.size(), _execute.data());
+}
\ No newline at end of file
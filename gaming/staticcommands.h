@@ -0,0 +1,65 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "vkctx.h"
+#include "commandencoder.h"
+
+// Static scene segments recorded once into secondary command buffers and replayed every frame with vkCmdExecuteCommands
+// A segment is only re-recorded when invalidated or when the render target changes
+// Secondaries come from a pool of their own so the per frame vkResetCommandPool does not touch them, and are
+// recorded with SIMULTANEOUS_USE because every frame in flight executes the same buffer
+class StaticCommands {
+public:
+	// Called with viewport and scissor already set for the whole target, secondaries do not inherit dynamic state
+	typedef std::function<void(CommandEncoder&)> RecordFn;
+private:
+	struct Segment {
+		RecordFn record;
+		VkCommandBuffer buf;
+		BindStats stats;
+		bool dirty;
+	};
+	// Replaced buffers may still be pending in frames in flight, they are reused once all of those have been waited on
+	struct Retired {
+		VkCommandBuffer buf;
+		size_t framesLeft;
+	};
+
+	VkCommandPool _pool;
+	size_t _framesInFlight;
+	std::vector<Segment> _segments;
+	std::vector<Retired> _retired;
+	std::vector<VkCommandBuffer> _free;
+	std::vector<VkCommandBuffer> _execute;
+	VkRenderPass _renderPass;
+	uint32_t _subpass;
+	VkExtent2D _extent;
+	uint32_t _recorded;
+	BindStats _stats;
+
+	VkCommandBuffer acquire(const VkCtx& ctx);
+	void record(const VkCtx& ctx, Segment& segment);
+public:
+	StaticCommands(const VkCtx& ctx, size_t framesInFlight);
+	void destroy(const VkCtx& ctx);
+
+	uint32_t addSegment(RecordFn record);
+	void invalidate(uint32_t segment);
+	void invalidateAll();
+
+	// Render pass, subpass and extent the segments draw into, a change invalidates every segment
+	void setTarget(VkRenderPass renderPass, uint32_t subpass, VkExtent2D extent);
+	// Call once per frame after waiting on the frame's fence
+	void beginFrame();
+	// Re-records dirty segments and executes all of them, the primary must be inside the target render pass
+	// begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+	void execute(const VkCtx& ctx, VkCommandBuffer primary);
+
+	// Segments re-recorded during the current frame, 0 in the steady state
+	uint32_t recordedThisFrame() const { return _recorded; }
+	// Binds replayed by the last execute, summed over the last recording of every segment
+	const BindStats& stats() const { return _stats; }
+	size_t segmentCount() const { return _segments.size(); }
+};
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include "vertexformat.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+
+uint16_t packHalf(float v)
+{
+	uint32_t bits = std::bit_cast<uint32_t>(v);
+	uint32_t sign = (bits >> 16) & 0x8000;
+	int32_t exponent = (int32_t)((bits >> 23) & 0xff) - 127 + 15;
+	uint32_t mantissa = bits & 0x7fffff;
+
+	if (((bits >> 23) & 0xff) == 0xff) {
+		// Inf or NaN
+		return (uint16_t)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+	}
+	if (exponent >= 31) {
+		return (uint16_t)(sign | 0x7c00);
+	}
+	if (exponent <= 0) {
+		if (exponent < -10) {
+			return (uint16_t)sign;
+		}
+		// Denormal, shift in the implicit bit and round to nearest
+		mantissa |= 0x800000;
+		uint32_t shift = (uint32_t)(14 - exponent);
+		uint32_t half = mantissa >> shift;
+		if ((mantissa >> (shift - 1)) & 1) {
+			half++;
+		}
+		return (uint16_t)(sign | half);
+	}
+	uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+	// Round to nearest, a carry into the exponent is still the correct result
+	if (mantissa & 0x1000) {
+		half++;
+	}
+	return (uint16_t)half;
+}
+
+int16_t packSnorm16(float v)
+{
+	return (int16_t)std::round(std::clamp(v, -1.0f, 1.0f) * 32767.0f);
+}
+
+octnormal octEncode(const glm::vec3& n)
+{
+	// Project onto the octahedron then fold the lower hemisphere over the diagonals
+	float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+	float x = n.x / l1;
+	float y = n.y / l1;
+	if (n.z < 0.0f) {
+		float fx = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		float fy = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+		x = fx;
+		y = fy;
+	}
+	return { packSnorm16(x), packSnorm16(y) };
+}
+
+rgba8 packColor(const glm::vec3& color)
+{
+	auto unorm8 = [](float v) { return (uint8_t)std::round(std::clamp(v, 0.0f, 1.0f) * 255.0f); };
+	return { unorm8(color.r), unorm8(color.g), unorm8(color.b), 255 };
+}
+
+QuantizationBounds quantizationBounds(std::span<const DefaultVertex> vertices)
+{
+	if (vertices.empty()) {
+		return { glm::vec3(0.0f), glm::vec3(1.0f) };
+	}
+	glm::vec3 lo = vertices[0].pos;
+	glm::vec3 hi = vertices[0].pos;
+	for (const DefaultVertex& v : vertices) {
+		lo = glm::min(lo, v.pos);
+		hi = glm::max(hi, v.pos);
+	}
+	// Flat meshes still need a non zero extent to divide by
+	glm::vec3 extent = glm::max((hi - lo) * 0.5f, glm::vec3(1e-6f));
+	return { (hi + lo) * 0.5f, extent };
+}
+
+glm::mat4 dequantizeTransform(const QuantizationBounds& bounds)
+{
+	glm::mat4 m(1.0f);
+	m[0][0] = bounds.extent.x;
+	m[1][1] = bounds.extent.y;
+	m[2][2] = bounds.extent.z;
+	m[3] = glm::vec4(bounds.center, 1.0f);
+	return m;
+}
+
+CompactVertex compactVertex(const DefaultVertex& v, const QuantizationBounds& bounds)
+{
+	glm::vec3 p = (v.pos - bounds.center) / bounds.extent;
+	return {
+		.pos = { packSnorm16(p.x), packSnorm16(p.y), packSnorm16(p.z), 32767 },
+		.normal = octEncode(v.normal),
+		.color = packColor(v.color),
+	};
+}
+
+HalfVertex halfVertex(const DefaultVertex& v)
+{
+	return {
+		.pos = { packHalf(v.pos.x), packHalf(v.pos.y), packHalf(v.pos.z), packHalf(1.0f) },
+		.normal = octEncode(v.normal),
+		.color = packColor(v.color),
+	};
+}
+
+std::vector<PositionVertex> positionStream(std::span<const DefaultVertex> vertices)
+{
+	std::vector<PositionVertex> positions;
+	positions.reserve(vertices.size());
+	for (const DefaultVertex& v : vertices) {
+		positions.push_back({ v.pos });
+	}
+	return positions;
+}
+
+SkinVertex skinVertex(const DefaultVertex& v, const glm::uvec4& joints, const glm::vec4& weights)
+{
+	SkinVertex s = { .vertex = v };
+	float total = weights.x + weights.y + weights.z + weights.w;
+	if (total <= 0.0f) {
+		// Unweighted vertices follow their first joint
+		s.joints[0] = (uint8_t)joints.x;
+		s.weights[0] = 255;
+		return s;
+	}
+	int sum = 0;
+	int largest = 0;
+	for (int i = 0; i < 4; i++) {
+		assert(joints[i] < 256);
+		s.joints[i] = (uint8_t)joints[i];
+		s.weights[i] = (uint8_t)std::lround(weights[i] / total * 255.0f);
+		sum += s.weights[i];
+		if (weights[i] > weights[largest]) {
+			largest = i;
+		}
+	}
+	// Rounding can miss 255 by a few, the largest influence absorbs it so the weights still sum to one
+	s.weights[largest] = (uint8_t)(s.weights[largest] + 255 - sum);
+	return s;
+}
\ No newline at end of file
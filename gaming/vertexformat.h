@@ -0,0 +1,171 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+#include "pch.h"
+#include "defaultvertex.h"
+
+// Storage types for quantized vertex attributes, the GPU expands them to floats during vertex fetch
+struct half4 { uint16_t x, y, z, w; };
+struct snorm16x4 { int16_t x, y, z, w; };
+// Octahedral encoded unit vector, see octEncode
+struct octnormal { int16_t x, y; };
+struct rgba8 { uint8_t r, g, b, a; };
+
+// Maps an attribute's storage type to the format the vertex fetch reads it as
+template<class T> struct AttributeFormat;
+template<> struct AttributeFormat<float> { static constexpr VkFormat value = VK_FORMAT_R32_SFLOAT; };
+template<> struct AttributeFormat<glm::vec2> { static constexpr VkFormat value = VK_FORMAT_R32G32_SFLOAT; };
+template<> struct AttributeFormat<glm::vec3> { static constexpr VkFormat value = VK_FORMAT_R32G32B32_SFLOAT; };
+template<> struct AttributeFormat<glm::vec4> { static constexpr VkFormat value = VK_FORMAT_R32G32B32A32_SFLOAT; };
+template<> struct AttributeFormat<half4> { static constexpr VkFormat value = VK_FORMAT_R16G16B16A16_SFLOAT; };
+template<> struct AttributeFormat<snorm16x4> { static constexpr VkFormat value = VK_FORMAT_R16G16B16A16_SNORM; };
+template<> struct AttributeFormat<octnormal> { static constexpr VkFormat value = VK_FORMAT_R16G16_SNORM; };
+template<> struct AttributeFormat<rgba8> { static constexpr VkFormat value = VK_FORMAT_R8G8B8A8_UNORM; };
+
+template<class T>
+constexpr VkVertexInputAttributeDescription vertexAttribute(uint32_t location, uint32_t offset) {
+	return {
+		.location = location,
+		.binding = 0,
+		.format = AttributeFormat<T>::value,
+		.offset = offset,
+	};
+}
+
+// Builds an attribute description, the format is deduced from the member's type
+#define VERTEX_ATTRIBUTE(Vertex, member, location) vertexAttribute<decltype(Vertex::member)>(location, offsetof(Vertex, member))
+
+// Specialised per vertex format with a static constexpr array named attributes
+template<class V> struct VertexLayout;
+
+// Vertex input state for a single interleaved binding, handed to DefaultShader
+struct VertexInput {
+	VkVertexInputBindingDescription binding;
+	std::span<const VkVertexInputAttributeDescription> attributes;
+};
+
+template<class V>
+constexpr VertexInput vertexInput() {
+	return {
+		.binding = {
+			.binding = 0,
+			.stride = sizeof(V),
+			.inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+		},
+		.attributes = VertexLayout<V>::attributes,
+	};
+}
+
+// Position only stream for depth only passes, 12 bytes per vertex instead of the full vertex (shaders/depth_prepass.vert)
+// Must come from the same full precision positions as the shaded pass so both compute identical depths
+struct PositionVertex {
+	glm::vec3 pos;
+};
+
+template<> struct VertexLayout<PositionVertex> {
+	static constexpr std::array attributes = {
+		VERTEX_ATTRIBUTE(PositionVertex, pos, 0),
+	};
+};
+
+// Reads only the leading position of a full vertex stream, for depth only passes over geometry that has no separate
+// PositionVertex copy, e.g. SkinningPass output which would otherwise have to be skinned twice
+template<class V>
+constexpr VertexInput positionOnlyInput() {
+	static_assert(offsetof(V, pos) == 0);
+	return {
+		.binding = {
+			.binding = 0,
+			.stride = sizeof(V),
+			.inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+		},
+		.attributes = VertexLayout<PositionVertex>::attributes,
+	};
+}
+
+// No vertex buffers, the vertex shader generates its vertices from gl_VertexIndex
+constexpr VertexInput noVertexInput = {
+	.binding = {},
+	.attributes = {},
+};
+
+template<> struct VertexLayout<DefaultVertex> {
+	static constexpr std::array attributes = {
+		VERTEX_ATTRIBUTE(DefaultVertex, pos, 0),
+		VERTEX_ATTRIBUTE(DefaultVertex, normal, 1),
+		VERTEX_ATTRIBUTE(DefaultVertex, color, 2),
+	};
+};
+
+// 16 bytes, position normalised to the mesh bounds, see dequantizeTransform (shaders/compact.vert)
+struct CompactVertex {
+	snorm16x4 pos;
+	octnormal normal;
+	rgba8 color;
+};
+
+template<> struct VertexLayout<CompactVertex> {
+	static constexpr std::array attributes = {
+		VERTEX_ATTRIBUTE(CompactVertex, pos, 0),
+		VERTEX_ATTRIBUTE(CompactVertex, normal, 1),
+		VERTEX_ATTRIBUTE(CompactVertex, color, 2),
+	};
+};
+
+// 16 bytes, half precision object space position, no dequantization needed (shaders/compact.vert)
+struct HalfVertex {
+	half4 pos;
+	octnormal normal;
+	rgba8 color;
+};
+
+template<> struct VertexLayout<HalfVertex> {
+	static constexpr std::array attributes = {
+		VERTEX_ATTRIBUTE(HalfVertex, pos, 0),
+		VERTEX_ATTRIBUTE(HalfVertex, normal, 1),
+		VERTEX_ATTRIBUTE(HalfVertex, color, 2),
+	};
+};
+
+// Bind pose vertex of a skinned mesh, only read as a storage buffer by shaders/skinning.comp (std430, 44 byte stride)
+// Joints index the instance's slice of the joint palette, weights are unorm8 summing to 255, see skinVertex
+struct SkinVertex {
+	DefaultVertex vertex;
+	uint8_t joints[4];
+	uint8_t weights[4];
+};
+
+static_assert(sizeof(CompactVertex) == 16);
+static_assert(sizeof(HalfVertex) == 16);
+static_assert(sizeof(SkinVertex) == 44);
+
+uint16_t packHalf(float v);
+int16_t packSnorm16(float v);
+octnormal octEncode(const glm::vec3& n);
+rgba8 packColor(const glm::vec3& color);
+
+// Bounds used to normalise positions into snorm16, every vertex of a mesh must share one
+struct QuantizationBounds {
+	glm::vec3 center;
+	glm::vec3 extent;
+};
+
+QuantizationBounds quantizationBounds(std::span<const DefaultVertex> vertices);
+// Maps the [-1, 1] snorm positions back to object space, multiply into the model matrix
+glm::mat4 dequantizeTransform(const QuantizationBounds& bounds);
+
+CompactVertex compactVertex(const DefaultVertex& v, const QuantizationBounds& bounds);
+HalfVertex halfVertex(const DefaultVertex& v);
+std::vector<PositionVertex> positionStream(std::span<const DefaultVertex> vertices);
+// Weights are normalised before quantizing, unused influences should have a weight of 0
+SkinVertex skinVertex(const DefaultVertex& v, const glm::uvec4& joints, const glm::vec4& weights);
@@ -2,6 +2,7 @@
 
 #include "vkctx.h"
 #include "defaultvertex.h"
+#include "vertexformat.h"
 #include <vector>
 
 template<class T>
@@ -60,7 +61,24 @@ public:
 };
 
 typedef PackedBuffer<DefaultVertex> VertexBuffer;
+typedef PackedBuffer<CompactVertex> CompactVertexBuffer;
+typedef PackedBuffer<HalfVertex> HalfVertexBuffer;
 typedef PackedBuffer<uint32_t> IndexBuffer;
+typedef PackedBuffer<uint16_t> IndexBuffer16;
+
+// VkIndexType matching an index buffer's element type
+template<class T>
+struct IndexTypeOf;
+
+template<>
+struct IndexTypeOf<uint16_t> {
+    static constexpr VkIndexType value = VK_INDEX_TYPE_UINT16;
+};
+
+template<>
+struct IndexTypeOf<uint32_t> {
+    static constexpr VkIndexType value = VK_INDEX_TYPE_UINT32;
+};
 
 class DynamicUniformBuffer {
     const VkCtx& _ctx;
@@ -134,4 +152,183 @@ public:
     VkBuffer buffer() {
         return _uniform;
     }
+};
+
+// One slot per frame in flight, persistently mapped so a frame's data is written once with no map/unmap
+// Bound as a dynamic uniform buffer with the frame's slot as the offset
+template<class T>
+class FrameUniformBuffer {
+    const VkCtx& _ctx;
+    VkBuffer _uniform;
+    VmaAllocation _alloc;
+    VmaAllocationInfo _allocInfo;
+    size_t _frames;
+    static constexpr size_t alignment = 256;
+    static_assert(sizeof(T) <= alignment, "Frame uniform must fit in one aligned slot");
+public:
+    FrameUniformBuffer(const VkCtx& ctx, size_t frames) : _ctx(ctx), _frames(frames) {
+        VkBufferCreateInfo bufferInfo{};
+
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = frames * alignment;
+        bufferInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        VmaAllocationCreateInfo info{};
+        info.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        info.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+        CHK_ERR(vmaCreateBuffer(ctx.allocator(), &bufferInfo, &info, &_uniform, &_alloc, &_allocInfo));
+    }
+
+    FrameUniformBuffer(FrameUniformBuffer&& o) : _ctx(o._ctx) {
+        _alloc = o._alloc;
+        _allocInfo = o._allocInfo;
+        _frames = o._frames;
+        _uniform = o._uniform;
+
+        o._uniform = VK_NULL_HANDLE;
+        o._alloc = nullptr;
+    }
+
+    ~FrameUniformBuffer() {
+        destroy();
+    }
+
+    void destroy() {
+        vmaDestroyBuffer(_ctx.allocator(), _uniform, _alloc);
+        _uniform = VK_NULL_HANDLE;
+        _alloc = nullptr;
+    }
+
+    void write(size_t frame, const T& value) {
+        assert(frame < _frames);
+        memcpy((uint8_t*)_allocInfo.pMappedData + frame * alignment, &value, sizeof(T));
+    }
+
+    uint32_t offset(size_t frame) const {
+        return (uint32_t)(frame * alignment);
+    }
+
+    VkBuffer buffer() const {
+        return _uniform;
+    }
+};
+
+// Array of T per frame in flight in one persistently mapped storage buffer
+// Bound as a dynamic storage buffer with the frame's region as the offset
+template<class T>
+class FrameStorageBuffer {
+    const VkCtx& _ctx;
+    VkBuffer _storage;
+    VmaAllocation _alloc;
+    VmaAllocationInfo _allocInfo;
+    size_t _capacity;
+    size_t _frames;
+    size_t _stride;
+    static constexpr size_t alignment = 256;
+public:
+    FrameStorageBuffer(const VkCtx& ctx, size_t frames, size_t capacity, VkBufferUsageFlags extraUsage = 0)
+        : _ctx(ctx), _capacity(capacity), _frames(frames) {
+        _stride = (sizeof(T) * capacity + alignment - 1) / alignment * alignment;
+        VkBufferCreateInfo bufferInfo{};
+
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = frames * _stride;
+        bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | extraUsage;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        VmaAllocationCreateInfo info{};
+        info.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        info.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+        CHK_ERR(vmaCreateBuffer(ctx.allocator(), &bufferInfo, &info, &_storage, &_alloc, &_allocInfo));
+    }
+
+    FrameStorageBuffer(FrameStorageBuffer&& o) : _ctx(o._ctx) {
+        _alloc = o._alloc;
+        _allocInfo = o._allocInfo;
+        _capacity = o._capacity;
+        _frames = o._frames;
+        _stride = o._stride;
+        _storage = o._storage;
+
+        o._storage = VK_NULL_HANDLE;
+        o._alloc = nullptr;
+    }
+
+    ~FrameStorageBuffer() {
+        destroy();
+    }
+
+    void destroy() {
+        vmaDestroyBuffer(_ctx.allocator(), _storage, _alloc);
+        _storage = VK_NULL_HANDLE;
+        _alloc = nullptr;
+    }
+
+    T* data(size_t frame) {
+        assert(frame < _frames);
+        return reinterpret_cast<T*>((uint8_t*)_allocInfo.pMappedData + frame * _stride);
+    }
+
+    uint32_t offset(size_t frame) const {
+        return (uint32_t)(frame * _stride);
+    }
+
+    // Size of one frame's region, used as the descriptor range
+    VkDeviceSize range() const {
+        return _stride;
+    }
+
+    size_t capacity() const {
+        return _capacity;
+    }
+
+    VkBuffer buffer() const {
+        return _storage;
+    }
+};
+
+// Raw device local buffer written and read only by the GPU, e.g. compute outputs and indirect arguments
+class DeviceBuffer {
+    const VkCtx& _ctx;
+    VkBuffer _buffer;
+    VmaAllocation _alloc;
+    VkDeviceSize _size;
+public:
+    DeviceBuffer(const VkCtx& ctx, VkDeviceSize size, VkBufferUsageFlags usage) : _ctx(ctx), _size(size) {
+        VkBufferCreateInfo bufferInfo{};
+
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = size;
+        bufferInfo.usage = usage;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        VmaAllocationCreateInfo info{};
+        info.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+        CHK_ERR(vmaCreateBuffer(ctx.allocator(), &bufferInfo, &info, &_buffer, &_alloc, nullptr));
+    }
+
+    DeviceBuffer(DeviceBuffer&& o) : _ctx(o._ctx) {
+        _buffer = o._buffer;
+        _alloc = o._alloc;
+        _size = o._size;
+
+        o._buffer = VK_NULL_HANDLE;
+        o._alloc = nullptr;
+    }
+
+    ~DeviceBuffer() {
+        destroy();
+    }
+
+    void destroy() {
+        vmaDestroyBuffer(_ctx.allocator(), _buffer, _alloc);
+        _buffer = VK_NULL_HANDLE;
+        _alloc = nullptr;
+    }
+
+    VkDeviceSize size() const {
+        return _size;
+    }
+
+    VkBuffer buffer() const {
+        return _buffer;
+    }
 };
\ No newline at end of file
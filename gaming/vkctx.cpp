@@ -82,7 +82,9 @@ VkCtx::VkCtx()
 	_device(VK_NULL_HANDLE),
 	_graphicsQueue(VK_NULL_HANDLE),
 	_graphicsQueueIndex(0),
-	_allocator(VMA_NULL)
+	_allocator(VMA_NULL),
+	_features11({ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES }),
+	_features12({ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES })
 {
 }
 
@@ -166,6 +168,15 @@ void VkCtx::initVulkan(SDL_Window* window)
 
 	printDeviceProps(currentProps, _physicalDevice);
 
+	// Several compute shaders use subgroup operations, the classes running them check for them with supportsSubgroupOps
+	VkPhysicalDeviceSubgroupProperties subgroupProps = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES };
+	VkPhysicalDeviceProperties2 props2 = {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+		.pNext = &subgroupProps,
+	};
+	vkGetPhysicalDeviceProperties2(_physicalDevice, &props2);
+	_computeSubgroupOps = (subgroupProps.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) ? subgroupProps.supportedOperations : 0;
+
 	uint32_t nQueues = 0;
 	vkGetPhysicalDeviceQueueFamilyProperties(currentDev, &nQueues, nullptr);
 	std::vector<VkQueueFamilyProperties> queueProps(nQueues);
@@ -201,8 +212,52 @@ void VkCtx::initVulkan(SDL_Window* window)
 		VK_KHR_SWAPCHAIN_EXTENSION_NAME
 	};
 
+	// Descriptor indexing is needed for the bindless resource table
+	// Everything used is core in 1.2, multiview (1.1) and indirect count draws for GPU driven rendering (GpuScene,
+	// ClusterScene) are enabled when available
+	VkPhysicalDeviceVulkan12Features supported12 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+	VkPhysicalDeviceVulkan11Features supported11 = {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES,
+		.pNext = &supported12,
+	};
+	VkPhysicalDeviceFeatures2 supported = {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+		.pNext = &supported11,
+	};
+	vkGetPhysicalDeviceFeatures2(_physicalDevice, &supported);
+	if (!supported12.descriptorIndexing || !supported12.runtimeDescriptorArray || !supported12.descriptorBindingPartiallyBound
+		|| !supported12.descriptorBindingStorageBufferUpdateAfterBind || !supported12.descriptorBindingSampledImageUpdateAfterBind
+		|| !supported12.descriptorBindingUpdateUnusedWhilePending || !supported12.shaderSampledImageArrayNonUniformIndexing) {
+		throw std::runtime_error("Device does not support descriptor indexing");
+	}
+	_features12 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+	_features12.descriptorIndexing = VK_TRUE;
+	_features12.runtimeDescriptorArray = VK_TRUE;
+	_features12.descriptorBindingPartiallyBound = VK_TRUE;
+	_features12.descriptorBindingVariableDescriptorCount = supported12.descriptorBindingVariableDescriptorCount;
+	_features12.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+	_features12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+	_features12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+	_features12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+	_features12.shaderStorageBufferArrayNonUniformIndexing = supported12.shaderStorageBufferArrayNonUniformIndexing;
+	_features12.drawIndirectCount = supported12.drawIndirectCount;
+
+	_features11 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES };
+	_features11.pNext = &_features12;
+	_features11.multiview = supported11.multiview;
+
+	VkPhysicalDeviceFeatures2 enabled = {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+		.pNext = &_features11,
+	};
+	_features = {};
+	_features.multiDrawIndirect = supported.features.multiDrawIndirect;
+	_features.drawIndirectFirstInstance = supported.features.drawIndirectFirstInstance;
+	enabled.features = _features;
+
 	VkDeviceCreateInfo devInfo = {
 		.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+		.pNext = &enabled,
 		.queueCreateInfoCount = 1,
 		.pQueueCreateInfos = &queueInfo,
 		.enabledLayerCount = 0,
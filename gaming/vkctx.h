@@ -15,6 +15,10 @@ private:
 	VkQueue _graphicsQueue;
 	uint32_t _graphicsQueueIndex;
 	VmaAllocator _allocator;
+	VkPhysicalDeviceFeatures _features;
+	VkPhysicalDeviceVulkan11Features _features11;
+	VkPhysicalDeviceVulkan12Features _features12;
+	VkSubgroupFeatureFlags _computeSubgroupOps;
 #ifndef NDEBUG
 	VkDebugUtilsMessengerEXT _debugMessenger;
 
@@ -29,6 +33,16 @@ public:
 	uint32_t graphicsQueueIndex() const { return _graphicsQueueIndex; };
 	VkQueue graphicsQueue() const { return _graphicsQueue; };
 	VmaAllocator allocator() const { return _allocator; }
+	// Core features that were actually enabled on the device, the indirect draw features are optional
+	const VkPhysicalDeviceFeatures& features() const { return _features; }
+	// Indirect count draws with several draws and a firstInstance each, needed by GpuScene and ClusterScene
+	bool supportsIndirectCount() const { return _features12.drawIndirectCount && _features.multiDrawIndirect && _features.drawIndirectFirstInstance; }
+	// Whether compute shaders support every subgroup operation in ops (VK_SUBGROUP_FEATURE_*_BIT)
+	bool supportsSubgroupOps(VkSubgroupFeatureFlags ops) const { return (_computeSubgroupOps & ops) == ops; }
+	// Vulkan 1.1 features that were actually enabled on the device, multiview is optional (see MultiviewTarget)
+	const VkPhysicalDeviceVulkan11Features& features11() const { return _features11; }
+	// Vulkan 1.2 features that were actually enabled on the device
+	const VkPhysicalDeviceVulkan12Features& features12() const { return _features12; }
 };
 
 uint32_t findMemoryType(const VkCtx& ctx, uint32_t typeFilter, VkMemoryPropertyFlags properties);
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "vkimage.h"
+
+void createDeviceImage(const VkCtx& ctx, VkFormat format, VkExtent2D extent, uint32_t layers, VkImageViewType viewType,
+	VkImageUsageFlags usage, VkImageAspectFlags aspect, VkImage& image, VmaAllocation& alloc, VkImageView& view)
+{
+	VkImageCreateInfo imageInfo = {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+		.imageType = VK_IMAGE_TYPE_2D,
+		.format = format,
+		.extent = { .width = extent.width, .height = extent.height, .depth = 1, },
+		.mipLevels = 1,
+		.arrayLayers = layers,
+		.samples = VK_SAMPLE_COUNT_1_BIT,
+		.tiling = VK_IMAGE_TILING_OPTIMAL,
+		.usage = usage,
+		.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+	};
+	VmaAllocationCreateInfo allocInfo{};
+	allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+	CHK_ERR(vmaCreateImage(ctx.allocator(), &imageInfo, &allocInfo, &image, &alloc, nullptr));
+
+	VkImageViewCreateInfo viewInfo = {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+		.image = image,
+		.viewType = viewType,
+		.format = format,
+		.components = { }, // VK_COMPONENT_SWIZZLE_IDENTITY == 0 therefore zero struct
+		.subresourceRange = {
+			.aspectMask = aspect,
+			.baseMipLevel = 0,
+			.levelCount = 1,
+			.baseArrayLayer = 0,
+			.layerCount = layers,
+		}
+	};
+	CHK_ERR(vkCreateImageView(ctx.device(), &viewInfo, nullptr, &view));
+}
\ No newline at end of file
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "vkctx.h"
+
+// Device local image with a single mip and a view of every layer, viewType is 2D or 2D_ARRAY
+void createDeviceImage(const VkCtx& ctx, VkFormat format, VkExtent2D extent, uint32_t layers, VkImageViewType viewType,
+	VkImageUsageFlags usage, VkImageAspectFlags aspect, VkImage& image, VmaAllocation& alloc, VkImageView& view);
\ No newline at end of file
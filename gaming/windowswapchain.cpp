@@ -35,6 +35,195 @@ VkPresentModeKHR getPresentMode() {
 	return isVsync ? VK_PRESENT_MODE_FIFO_KHR : VK_PRESENT_MODE_MAILBOX_KHR;
 }
 
+// How one attachment is used by a render pass
+struct AttachmentUse {
+    VkAttachmentLoadOp loadOp;
+    VkAttachmentStoreOp storeOp;
+    VkImageLayout initialLayout;
+    VkImageLayout finalLayout;
+};
+
+// Single subpass pass over the swapchain color image and, unless antialiasing, the shared depth image
+static VkRenderPass createRenderPass(const VkCtx& vkctx, VkFormat colorFormat, VkFormat depthFormat, AttachmentUse color, AttachmentUse depth, const VkSubpassDependency* dependencies, uint32_t dependencyCount) {
+    VkAttachmentDescription colorDesc = {
+        .format = colorFormat,
+        .samples = VK_SAMPLE_COUNT_1_BIT, // Cannot multisample in window framebuffer, composited to single sample
+        .loadOp = color.loadOp,
+        .storeOp = color.storeOp,
+        .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+        .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        .initialLayout = color.initialLayout,
+        .finalLayout = color.finalLayout,
+    };
+
+    VkAttachmentReference colorRef = {
+        .attachment = 0,
+        .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+    };
+
+    VkAttachmentDescription depthDesc = {
+        .format = depthFormat,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .loadOp = depth.loadOp,
+        .storeOp = depth.storeOp,
+        .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+        .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        .initialLayout = depth.initialLayout,
+        .finalLayout = depth.finalLayout,
+    };
+
+    VkAttachmentReference depthRef = {
+        .attachment = 1,
+        .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+    };
+
+    VkSubpassDescription subpassDesc = {
+        .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+        .colorAttachmentCount = 1,
+        .pColorAttachments = &colorRef,
+    };
+
+    if (!isAA) {
+        subpassDesc.pDepthStencilAttachment = &depthRef;
+    }
+
+    VkAttachmentDescription descs[] = {
+        colorDesc,
+        depthDesc,
+    };
+
+    VkRenderPassCreateInfo renderpassInfo = {
+        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+        .attachmentCount = isAA?1:2,
+        .pAttachments = descs,
+        .subpassCount = 1,
+        .pSubpasses = &subpassDesc,
+        .dependencyCount = dependencyCount,
+        .pDependencies = dependencies,
+    };
+
+    VkRenderPass renderPass;
+    CHK_ERR(vkCreateRenderPass(vkctx.device(), &renderpassInfo, nullptr, &renderPass));
+    return renderPass;
+}
+
+// Deferred G-buffer formats, albedo and the normal packed as n * 0.5 + 0.5 (shaders/gbuffer.frag)
+static constexpr VkFormat gbufferFormats[] = { VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_A2B10G10R10_UNORM_PACK32 };
+
+// Two subpass deferred pass over the swapchain color (0), G-buffer depth (1), albedo (2) and normal (3)
+// The G-buffer is cleared on load and never stored, the lighting subpass reads it in place as input attachments
+static VkRenderPass createDeferredPass(const VkCtx& vkctx, VkFormat colorFormat, VkFormat depthFormat) {
+    VkAttachmentDescription descs[4];
+    descs[0] = {
+        .format = colorFormat,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+        .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+        .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+    };
+    VkFormat formats[] = { depthFormat, gbufferFormats[0], gbufferFormats[1] };
+    for (int i = 1; i < 4; i++) {
+        descs[i] = {
+            .format = formats[i - 1],
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+            .storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .finalLayout = i == 1 ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        };
+    }
+
+    VkAttachmentReference gbufferRefs[] = {
+        { .attachment = 2, .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL },
+        { .attachment = 3, .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL },
+    };
+    VkAttachmentReference depthRef = { .attachment = 1, .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+    VkAttachmentReference inputRefs[] = {
+        { .attachment = 2, .layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL },
+        { .attachment = 3, .layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL },
+        { .attachment = 1, .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL },
+    };
+    VkAttachmentReference colorRef = { .attachment = 0, .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+
+    VkSubpassDescription subpasses[] = {
+        {
+            .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+            .colorAttachmentCount = 2,
+            .pColorAttachments = gbufferRefs,
+            .pDepthStencilAttachment = &depthRef,
+        },
+        {
+            .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+            .inputAttachmentCount = 3,
+            .pInputAttachments = inputRefs,
+            .colorAttachmentCount = 1,
+            .pColorAttachments = &colorRef,
+        },
+    };
+
+    VkSubpassDependency deps[] = {
+        // The previous frame's lighting subpass may still be reading the shared G-buffer
+        {
+            .srcSubpass = VK_SUBPASS_EXTERNAL,
+            .dstSubpass = 0,
+            .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+            .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+        },
+        // Swapchain image acquire, first used by the lighting subpass
+        {
+            .srcSubpass = VK_SUBPASS_EXTERNAL,
+            .dstSubpass = 1,
+            .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            .srcAccessMask = 0,
+            .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+        },
+        // Each pixel only reads the G-buffer at its own position, so tilers keep it on chip
+        {
+            .srcSubpass = 0,
+            .dstSubpass = 1,
+            .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT,
+            .dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT,
+        },
+    };
+
+    VkRenderPassCreateInfo renderpassInfo = {
+        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+        .attachmentCount = 4,
+        .pAttachments = descs,
+        .subpassCount = 2,
+        .pSubpasses = subpasses,
+        .dependencyCount = 3,
+        .pDependencies = deps,
+    };
+
+    VkRenderPass renderPass;
+    CHK_ERR(vkCreateRenderPass(vkctx.device(), &renderpassInfo, nullptr, &renderPass));
+    return renderPass;
+}
+
+// Lazily allocated memory when the device has it (tilers), so transient attachments may never be backed at all
+static uint32_t transientMemoryType(const VkCtx& vkctx, uint32_t typeFilter) {
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(vkctx.physicalDevice(), &memProperties);
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+        if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)) {
+            return i;
+        }
+    }
+    return findMemoryType(vkctx, typeFilter, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+}
+
 VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats) {
     for (const auto& availableFormat : availableFormats) {
         if (availableFormat.format == VK_FORMAT_B8G8R8A8_SRGB && availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
@@ -51,6 +240,10 @@ WindowSwapchain::WindowSwapchain() : _surface(VK_NULL_HANDLE),
     _depthImage(VK_NULL_HANDLE),
    _depthView(VK_NULL_HANDLE),
     _renderPass(VK_NULL_HANDLE),
+    _firstPhasePass(VK_NULL_HANDLE),
+    _secondPhasePass(VK_NULL_HANDLE),
+    _overlayPass(VK_NULL_HANDLE),
+    _deferredPass(VK_NULL_HANDLE),
     _presentMode(VK_PRESENT_MODE_MAILBOX_KHR),
     _surfaceFormat({}),
     _extent({0, 0}),
@@ -72,6 +265,14 @@ void WindowSwapchain::destroy(const VkCtx& vkctx)
     for (VkFramebuffer buffer : _frameBuffers) {
         vkDestroyFramebuffer(vkctx.device(), buffer, nullptr);
     }
+    for (VkFramebuffer buffer : _deferredFramebuffers) {
+        vkDestroyFramebuffer(vkctx.device(), buffer, nullptr);
+    }
+    for (size_t i = 0; i < _gbufferImages.size(); i++) {
+        vkDestroyImageView(vkctx.device(), _gbufferViews[i], nullptr);
+        vkDestroyImage(vkctx.device(), _gbufferImages[i], nullptr);
+        vkFreeMemory(vkctx.device(), _gbufferAllocs[i], nullptr);
+    }
     vkDestroyImageView(vkctx.device(), _depthView, nullptr);
     for (VkImageView view : _imageViews) {
         vkDestroyImageView(vkctx.device(), view, nullptr);
@@ -79,6 +280,10 @@ void WindowSwapchain::destroy(const VkCtx& vkctx)
     vkDestroyImage(vkctx.device(), _depthImage, nullptr);
     vkFreeMemory(vkctx.device(), _depthAlloc, nullptr);
     vkDestroyRenderPass(vkctx.device(), _renderPass, nullptr);
+    vkDestroyRenderPass(vkctx.device(), _firstPhasePass, nullptr);
+    vkDestroyRenderPass(vkctx.device(), _secondPhasePass, nullptr);
+    vkDestroyRenderPass(vkctx.device(), _overlayPass, nullptr);
+    vkDestroyRenderPass(vkctx.device(), _deferredPass, nullptr);
     vkDestroySwapchainKHR(vkctx.device(), _swapchain, nullptr);
 	vkDestroySurfaceKHR(vkctx.instance(), _surface, nullptr);
 }
@@ -118,7 +323,7 @@ void WindowSwapchain::initSwapchain(SDL_Window* window, const VkCtx& vkctx)
         .imageColorSpace = _surfaceFormat.colorSpace,
         .imageExtent = _extent,
         .imageArrayLayers = 1,
-        .imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+        .imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, // Transfer for multiview compositing
         .imageSharingMode = VK_SHARING_MODE_EXCLUSIVE,
         .queueFamilyIndexCount = 1,
         .pQueueFamilyIndices = &queueIndex,
@@ -147,7 +352,7 @@ void WindowSwapchain::initSwapchain(SDL_Window* window, const VkCtx& vkctx)
             .arrayLayers = 1,
             .samples = VK_SAMPLE_COUNT_1_BIT,
             .tiling = VK_IMAGE_TILING_OPTIMAL,
-            .usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+            .usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
             .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
             .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
         };
@@ -181,38 +386,6 @@ void WindowSwapchain::initSwapchain(SDL_Window* window, const VkCtx& vkctx)
         CHK_ERR(vkCreateImageView(vkctx.device(), &depthViewInfo, nullptr, &_depthView));
     }
 
-    VkAttachmentDescription colorDesc = {
-        .format = _surfaceFormat.format,
-        .samples = VK_SAMPLE_COUNT_1_BIT, // Cannot multisample in window framebuffer, composited to single sample
-        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
-        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-        .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-        .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-        .finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-    };
-
-    VkAttachmentReference colorRef = {
-        .attachment = 0,
-        .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-    };
-
-    VkAttachmentDescription depthDesc = {
-        .format = depthFormat,
-        .samples = VK_SAMPLE_COUNT_1_BIT,
-        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
-        .storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-        .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-        .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-        .finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
-    };
-
-    VkAttachmentReference depthRef = {
-        .attachment = 1,
-        .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
-    };
-
     VkSubpassDependency subpassDep = {
         .srcSubpass = VK_SUBPASS_EXTERNAL,
         .dstSubpass = 0,
@@ -222,34 +395,113 @@ void WindowSwapchain::initSwapchain(SDL_Window* window, const VkCtx& vkctx)
         .dstAccessMask = isAA?VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT: VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
     };
 
-    VkSubpassDescription subpassDesc = {
-        .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
-        .colorAttachmentCount = 1,
-        .pColorAttachments = &colorRef,
-    };
+    _renderPass = createRenderPass(vkctx, _surfaceFormat.format, depthFormat,
+        { VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR },
+        { VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL },
+        &subpassDep, 1);
 
+    // Two phase occlusion culling splits the frame around the Hi-Z build, the first pass leaves depth readable by compute
+    // and the second continues on top of both attachments. Both are compatible with the same framebuffers
     if (!isAA) {
-        subpassDesc.pDepthStencilAttachment = &depthRef;
+        VkSubpassDependency firstPhaseDeps[] = {
+            subpassDep,
+            {
+                .srcSubpass = 0,
+                .dstSubpass = VK_SUBPASS_EXTERNAL,
+                .srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                .dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                .srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+            },
+        };
+        _firstPhasePass = createRenderPass(vkctx, _surfaceFormat.format, depthFormat,
+            { VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL },
+            { VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL },
+            firstPhaseDeps, 2);
+
+        VkSubpassDependency secondPhaseDep = {
+            .srcSubpass = VK_SUBPASS_EXTERNAL,
+            .dstSubpass = 0,
+            .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+            .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+        };
+        _secondPhasePass = createRenderPass(vkctx, _surfaceFormat.format, depthFormat,
+            { VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_STORE_OP_STORE, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR },
+            { VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_STORE_OP_DONT_CARE, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL },
+            &secondPhaseDep, 1);
     }
 
-    VkAttachmentDescription descs[] = {
-        colorDesc,
-        depthDesc,
-    };
-
-    VkRenderPassCreateInfo renderpassInfo = {
-        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
-        .attachmentCount = isAA?1:2,
-        .pAttachments = descs,
-        .subpassCount = 1,
-        .pSubpasses = &subpassDesc,
-        .dependencyCount = 1,
-        .pDependencies = &subpassDep,
+    // Views of a MultiviewTarget are blitted into the swapchain image, UI is then drawn on top
+    VkSubpassDependency overlayDep = {
+        .srcSubpass = VK_SUBPASS_EXTERNAL,
+        .dstSubpass = 0,
+        .srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT,
+        .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = isAA?VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT: VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
     };
+    _overlayPass = createRenderPass(vkctx, _surfaceFormat.format, depthFormat,
+        { VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_STORE_OP_STORE, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR },
+        { VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL },
+        &overlayDep, 1);
+    if (!isAA) {
+        _deferredPass = createDeferredPass(vkctx, _surfaceFormat.format, depthFormat);
+
+        VkFormat formats[] = { gbufferFormats[0], gbufferFormats[1], depthFormat };
+        _gbufferAllocs.resize(3);
+        _gbufferImages.resize(3);
+        _gbufferViews.resize(3);
+        for (int i = 0; i < 3; i++) {
+            bool depth = formats[i] == depthFormat;
+            VkImageCreateInfo imageInfo = {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                .imageType = VK_IMAGE_TYPE_2D,
+                .format = formats[i],
+                .extent = {.width = _extent.width, .height = _extent.height, .depth = 1,},
+                .mipLevels = 1,
+                .arrayLayers = 1,
+                .samples = VK_SAMPLE_COUNT_1_BIT,
+                .tiling = VK_IMAGE_TILING_OPTIMAL,
+                .usage = (depth ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT)
+                    | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
+                .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            };
+            CHK_ERR(vkCreateImage(vkctx.device(), &imageInfo, nullptr, &_gbufferImages[i]));
+
+            VkMemoryRequirements reqs{};
+            vkGetImageMemoryRequirements(vkctx.device(), _gbufferImages[i], &reqs);
+            VkMemoryAllocateInfo memInfo = {
+                .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+                .allocationSize = reqs.size,
+                .memoryTypeIndex = transientMemoryType(vkctx, reqs.memoryTypeBits),
+            };
+            CHK_ERR(vkAllocateMemory(vkctx.device(), &memInfo, nullptr, &_gbufferAllocs[i]));
+            vkBindImageMemory(vkctx.device(), _gbufferImages[i], _gbufferAllocs[i], 0);
+
+            VkImageViewCreateInfo viewInfo = {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                .image = _gbufferImages[i],
+                .viewType = VK_IMAGE_VIEW_TYPE_2D,
+                .format = formats[i],
+                .components = { }, // VK_COMPONENT_SWIZZLE_IDENTITY == 0 therefore zero struct
+                .subresourceRange = {
+                    .aspectMask = depth ? (VkImageAspectFlags)VK_IMAGE_ASPECT_DEPTH_BIT : (VkImageAspectFlags)VK_IMAGE_ASPECT_COLOR_BIT,
+                    .baseMipLevel = 0,
+                    .levelCount = 1,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+                }
+            };
+            CHK_ERR(vkCreateImageView(vkctx.device(), &viewInfo, nullptr, &_gbufferViews[i]));
+        }
+    }
 
-    CHK_ERR(vkCreateRenderPass(vkctx.device(), &renderpassInfo, nullptr, &_renderPass));
     _imageViews.resize(size);
     _frameBuffers.resize(size);
+    _deferredFramebuffers.resize(isAA ? 0 : size);
     _commandPools.resize(size);
     _commandBuffers.resize(size);
     _imageAcquiredSemaphores.resize(size);
@@ -283,6 +535,14 @@ void WindowSwapchain::initSwapchain(SDL_Window* window, const VkCtx& vkctx)
         };
         CHK_ERR(vkCreateFramebuffer(vkctx.device(), &framebufferInfo, nullptr, &_frameBuffers[i]));
 
+        if (!isAA) {
+            VkImageView deferredViews[] = { _imageViews[i], _gbufferViews[2], _gbufferViews[0], _gbufferViews[1] };
+            framebufferInfo.renderPass = _deferredPass;
+            framebufferInfo.attachmentCount = 4;
+            framebufferInfo.pAttachments = deferredViews;
+            CHK_ERR(vkCreateFramebuffer(vkctx.device(), &framebufferInfo, nullptr, &_deferredFramebuffers[i]));
+        }
+
         {
             VkCommandPoolCreateInfo info = {
                 .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
@@ -15,15 +15,24 @@ private:
 	VkDeviceMemory _depthAlloc;
 	VkImage _depthImage;
 	VkImageView _depthView;
+	// Transient G-buffer of the deferred pass, never leaves tile memory on tilers
+	std::vector<VkDeviceMemory> _gbufferAllocs;
+	std::vector<VkImage> _gbufferImages;
+	std::vector<VkImageView> _gbufferViews;
 	std::vector<VkImage> _images;
 	std::vector<VkImageView> _imageViews;
 	std::vector<VkFramebuffer> _frameBuffers;
+	std::vector<VkFramebuffer> _deferredFramebuffers;
 	std::vector<VkCommandPool> _commandPools;
 	std::vector<VkCommandBuffer> _commandBuffers;
 	std::vector<VkSemaphore> _imageAcquiredSemaphores;
 	std::vector<VkSemaphore> _imageRenderedSemaphores;
 	std::vector<VkFence> _fences;
 	VkRenderPass _renderPass;
+	VkRenderPass _firstPhasePass;
+	VkRenderPass _secondPhasePass;
+	VkRenderPass _overlayPass;
+	VkRenderPass _deferredPass;
 	VkPresentModeKHR _presentMode;
 	VkSurfaceFormatKHR _surfaceFormat;
 	VkExtent2D _extent;
@@ -34,6 +43,22 @@ public:
 	void initSwapchain(SDL_Window* window, const VkCtx& vkctx);
 	VkSwapchainKHR swapchain() const { return _swapchain; }
 	VkRenderPass renderPass() const { return _renderPass; }
+	// Render passes for two phase occlusion culling, the first leaves depth in SHADER_READ_ONLY_OPTIMAL for the Hi-Z build
+	VkRenderPass firstPhasePass() const { return _firstPhasePass; }
+	VkRenderPass secondPhasePass() const { return _secondPhasePass; }
+	// Loads a color image composited with transfers (MultiviewTarget::composite) to draw UI on top and present it
+	VkRenderPass overlayPass() const { return _overlayPass; }
+	VkImage image(size_t i) const { return _images[i]; }
+	// Deferred shading in one pass, subpass 0 writes the G-buffer (albedo, normal and depth) and subpass 1 reads it
+	// as input attachments and writes the swapchain image, see DeferredRenderer
+	VkRenderPass deferredPass() const { return _deferredPass; }
+	VkFramebuffer deferredFramebuffer(size_t i) const { return _deferredFramebuffers[i]; }
+	// Albedo, normal and depth views for the lighting subpass's input attachments
+	VkImageView gbufferView(size_t i) const { return _gbufferViews[i]; }
+	VkFormat colorFormat() const { return _surfaceFormat.format; }
+	VkImage depthImage() const { return _depthImage; }
+	VkImageView depthView() const { return _depthView; }
+	VkExtent2D extent() const { return _extent; }
 	VkCommandBuffer commandBuffer(size_t i) const { return _commandBuffers[i]; }
 	VkCommandPool commandPool(size_t i) const { return _commandPools[i]; }
 	VkFramebuffer framebuffer(size_t i) const { return _frameBuffers[i]; }
@@ -41,4 +66,5 @@ public:
 	VkSemaphore imageRenderedSemaphore(size_t i) const { return _imageRenderedSemaphores[i]; }
 	VkFence fence(size_t i) const { return _fences[i]; }
 	size_t minImages() const { return _minImageCount; }
+	size_t imageCount() const { return _images.size(); }
 };
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include "meshlets.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+static Meshlet makeMeshlet(const MeshData& mesh, uint32_t firstIndex, uint32_t indexCount)
+{
+	// Center of the bounding box, radius to the farthest vertex
+	glm::vec3 lo(INFINITY), hi(-INFINITY);
+	for (uint32_t i = firstIndex; i < firstIndex + indexCount; i++) {
+		lo = glm::min(lo, mesh.vertices[mesh.indices[i]].pos);
+		hi = glm::max(hi, mesh.vertices[mesh.indices[i]].pos);
+	}
+	glm::vec3 center = (lo + hi) * 0.5f;
+	float radius = 0.0f;
+	for (uint32_t i = firstIndex; i < firstIndex + indexCount; i++) {
+		radius = std::max(radius, glm::length(mesh.vertices[mesh.indices[i]].pos - center));
+	}
+
+	std::vector<glm::vec3> normals;
+	glm::vec3 axis(0.0f);
+	for (uint32_t i = firstIndex; i < firstIndex + indexCount; i += 3) {
+		glm::vec3 a = mesh.vertices[mesh.indices[i]].pos;
+		glm::vec3 b = mesh.vertices[mesh.indices[i + 1]].pos;
+		glm::vec3 c = mesh.vertices[mesh.indices[i + 2]].pos;
+		glm::vec3 n = glm::cross(b - a, c - a);
+		float length = glm::length(n);
+		if (length > 0.0f) {
+			normals.push_back(n / length);
+			axis += n / length;
+		}
+	}
+
+	float cutoff = 1.0f;
+	float axisLength = glm::length(axis);
+	if (axisLength > 0.0f) {
+		axis /= axisLength;
+		float minDot = 1.0f;
+		for (const glm::vec3& n : normals) {
+			minDot = std::min(minDot, glm::dot(n, axis));
+		}
+		if (minDot > 0.0f) {
+			cutoff = std::sqrt(1.0f - minDot * minDot);
+		}
+	}
+
+	return {
+		.sphere = glm::vec4(center, radius),
+		.cone = glm::vec4(axis, cutoff),
+		.firstIndex = firstIndex,
+		.indexCount = indexCount,
+		.pad0 = 0,
+		.pad1 = 0,
+	};
+}
+
+void buildMeshlets(MeshData& mesh)
+{
+	mesh.meshlets.clear();
+	// Small meshlets keep the list of vertices in the current one short enough to search linearly
+	std::vector<uint32_t> vertices;
+	uint32_t first = 0;
+	for (uint32_t t = 0; t + 2 < (uint32_t)mesh.indices.size(); t += 3) {
+		uint32_t added = 0;
+		for (int k = 0; k < 3; k++) {
+			uint32_t v = mesh.indices[t + k];
+			added += std::find(vertices.begin(), vertices.end(), v) == vertices.end();
+		}
+		if (vertices.size() + added > meshletMaxVertices || (t - first) / 3 + 1 > meshletMaxTriangles) {
+			mesh.meshlets.push_back(makeMeshlet(mesh, first, t - first));
+			vertices.clear();
+			first = t;
+		}
+		for (int k = 0; k < 3; k++) {
+			uint32_t v = mesh.indices[t + k];
+			if (std::find(vertices.begin(), vertices.end(), v) == vertices.end()) {
+				vertices.push_back(v);
+			}
+		}
+	}
+	if (first < mesh.indices.size()) {
+		mesh.meshlets.push_back(makeMeshlet(mesh, first, (uint32_t)mesh.indices.size() - first));
+	}
+}
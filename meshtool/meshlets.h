@@ -0,0 +1,9 @@
+#pragma once
+
+#include "meshformat.h"
+
+// Splits the mesh's index sequence into meshlets in order, a new one starts when the next triangle would exceed
+// meshletMaxVertices or meshletMaxTriangles. Runs after the cache and overdraw passes so the clusters are spatially compact
+// and the index order is left untouched, every meshlet is a contiguous index range
+// Triangles are expected to wind counter-clockwise around their outward normal and not to be degenerate
+void buildMeshlets(MeshData& mesh);
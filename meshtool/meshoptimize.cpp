@@ -0,0 +1,259 @@
+#include "meshoptimize.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <string_view>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+CacheStats analyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, size_t cacheSize)
+{
+	// Timestamp of when each vertex entered the cache, it is resident while fewer than cacheSize misses happened since
+	std::vector<size_t> entered(vertexCount, SIZE_MAX);
+	size_t misses = 0;
+	for (uint32_t i : indices) {
+		if (entered[i] == SIZE_MAX || misses - entered[i] >= cacheSize) {
+			entered[i] = misses++;
+		}
+	}
+	size_t triangles = indices.size() / 3;
+	return {
+		.acmr = triangles ? (float)misses / (float)triangles : 0.0f,
+		.atvr = vertexCount ? (float)misses / (float)vertexCount : 0.0f,
+	};
+}
+
+size_t deduplicateVertices(MeshData& mesh)
+{
+	std::unordered_map<std::string_view, uint32_t> unique;
+	std::vector<uint32_t> remap(mesh.vertices.size());
+	std::vector<DefaultVertex> vertices;
+	vertices.reserve(mesh.vertices.size());
+	for (size_t i = 0; i < mesh.vertices.size(); i++) {
+		std::string_view bytes((const char*)&mesh.vertices[i], sizeof(DefaultVertex));
+		auto [it, added] = unique.try_emplace(bytes, (uint32_t)vertices.size());
+		if (added) {
+			vertices.push_back(mesh.vertices[i]);
+		}
+		remap[i] = it->second;
+	}
+	for (uint32_t& i : mesh.indices) {
+		i = remap[i];
+	}
+	size_t removed = mesh.vertices.size() - vertices.size();
+	mesh.vertices = std::move(vertices);
+	return removed;
+}
+
+// Forsyth's scoring, the LRU cache is larger than real hardware FIFOs on purpose
+static constexpr int forsythCacheSize = 32;
+static constexpr float cacheDecayPower = 1.5f;
+static constexpr float lastTriangleScore = 0.75f;
+static constexpr float valenceBoostScale = 2.0f;
+static constexpr float valenceBoostPower = 0.5f;
+
+static float vertexScore(int cachePosition, uint32_t remainingValence)
+{
+	if (remainingValence == 0) {
+		return -1.0f;
+	}
+	float score = 0.0f;
+	if (cachePosition >= 0) {
+		if (cachePosition < 3) {
+			// The triangle just drawn, reusing it right away is slightly penalised to avoid strips of slivers
+			score = lastTriangleScore;
+		} else {
+			score = std::pow(1.0f - (float)(cachePosition - 3) / (float)(forsythCacheSize - 3), cacheDecayPower);
+		}
+	}
+	// Vertices with few triangles left are finished first so they leave the working set
+	return score + valenceBoostScale * std::pow((float)remainingValence, -valenceBoostPower);
+}
+
+void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount)
+{
+	size_t triangles = indices.size() / 3;
+	if (triangles == 0) {
+		return;
+	}
+
+	// Triangles adjacent to each vertex, the live ones are kept at the front of each list
+	std::vector<uint32_t> valence(vertexCount, 0);
+	for (uint32_t i : indices) {
+		valence[i]++;
+	}
+	std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; v++) {
+		adjacencyOffset[v + 1] = adjacencyOffset[v] + valence[v];
+	}
+	std::vector<uint32_t> adjacency(indices.size());
+	std::vector<uint32_t> filled(vertexCount, 0);
+	for (size_t t = 0; t < triangles; t++) {
+		for (int k = 0; k < 3; k++) {
+			uint32_t v = indices[t * 3 + k];
+			adjacency[adjacencyOffset[v] + filled[v]++] = (uint32_t)t;
+		}
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> score(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++) {
+		score[v] = vertexScore(-1, valence[v]);
+	}
+	std::vector<bool> emitted(triangles, false);
+
+	std::vector<uint32_t> out;
+	out.reserve(indices.size());
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> nextCache;
+	size_t scan = 0;
+	int64_t best = -1;
+	for (size_t emittedCount = 0; emittedCount < triangles; emittedCount++) {
+		// Nothing scored in the cache, fall back to the next triangle in input order
+		if (best < 0) {
+			while (emitted[scan]) {
+				scan++;
+			}
+			best = (int64_t)scan;
+		}
+
+		uint32_t t = (uint32_t)best;
+		emitted[t] = true;
+		nextCache.clear();
+		for (int k = 0; k < 3; k++) {
+			uint32_t v = indices[t * 3 + k];
+			out.push_back(v);
+			nextCache.push_back(v);
+			// Remove the triangle from the vertex's live adjacency, degenerate triangles list a vertex twice
+			uint32_t* list = &adjacency[adjacencyOffset[v]];
+			uint32_t* end = list + valence[v];
+			uint32_t* found = std::find(list, end, t);
+			if (found != end) {
+				std::iter_swap(found, end - 1);
+				valence[v]--;
+			}
+		}
+		for (uint32_t v : cache) {
+			if (v != nextCache[0] && v != nextCache[1] && v != nextCache[2]) {
+				nextCache.push_back(v);
+			}
+		}
+
+		// Vertices pushed past the end lose their cache score, everything else gets rescored
+		// Triangle scores are summed on demand below, only triangles touching the cache are candidates
+		for (size_t i = 0; i < nextCache.size(); i++) {
+			uint32_t v = nextCache[i];
+			cachePosition[v] = i < (size_t)forsythCacheSize ? (int)i : -1;
+			score[v] = vertexScore(cachePosition[v], valence[v]);
+		}
+		if (nextCache.size() > (size_t)forsythCacheSize) {
+			nextCache.resize(forsythCacheSize);
+		}
+		cache.swap(nextCache);
+
+		best = -1;
+		float bestScore = -1.0f;
+		for (uint32_t v : cache) {
+			for (uint32_t a = 0; a < valence[v]; a++) {
+				uint32_t adjacent = adjacency[adjacencyOffset[v] + a];
+				const uint32_t* tri = &indices[adjacent * 3];
+				float triangleScore = score[tri[0]] + score[tri[1]] + score[tri[2]];
+				if (triangleScore > bestScore) {
+					bestScore = triangleScore;
+					best = adjacent;
+				}
+			}
+		}
+	}
+	indices = std::move(out);
+}
+
+void optimizeOverdraw(std::vector<uint32_t>& indices, std::span<const DefaultVertex> vertices, size_t cacheSize)
+{
+	size_t triangles = indices.size() / 3;
+	if (triangles == 0) {
+		return;
+	}
+
+	std::vector<size_t> clusterStart;
+	std::vector<size_t> entered(vertices.size(), SIZE_MAX);
+	size_t misses = 0;
+	for (size_t t = 0; t < triangles; t++) {
+		int triangleMisses = 0;
+		for (int k = 0; k < 3; k++) {
+			uint32_t v = indices[t * 3 + k];
+			if (entered[v] == SIZE_MAX || misses - entered[v] >= cacheSize) {
+				entered[v] = misses++;
+				triangleMisses++;
+			}
+		}
+		if (t == 0 || triangleMisses == 3) {
+			clusterStart.push_back(t);
+		}
+	}
+	clusterStart.push_back(triangles);
+	size_t clusters = clusterStart.size() - 1;
+
+	// Area weighted centroid and normal per cluster, clusters facing away from the mesh center are likely in front
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+	std::vector<glm::vec3> centroid(clusters, glm::vec3(0.0f));
+	std::vector<glm::vec3> normal(clusters, glm::vec3(0.0f));
+	std::vector<float> area(clusters, 0.0f);
+	for (size_t c = 0; c < clusters; c++) {
+		for (size_t t = clusterStart[c]; t < clusterStart[c + 1]; t++) {
+			glm::vec3 a = vertices[indices[t * 3]].pos;
+			glm::vec3 b = vertices[indices[t * 3 + 1]].pos;
+			glm::vec3 d = vertices[indices[t * 3 + 2]].pos;
+			glm::vec3 n = glm::cross(b - a, d - a);
+			float triangleArea = glm::length(n) * 0.5f;
+			centroid[c] += (a + b + d) / 3.0f * triangleArea;
+			normal[c] += n;
+			area[c] += triangleArea;
+		}
+		meshCentroid += centroid[c];
+		meshArea += area[c];
+		if (area[c] > 0.0f) {
+			centroid[c] /= area[c];
+		}
+	}
+	if (meshArea > 0.0f) {
+		meshCentroid /= meshArea;
+	}
+
+	std::vector<float> sortKey(clusters);
+	for (size_t c = 0; c < clusters; c++) {
+		float length = glm::length(normal[c]);
+		sortKey[c] = length > 0.0f ? glm::dot(centroid[c] - meshCentroid, normal[c] / length) : 0.0f;
+	}
+	std::vector<size_t> order(clusters);
+	for (size_t c = 0; c < clusters; c++) {
+		order[c] = c;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sortKey[a] > sortKey[b]; });
+
+	std::vector<uint32_t> out;
+	out.reserve(indices.size());
+	for (size_t c : order) {
+		out.insert(out.end(), indices.begin() + clusterStart[c] * 3, indices.begin() + clusterStart[c + 1] * 3);
+	}
+	indices = std::move(out);
+}
+
+void optimizeVertexFetch(MeshData& mesh)
+{
+	std::vector<uint32_t> remap(mesh.vertices.size(), UINT32_MAX);
+	std::vector<DefaultVertex> vertices;
+	vertices.reserve(mesh.vertices.size());
+	for (uint32_t& i : mesh.indices) {
+		if (remap[i] == UINT32_MAX) {
+			remap[i] = (uint32_t)vertices.size();
+			vertices.push_back(mesh.vertices[i]);
+		}
+		i = remap[i];
+	}
+	mesh.vertices = std::move(vertices);
+}
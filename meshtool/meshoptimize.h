@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "meshformat.h"
+
+// Post transform cache statistics of an index sequence replayed through a FIFO cache
+// ACMR: vertices transformed per triangle (0.5 ideal for large regular grids, 3 worst)
+// ATVR: vertices transformed per unique vertex (1 ideal)
+struct CacheStats {
+	float acmr;
+	float atvr;
+};
+
+CacheStats analyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, size_t cacheSize);
+
+// Merges bitwise identical vertices, returns how many were removed
+size_t deduplicateVertices(MeshData& mesh);
+
+// Reorders triangles for post transform cache reuse (Forsyth, linear speed vertex cache optimisation)
+void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+// Reorders the clusters of a cache optimised sequence so outward facing clusters draw first,
+// a view independent overdraw reduction in the spirit of Sander et al. (tipsify)
+// A new cluster starts wherever the cache order jumped, i.e. a triangle misses on all three vertices
+void optimizeOverdraw(std::vector<uint32_t>& indices, std::span<const DefaultVertex> vertices, size_t cacheSize);
+
+// Renumbers vertices in first use order so fetches walk the vertex buffer linearly, unused vertices are dropped
+void optimizeVertexFetch(MeshData& mesh);
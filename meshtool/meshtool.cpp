@@ -0,0 +1,65 @@
+// meshtool : Offline mesh optimisation, converts OBJ assets into the binary format loaded by the game (meshformat.h)
+//
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+
+#include "meshformat.h"
+#include "meshoptimize.h"
+#include "meshlets.h"
+#include "objloader.h"
+
+// Typical post transform FIFO size the statistics and cluster splitting assume
+static constexpr size_t defaultCacheSize = 16;
+
+static size_t removeDegenerateTriangles(MeshData& mesh)
+{
+	size_t kept = 0;
+	for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3) {
+		uint32_t a = mesh.indices[t], b = mesh.indices[t + 1], c = mesh.indices[t + 2];
+		if (a != b && b != c && a != c) {
+			mesh.indices[kept++] = a;
+			mesh.indices[kept++] = b;
+			mesh.indices[kept++] = c;
+		}
+	}
+	size_t removed = (mesh.indices.size() - kept) / 3;
+	mesh.indices.resize(kept);
+	return removed;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3) {
+		fprintf(stderr, "usage: meshtool <input.obj> <output.gmesh> [cache size]\n");
+		return 1;
+	}
+	std::string input = argv[1];
+	std::string output = argv[2];
+	size_t cacheSize = argc > 3 ? (size_t)std::atoi(argv[3]) : defaultCacheSize;
+
+	try {
+		MeshData mesh = loadObj(input);
+		size_t corners = mesh.vertices.size();
+		deduplicateVertices(mesh);
+		size_t degenerate = removeDegenerateTriangles(mesh);
+		CacheStats before = analyzeVertexCache(mesh.indices, mesh.vertices.size(), cacheSize);
+
+		optimizeVertexCache(mesh.indices, mesh.vertices.size());
+		optimizeOverdraw(mesh.indices, mesh.vertices, cacheSize);
+		optimizeVertexFetch(mesh);
+		CacheStats after = analyzeVertexCache(mesh.indices, mesh.vertices.size(), cacheSize);
+		buildMeshlets(mesh);
+
+		writeMeshFile(output, mesh);
+		printf("%s: %zu triangles, %zu -> %zu vertices (%zu degenerate triangles dropped), %d bit indices\n",
+			input.c_str(), mesh.indices.size() / 3, corners, mesh.vertices.size(), degenerate, fitsIndex16(mesh.vertices.size()) ? 16 : 32);
+		printf("  FIFO %zu: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", cacheSize, before.acmr, after.acmr, before.atvr, after.atvr);
+		printf("  %zu meshlets, %.1f triangles each\n", mesh.meshlets.size(), mesh.meshlets.empty() ? 0.0 : (double)mesh.indices.size() / 3.0 / (double)mesh.meshlets.size());
+	} catch (const std::exception& e) {
+		fprintf(stderr, "%s: %s\n", input.c_str(), e.what());
+		return 1;
+	}
+	return 0;
+}
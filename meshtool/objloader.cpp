@@ -0,0 +1,95 @@
+#include "objloader.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <glm/glm.hpp>
+
+// OBJ indices are 1 based, negative ones count back from the end
+static int resolveIndex(int index, size_t count)
+{
+	return index < 0 ? (int)count + index : index - 1;
+}
+
+MeshData loadObj(const std::string& path)
+{
+	std::ifstream in(path);
+	if (!in) {
+		throw std::runtime_error("Cannot open " + path);
+	}
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> colors;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec3> smoothNormals;
+	// Output vertices waiting for their position's smooth normal
+	std::vector<std::pair<uint32_t, int>> unnormaled;
+	MeshData mesh;
+	std::string line;
+	while (std::getline(in, line)) {
+		std::istringstream s(line);
+		std::string type;
+		s >> type;
+		if (type == "v") {
+			glm::vec3 p(0.0f), c(1.0f);
+			s >> p.x >> p.y >> p.z;
+			if (!(s >> c.r >> c.g >> c.b)) {
+				c = glm::vec3(1.0f);
+			}
+			positions.push_back(p);
+			colors.push_back(c);
+			smoothNormals.push_back(glm::vec3(0.0f));
+		} else if (type == "vn") {
+			glm::vec3 n(0.0f);
+			s >> n.x >> n.y >> n.z;
+			normals.push_back(n);
+		} else if (type == "f") {
+			struct Corner {
+				int position;
+				int normal;
+			};
+			std::vector<Corner> corners;
+			std::string corner;
+			while (s >> corner) {
+				// v, v/vt, v//vn or v/vt/vn
+				Corner c = { resolveIndex(std::stoi(corner), positions.size()), -1 };
+				size_t slash = corner.find('/');
+				if (slash != std::string::npos) {
+					size_t second = corner.find('/', slash + 1);
+					if (second != std::string::npos && second + 1 < corner.size()) {
+						c.normal = resolveIndex(std::stoi(corner.substr(second + 1)), normals.size());
+					}
+				}
+				if (c.position < 0 || c.position >= (int)positions.size() || c.normal >= (int)normals.size()) {
+					throw std::runtime_error("Bad face index in " + path);
+				}
+				corners.push_back(c);
+			}
+
+			for (size_t i = 1; i + 1 < corners.size(); i++) {
+				const Corner* tri[3] = { &corners[0], &corners[i], &corners[i + 1] };
+				// Unnormalized, its length is twice the area which weights the smooth normals
+				glm::vec3 faceNormal = glm::cross(positions[tri[1]->position] - positions[tri[0]->position], positions[tri[2]->position] - positions[tri[0]->position]);
+				for (const Corner* c : tri) {
+					smoothNormals[c->position] += faceNormal;
+					if (c->normal < 0) {
+						unnormaled.push_back({ (uint32_t)mesh.vertices.size(), c->position });
+					}
+					mesh.indices.push_back((uint32_t)mesh.vertices.size());
+					mesh.vertices.push_back({
+						.pos = positions[c->position],
+						.normal = c->normal >= 0 ? normals[c->normal] : glm::vec3(0.0f),
+						.color = colors[c->position],
+					});
+				}
+			}
+		}
+	}
+
+	for (auto [vertex, position] : unnormaled) {
+		float length = glm::length(smoothNormals[position]);
+		mesh.vertices[vertex].normal = length > 0.0f ? smoothNormals[position] / length : glm::vec3(0.0f, 1.0f, 0.0f);
+	}
+	return mesh;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <string>
+
+#include "meshformat.h"
+
+// Wavefront OBJ positions, normals and optional per vertex colors ("v x y z r g b"), polygons are fan triangulated
+// Corners without normals get the area weighted average of the faces around their position
+// Vertices are not shared until deduplicateVertices runs
+MeshData loadObj(const std::string& path);